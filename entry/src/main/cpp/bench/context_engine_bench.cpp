@@ -0,0 +1,757 @@
+/**
+ * context_engine_bench.cpp — 规则引擎 host 基准测试
+ *
+ * Builds synthetic rule sets (100 ~ 50k rules, mixed eq/in/range/temporal),
+ * replays a realistic context stream with interleaved events, and reports:
+ *   - loadRules time (rule copy + compileTree)
+ *   - evaluate p50 / p99 / mean latency
+ *   - heap allocations per evaluate call
+ *   - pushEvent cost
+ *   - built-in rule pack load time
+ *   - parallel evaluate throughput: shared engine vs one engine per thread
+ *   - LinUCB select / update throughput
+ *
+ * Usage: context_engine_bench [--quick] [--seed N] [--sizes 100,1000,...]
+ */
+#include "context_engine.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <climits>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+#include <unistd.h>
+
+// ============================================================
+// Allocation counting (global operator new override)
+// ============================================================
+
+static std::atomic<uint64_t> g_allocCount{0};
+
+// Every replacement form goes through these two out-of-line functions: an inlined
+// operator delete would otherwise show up as a bare free() on a pointer from operator new
+// (-Wmismatched-new-delete)
+[[gnu::noinline]] static void* countedAlloc(std::size_t n) noexcept {
+    g_allocCount.fetch_add(1, std::memory_order_relaxed);
+    return std::malloc(n ? n : 1);
+}
+[[gnu::noinline]] static void countedFree(void* p) noexcept { std::free(p); }
+
+void* operator new(std::size_t n) {
+    if (void* p = countedAlloc(n)) return p;
+    throw std::bad_alloc();
+}
+void* operator new[](std::size_t n) {
+    if (void* p = countedAlloc(n)) return p;
+    throw std::bad_alloc();
+}
+void* operator new(std::size_t n, const std::nothrow_t&) noexcept { return countedAlloc(n); }
+void* operator new[](std::size_t n, const std::nothrow_t&) noexcept { return countedAlloc(n); }
+void operator delete(void* p) noexcept { countedFree(p); }
+void operator delete[](void* p) noexcept { countedFree(p); }
+void operator delete(void* p, std::size_t) noexcept { countedFree(p); }
+void operator delete[](void* p, std::size_t) noexcept { countedFree(p); }
+void operator delete(void* p, const std::nothrow_t&) noexcept { countedFree(p); }
+void operator delete[](void* p, const std::nothrow_t&) noexcept { countedFree(p); }
+
+namespace {
+
+using namespace context_engine;
+using Clock = std::chrono::steady_clock;
+
+int64_t elapsedNs(Clock::time_point start) {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count();
+}
+
+int64_t steadyNowMs() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        Clock::now().time_since_epoch()).count();
+}
+
+// ============================================================
+// Synthetic vocabulary (mirrors the keys ArkTS writes into the tray)
+// ============================================================
+
+struct CategoricalKey {
+    const char* key;
+    std::vector<std::string> values;
+};
+
+const std::vector<CategoricalKey>& categoricalKeys() {
+    static const std::vector<CategoricalKey> keys = {
+        {"timeOfDay", {"morning", "afternoon", "evening", "night"}},
+        {"isWeekend", {"true", "false"}},
+        {"motionState", {"stationary", "walking", "running", "driving", "transit"}},
+        {"geofence", {"home", "work", "gym", "school", "mall", "station"}},
+        {"networkType", {"wifi", "cellular", "none"}},
+        {"isCharging", {"true", "false"}},
+        {"dayOfWeek", {"0", "1", "2", "3", "4", "5", "6"}},
+    };
+    return keys;
+}
+
+const std::vector<std::string>& eventTypes() {
+    static const std::vector<std::string> types = {
+        "geofence_enter", "geofence_exit", "app_open", "motion_change",
+        "charger_connected", "wifi_connected", "screen_on",
+    };
+    return types;
+}
+
+std::string timeOfDayFor(int hour) {
+    if (hour >= 5 && hour < 12) return "morning";
+    if (hour >= 12 && hour < 17) return "afternoon";
+    if (hour >= 17 && hour < 21) return "evening";
+    return "night";
+}
+
+// ============================================================
+// Synthetic rule sets
+// ============================================================
+
+std::vector<Rule> makeRules(size_t count, std::mt19937& rng) {
+    const auto& cats = categoricalKeys();
+    const auto& events = eventTypes();
+    std::uniform_real_distribution<double> unit(0.0, 1.0);
+    std::uniform_int_distribution<int> nConds(2, 5);
+
+    std::vector<Rule> rules;
+    rules.reserve(count);
+    for (size_t i = 0; i < count; i++) {
+        Rule rule;
+        rule.id = "rule_" + std::to_string(i);
+        rule.name = "synthetic " + std::to_string(i);
+        rule.priority = 0.5 + std::floor(unit(rng) * 25.0) / 10.0;  // 0.5 ~ 3.0
+        rule.cooldownMs = 0;
+        rule.enabled = true;
+
+        std::vector<bool> usedCat(cats.size(), false);
+        int n = nConds(rng);
+        for (int c = 0; c < n; c++) {
+            double kind = unit(rng);
+            Condition cond;
+            if (kind < 0.60) {
+                // Categorical eq / in (70 / 30)
+                size_t k = rng() % cats.size();
+                if (usedCat[k]) continue;
+                usedCat[k] = true;
+                const auto& vals = cats[k].values;
+                cond.key = cats[k].key;
+                if (unit(rng) < 0.7 || vals.size() < 3) {
+                    cond.op = "eq";
+                    cond.value = vals[rng() % vals.size()];
+                } else {
+                    cond.op = "in";
+                    size_t a = rng() % vals.size();
+                    size_t b = (a + 1 + rng() % (vals.size() - 1)) % vals.size();
+                    cond.value = vals[a] + "," + vals[b];
+                }
+            } else if (kind < 0.85) {
+                // Numeric lte / gte / range
+                double which = unit(rng);
+                if (which < 0.4) {
+                    cond.key = "batteryLevel";
+                    cond.op = unit(rng) < 0.5 ? "lte" : "gte";
+                    cond.value = std::to_string(10 + rng() % 80);
+                } else if (which < 0.8) {
+                    int lo = static_cast<int>(rng() % 20);
+                    cond.key = "hour";
+                    cond.op = "range";
+                    cond.value = std::to_string(lo) + "," + std::to_string(lo + 1 + rng() % 4);
+                } else {
+                    cond.key = "stepCount";
+                    cond.op = "gte";
+                    cond.value = std::to_string(1000 * (1 + rng() % 10));
+                }
+            } else {
+                // Temporal recent / within
+                const auto& a = events[rng() % events.size()];
+                if (unit(rng) < 0.75) {
+                    cond.key = "event:" + a;
+                    cond.op = "recent";
+                    cond.value = std::to_string(60000 * (1 + rng() % 30));
+                } else {
+                    const auto& b = events[rng() % events.size()];
+                    cond.key = "sequence:" + a + "," + b;
+                    cond.op = "within";
+                    cond.value = std::to_string(60000 * (5 + rng() % 55));
+                }
+            }
+            rule.conditions.push_back(std::move(cond));
+        }
+
+        rule.action.id = "action_" + std::to_string(i % 97);
+        rule.action.type = (i % 3 == 0) ? "notification" : "suggestion";
+        rule.action.payload = "payload " + std::to_string(i);
+        rules.push_back(std::move(rule));
+    }
+    return rules;
+}
+
+// ============================================================
+// Realistic context stream (simulated day with sensor drift)
+// ============================================================
+
+class ContextStream {
+public:
+    explicit ContextStream(uint32_t seed) : rng_(seed) {}
+
+    ContextMap next() {
+        minuteOfWeek_ = (minuteOfWeek_ + 1 + rng_() % 5) % (7 * 24 * 60);
+        int day = minuteOfWeek_ / (24 * 60);
+        int hour = (minuteOfWeek_ / 60) % 24;
+        int minute = minuteOfWeek_ % 60;
+
+        // Battery drains, charges at night
+        charging_ = (hour >= 23 || hour < 7) && geofence_ == "home";
+        battery_ += charging_ ? 2 : -((rng_() % 4) == 0 ? 1 : 0);
+        battery_ = std::max(1, std::min(100, battery_));
+
+        // Motion: sticky Markov chain
+        static const char* motions[] = {"stationary", "walking", "running", "driving", "transit"};
+        if (rng_() % 8 == 0) motion_ = motions[rng_() % 5];
+        if (motion_ == std::string("walking") || motion_ == std::string("running")) {
+            steps_ += 20 + rng_() % 120;
+        }
+        if (hour == 0 && minute < 5) steps_ = 0;
+
+        // Geofence follows the daily routine
+        bool weekend = (day == 0 || day == 6);
+        if (hour < 8 || hour >= 19) geofence_ = "home";
+        else if (!weekend && hour >= 9 && hour < 18) geofence_ = "work";
+        else if (rng_() % 10 == 0) geofence_ = (rng_() % 2) ? "gym" : "mall";
+
+        ContextMap ctx;
+        ctx["hour"] = std::to_string(hour);
+        ctx["minute"] = std::to_string(minute);
+        ctx["timeOfDay"] = timeOfDayFor(hour);
+        ctx["dayOfWeek"] = std::to_string(day);
+        ctx["isWeekend"] = weekend ? "true" : "false";
+        ctx["batteryLevel"] = std::to_string(battery_);
+        ctx["isCharging"] = charging_ ? "true" : "false";
+        ctx["motionState"] = motion_;
+        ctx["geofence"] = geofence_;
+        ctx["networkType"] = (geofence_ == "home" || geofence_ == "work") ? "wifi" : "cellular";
+        ctx["stepCount"] = std::to_string(steps_);
+        ctx["latitude"] = "31.2" + std::to_string(rng_() % 1000);
+        ctx["longitude"] = "121.4" + std::to_string(rng_() % 1000);
+        return ctx;
+    }
+
+    ContextEvent nextEvent(const ContextMap& ctx) {
+        const auto& types = eventTypes();
+        ContextEvent ev;
+        ev.context = ctx;
+        ev.timestampMs = steadyNowMs();
+        ev.eventType = types[rng_() % types.size()];
+        return ev;
+    }
+
+private:
+    std::mt19937 rng_;
+    int minuteOfWeek_ = 8 * 60;
+    int battery_ = 80;
+    bool charging_ = false;
+    int steps_ = 0;
+    std::string motion_ = "stationary";
+    std::string geofence_ = "home";
+};
+
+// ============================================================
+// Statistics helpers
+// ============================================================
+
+struct LatencyStats {
+    double p50Us;
+    double p99Us;
+    double meanUs;
+};
+
+LatencyStats summarize(std::vector<int64_t>& samplesNs) {
+    LatencyStats s{0, 0, 0};
+    if (samplesNs.empty()) return s;
+    std::sort(samplesNs.begin(), samplesNs.end());
+    auto at = [&](double q) {
+        size_t idx = static_cast<size_t>(q * (samplesNs.size() - 1));
+        return samplesNs[idx] / 1000.0;
+    };
+    double sum = 0;
+    for (auto v : samplesNs) sum += v;
+    s.p50Us = at(0.50);
+    s.p99Us = at(0.99);
+    s.meanUs = sum / samplesNs.size() / 1000.0;
+    return s;
+}
+
+struct Options {
+    bool quick = false;
+    uint32_t seed = 42;
+    std::vector<size_t> sizes = {100, 1000, 10000, 50000};
+};
+
+Options parseArgs(int argc, char** argv) {
+    Options opt;
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--quick") == 0) {
+            opt.quick = true;
+        } else if (std::strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+            opt.seed = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+        } else if (std::strcmp(argv[i], "--sizes") == 0 && i + 1 < argc) {
+            opt.sizes.clear();
+            const char* p = argv[++i];
+            while (*p) {
+                char* end = nullptr;
+                unsigned long v = std::strtoul(p, &end, 10);
+                if (end == p) break;
+                if (v > 0) opt.sizes.push_back(v);
+                p = (*end == ',') ? end + 1 : end;
+            }
+        }
+    }
+    return opt;
+}
+
+// ============================================================
+// Benchmarks
+// ============================================================
+
+struct EvalRun {
+    LatencyStats latency;
+    double allocsPerEval;
+    double rulesPerEval;
+    double condsPerRule;       // condition uses per scored rule (computed + memoized)
+    double computedPerEval;    // distinct condition matches actually computed
+    double boundStopRate;      // share of evaluations ended by branch-and-bound
+    double budgetStopRate;     // share of evaluations ended by the time budget
+};
+
+/** Replay `iterations` contexts (with interleaved events) through evaluate */
+EvalRun runEvaluate(RuleEngine& engine, uint32_t streamSeed, int iterations, int64_t budgetUs = 0) {
+    ContextStream stream(streamSeed);
+    int warmup = iterations / 10;
+
+    std::vector<int64_t> samples;
+    samples.reserve(iterations);
+    uint64_t allocs = 0;
+
+    for (int i = 0; i < warmup + iterations; i++) {
+        ContextMap ctx = stream.next();
+        if (i % 5 == 0) engine.pushEvent(stream.nextEvent(ctx));
+        if (i == warmup) engine.resetEvalStats();
+
+        uint64_t allocBefore = g_allocCount.load(std::memory_order_relaxed);
+        auto start = Clock::now();
+        auto results = engine.evaluate(ctx, 5, budgetUs);
+        int64_t ns = elapsedNs(start);
+        uint64_t allocAfter = g_allocCount.load(std::memory_order_relaxed);
+
+        if (i >= warmup) {
+            samples.push_back(ns);
+            allocs += allocAfter - allocBefore;
+        }
+    }
+
+    EvalStats stats = engine.evalStats();
+    EvalRun run;
+    run.latency = summarize(samples);
+    run.allocsPerEval = static_cast<double>(allocs) / iterations;
+    run.rulesPerEval = stats.evaluations > 0
+        ? static_cast<double>(stats.rulesEvaluated) / stats.evaluations : 0.0;
+    run.condsPerRule = stats.rulesEvaluated > 0
+        ? static_cast<double>(stats.conditionsEvaluated + stats.memoHits) / stats.rulesEvaluated : 0.0;
+    run.computedPerEval = stats.evaluations > 0
+        ? static_cast<double>(stats.conditionsEvaluated) / stats.evaluations : 0.0;
+    run.boundStopRate = stats.evaluations > 0
+        ? static_cast<double>(stats.boundStops) / stats.evaluations : 0.0;
+    run.budgetStopRate = stats.evaluations > 0
+        ? static_cast<double>(stats.budgetStops) / stats.evaluations : 0.0;
+    return run;
+}
+
+void printEvalRow(size_t size, const char* mode, double compileMs, const EvalRun& run) {
+    std::printf("%8zu %-9s %12.2f %10.2f %10.2f %10.2f %12.1f %10.1f %10.2f %12.1f\n",
+                size, mode, compileMs, run.latency.p50Us, run.latency.p99Us,
+                run.latency.meanUs, run.allocsPerEval, run.rulesPerEval, run.condsPerRule,
+                run.computedPerEval);
+}
+
+void benchRuleEngine(const Options& opt) {
+    std::printf("\n== RuleEngine ==\n");
+    std::printf("%8s %-9s %12s %10s %10s %10s %12s %10s %10s %12s\n", "rules", "mode",
+                "compile(ms)", "p50(us)", "p99(us)", "mean(us)", "allocs/eval", "rules/eval",
+                "conds/rule", "computed/eval");
+
+    for (size_t size : opt.sizes) {
+        std::mt19937 rng(opt.seed);
+        auto rules = makeRules(size, rng);
+
+        RuleEngine engine;
+        RateLimits limits;
+        limits.categoryCooldownCount = INT_MAX;  // keep every evaluate doing full work
+        limits.globalMaxPerHour = INT_MAX;
+        engine.setLimits(limits);
+
+        // Scale iterations down for large rule sets so a full run stays ~1 min
+        int iterations = static_cast<int>(std::max<size_t>(100, std::min<size_t>(3000, 2000000 / size)));
+        if (opt.quick) iterations = std::max(30, iterations / 10);
+
+        // Static tree: loadRules = rule copy + compileTree
+        auto loadStart = Clock::now();
+        engine.loadRules(rules);
+        double loadMs = elapsedNs(loadStart) / 1e6;
+        printEvalRow(size, "static", loadMs, runEvaluate(engine, opt.seed + 1, iterations));
+        std::printf("%8s distinct conditions: %zu\n", "", engine.sharedConditionCount());
+
+        // Profile-guided tree, shaped by the traffic just replayed
+        auto recompileStart = Clock::now();
+        engine.recompileWithProfile();
+        double recompileMs = elapsedNs(recompileStart) / 1e6;
+        printEvalRow(size, "profiled", recompileMs, runEvaluate(engine, opt.seed + 1, iterations));
+
+        // Bitmap index: built from the loaded rules on switch
+        auto bitmapStart = Clock::now();
+        engine.setEvalMode(EvalMode::Bitmap);
+        double bitmapMs = elapsedNs(bitmapStart) / 1e6;
+        EvalRun bitmapRun = runEvaluate(engine, opt.seed + 1, iterations);
+        printEvalRow(size, "bitmap", bitmapMs, bitmapRun);
+        std::printf("%8s branch-and-bound stopped %.0f%% of evaluations early\n", "",
+                    bitmapRun.boundStopRate * 100.0);
+
+        // Same, capped by a 1 ms latency budget (best-so-far results)
+        EvalRun budgetRun = runEvaluate(engine, opt.seed + 1, iterations, 1000);
+        printEvalRow(size, "budget1ms", 0.0, budgetRun);
+        std::printf("%8s budget hit in %.0f%% of evaluations\n", "", budgetRun.budgetStopRate * 100.0);
+
+        // Incremental addRule (the tree modes recompile fully: see compile column)
+        Rule extra = makeRules(1, rng)[0];
+        extra.id = "rule_extra";
+        auto addStart = Clock::now();
+        engine.addRule(extra);
+        std::printf("%8s bitmap addRule: %.2f ms\n", "", elapsedNs(addStart) / 1e6);
+
+        // Wakeup computation the app runs after each evaluate
+        ContextStream deadlineStream(opt.seed + 3);
+        std::vector<int64_t> deadlineNs;
+        for (int i = 0; i < 50; i++) {
+            ContextMap ctx = deadlineStream.next();
+            auto start = Clock::now();
+            engine.nextEvaluationDeadline(ctx);
+            deadlineNs.push_back(elapsedNs(start));
+        }
+        std::printf("%8s nextEvaluationDeadline: p50 %.2f us\n", "", summarize(deadlineNs).p50Us);
+    }
+}
+
+/** Heap bytes of a ContextEvent held in a std::deque (libstdc++ layout estimate) */
+double contextEventBytes(const ContextEvent& ev) {
+    auto heapString = [](const std::string& str) { return str.size() > 15 ? str.capacity() + 1 : 0; };
+    double bytes = sizeof(ContextEvent) + heapString(ev.eventType);
+    bytes += ev.context.bucket_count() * sizeof(void*);
+    for (const auto& [key, value] : ev.context) {
+        // node: next pointer + pair<string,string> + cached hash
+        bytes += sizeof(void*) + 2 * sizeof(std::string) + sizeof(size_t);
+        bytes += heapString(key) + heapString(value);
+    }
+    return bytes;
+}
+
+void benchEventBuffer(const Options& opt) {
+    std::printf("\n== EventBuffer ==\n");
+    RuleEngine engine;
+    ContextStream stream(opt.seed + 2);
+    int iterations = opt.quick ? 2000 : 20000;
+
+    std::vector<ContextEvent> events;
+    events.reserve(iterations);
+    for (int i = 0; i < iterations; i++) events.push_back(stream.nextEvent(stream.next()));
+
+    uint64_t allocBefore = g_allocCount.load(std::memory_order_relaxed);
+    auto start = Clock::now();
+    for (const auto& ev : events) engine.pushEvent(ev);
+    int64_t ns = elapsedNs(start);
+    uint64_t allocs = g_allocCount.load(std::memory_order_relaxed) - allocBefore;
+
+    std::printf("pushEvent: %.1f ns/op, %.1f allocs/op\n",
+                static_cast<double>(ns) / iterations,
+                static_cast<double>(allocs) / iterations);
+
+    // Footprint: columnar ring vs. what a deque<ContextEvent> copy would hold,
+    // at a typical fill (a few hours of events) and with the whole stream pushed
+    auto footprint = [&events](size_t n, EventBuffer& buffer) {
+        for (size_t i = 0; i < n; i++) buffer.push(events[i]);
+        size_t retained = buffer.size();
+        double copyBytes = 0.0;
+        for (size_t i = n - retained; i < n; i++) copyBytes += contextEventBytes(events[i]);
+        std::printf("memory: %.1f bytes/event columnar (%zu events, %.1f KB) vs "
+                    "%.1f bytes/event as ContextEvent copies (%.1fx)\n",
+                    static_cast<double>(buffer.memoryBytes()) / retained, retained,
+                    buffer.memoryBytes() / 1024.0, copyBytes / retained,
+                    copyBytes / static_cast<double>(buffer.memoryBytes()));
+    };
+    if (events.size() > 2000) {
+        EventBuffer typical;
+        footprint(2000, typical);
+    }
+    EventBuffer buffer;
+    footprint(events.size(), buffer);
+    size_t retained = buffer.size();
+
+    // Oldest contexts may be evicted once the arena wraps; those decode as empty
+    size_t identical = 0, evicted = 0;
+    for (size_t i = 0; i < retained; i++) {
+        ContextMap ctx = buffer.contextAt(i);
+        if (ctx == events[events.size() - retained + i].context) identical++;
+        else if (ctx.empty()) evicted++;
+    }
+    std::printf("context round-trip: %zu/%zu identical, %zu evicted, %zu corrupt\n",
+                identical, retained, evicted, retained - identical - evicted);
+
+    // Windowed counters: every event was pushed moments ago, so each window sees them all
+    std::unordered_map<std::string, int64_t> perType;
+    for (const auto& ev : events) perType[ev.eventType]++;
+    const int64_t windows[] = {60000, 3600000, 86400000};
+    int queries = 0;
+    size_t countErrors = 0;
+    start = Clock::now();
+    for (int rep = 0; rep < 100; rep++) {
+        for (const auto& [type, expected] : perType) {
+            for (int64_t window : windows) {
+                if (buffer.countWithin(type, window) != expected) countErrors++;
+                queries++;
+            }
+        }
+    }
+    ns = elapsedNs(start);
+    std::printf("countWithin: %.1f ns/op over 60 s / 1 h / 24 h windows, %zu wrong counts\n",
+                static_cast<double>(ns) / queries, countErrors);
+}
+
+void benchRulePacks(const Options& opt) {
+    std::printf("\n== Built-in rule packs ==\n");
+    const RulePack* pack = findRulePack("default");
+    if (pack == nullptr) {
+        std::printf("no \"default\" pack compiled in\n");
+        return;
+    }
+    int reps = opt.quick ? 20 : 200;
+    RuleEngine engine;
+    auto start = Clock::now();
+    for (int i = 0; i < reps; i++) engine.loadRulePack(*pack);
+    double us = static_cast<double>(elapsedNs(start)) / reps / 1000.0;
+    std::printf("default: %zu rules, %zu conditions, %zu keys; loadRulePack %.1f us\n",
+                pack->ruleCount, pack->conditionCount, pack->keyCount, us);
+
+    // A device overlay: the {{place}} geofence rules bound, one user rule appended,
+    // one pack rule removed — patched into the pre-built tree vs compiled from scratch
+    auto merged = packRules(*pack);
+    std::vector<Rule> overlay;
+    for (auto& rule : merged) {
+        bool bound = false;
+        for (auto& cond : rule.conditions) {
+            if (cond.value.str().find("{{") == std::string::npos) continue;
+            cond.value = "geo_" + cond.value.str().substr(2, cond.value.size() - 4);
+            bound = true;
+        }
+        if (bound) overlay.push_back(rule);
+    }
+    Rule user = merged.front();
+    user.id = "user_bench";
+    user.conditions.push_back({"motionState", "eq", "walking"});
+    overlay.push_back(user);
+    merged.push_back(user);
+    std::vector<std::string> removed{merged[1].id};
+    merged.erase(merged.begin() + 1);
+
+    start = Clock::now();
+    for (int i = 0; i < reps; i++) engine.loadRulePack(*pack, overlay, removed);
+    double patchedUs = static_cast<double>(elapsedNs(start)) / reps / 1000.0;
+    RuleEngine compiled;
+    start = Clock::now();
+    for (int i = 0; i < reps; i++) compiled.loadRules(merged);
+    double compiledUs = static_cast<double>(elapsedNs(start)) / reps / 1000.0;
+
+    // Same results on contexts drawn from the pack's own condition values. Every key is
+    // set: with a key missing, tree mode prunes by split shape (as profile-guided trees do)
+    RateLimits unlimited{INT_MAX, 0, INT_MAX};
+    engine.setLimits(unlimited);
+    compiled.setLimits(unlimited);
+    std::unordered_map<std::string, std::vector<std::string>> values;
+    for (const auto& rule : merged) {
+        for (const auto& cond : rule.conditions) values[cond.key].push_back(cond.value);
+    }
+    std::mt19937 rng(opt.seed + 6);
+    size_t mismatches = 0, fired = 0;
+    int contexts = opt.quick ? 1000 : 5000;
+    for (int c = 0; c < contexts; c++) {
+        ContextMap ctx;
+        for (const auto& [key, keyValues] : values) {
+            ctx[key] = keyValues[rng() % keyValues.size()];
+        }
+        auto a = engine.evaluate(ctx, 5);
+        auto b = compiled.evaluate(ctx, 5);
+        bool same = a.size() == b.size();
+        for (size_t i = 0; same && i < a.size(); i++) same = a[i].ruleId == b[i].ruleId;
+        if (!same) mismatches++;
+        if (!a.empty() || !b.empty()) {
+            // Reload to clear rule cooldowns, so every context is compared on all rules
+            fired++;
+            engine.loadRulePack(*pack, overlay, removed);
+            compiled.loadRules(merged);
+        }
+    }
+    std::printf("default + %zu overlay rules, 1 removed: patched %.1f us, compiled %.1f us (%.1fx), "
+                "%zu / %d contexts differ (%zu fired)\n", overlay.size(), patchedUs, compiledUs,
+                compiledUs / patchedUs, mismatches, contexts, fired);
+}
+
+/** Total evaluate throughput of `threads` threads, each on engines[t % engines.size()] */
+double parallelEvalsPerSec(std::vector<std::unique_ptr<RuleEngine>>& engines, int threads,
+                           const std::vector<ContextMap>& contexts) {
+    std::vector<std::thread> workers;
+    auto start = Clock::now();
+    for (int t = 0; t < threads; t++) {
+        workers.emplace_back([&, t] {
+            RuleEngine& engine = *engines[t % engines.size()];
+            for (const auto& ctx : contexts) engine.evaluate(ctx, 5);
+        });
+    }
+    for (auto& w : workers) w.join();
+    double seconds = static_cast<double>(elapsedNs(start)) / 1e9;
+    return static_cast<double>(threads) * contexts.size() / seconds;
+}
+
+void benchInstances(const Options& opt) {
+    std::printf("\n== Engine instances ==\n");
+    const int threads = 4;
+    unsigned cores = std::thread::hardware_concurrency();
+    std::mt19937 rng(opt.seed + 4);
+    auto rules = makeRules(1000, rng);
+    ContextStream stream(opt.seed + 5);
+    std::vector<ContextMap> contexts(opt.quick ? 500 : 5000);
+    for (auto& ctx : contexts) ctx = stream.next();
+
+    auto makeEngines = [&](int count) {
+        std::vector<std::unique_ptr<RuleEngine>> engines;
+        for (int i = 0; i < count; i++) {
+            engines.push_back(std::make_unique<RuleEngine>());
+            engines.back()->loadRules(rules);
+        }
+        return engines;
+    };
+    auto shared = makeEngines(1);
+    auto sharded = makeEngines(threads);
+    double sharedRate = parallelEvalsPerSec(shared, threads, contexts);
+    double shardedRate = parallelEvalsPerSec(sharded, threads, contexts);
+    std::printf("%d threads on %u cores, 1000 rules: one shared engine %.0f evals/s, "
+                "one engine per thread %.0f evals/s (%.1fx)\n",
+                threads, cores, sharedRate, shardedRate, shardedRate / sharedRate);
+}
+
+void benchStateLog(const Options& opt) {
+    std::printf("\n== Learning-state persistence ==\n");
+    char dir[] = "/tmp/context_engine_bench_XXXXXX";
+    if (mkdtemp(dir) == nullptr) {
+        std::printf("mkdtemp failed\n");
+        return;
+    }
+    int updates = opt.quick ? 500 : 5000;
+    ContextStream stream(opt.seed + 6);
+    std::vector<ContextMap> contexts(updates);
+    for (auto& ctx : contexts) ctx = stream.next();
+    auto actionId = [](int i) { return "action_" + std::to_string(i % 16); };
+
+    // Previous approach: full MAB + LinUCB export after every reward
+    RuleEngine exporting;
+    size_t exportBytes = 0;
+    auto start = Clock::now();
+    for (int i = 0; i < updates; i++) {
+        exporting.updateReward(actionId(i), (i % 3) * 0.5, &contexts[i]);
+        exportBytes += exporting.linucb().exportJson().size() + exporting.mab().getStats().size();
+    }
+    double exportUs = static_cast<double>(elapsedNs(start)) / updates / 1000.0;
+
+    auto logged = std::make_unique<RuleEngine>();
+    logged->openStateLog(dir);
+    start = Clock::now();
+    for (int i = 0; i < updates; i++) logged->updateReward(actionId(i), (i % 3) * 0.5, &contexts[i]);
+    double logUs = static_cast<double>(elapsedNs(start)) / updates / 1000.0;
+    logged->compactStateLog();
+    size_t loggedLinUCB = logged->linucb().exportJson().size();
+    size_t loggedMab = logged->mab().getStats().size();
+
+    // A second engine on the same files is refused while the first holds them
+    RuleEngine restored;
+    bool refused = restored.openStateLog(dir) < 0;
+    logged.reset();
+
+    start = Clock::now();
+    int64_t replayed = restored.openStateLog(dir);
+    double replayMs = static_cast<double>(elapsedNs(start)) / 1e6;
+    bool same = restored.linucb().exportJson().size() == loggedLinUCB &&
+                restored.mab().getStats().size() == loggedMab;
+
+    std::printf("%d rewards: export-all %.1f us/update (%.0f bytes), state log %.1f us/update; "
+                "reopen replayed %lld records in %.2f ms, %s, %s\n",
+                updates, exportUs, static_cast<double>(exportBytes) / updates, logUs,
+                static_cast<long long>(replayed), replayMs, same ? "state matches" : "STATE MISMATCH",
+                refused ? "shared open refused" : "SHARED OPEN ALLOWED");
+
+    std::remove((std::string(dir) + "/context_engine_state.snap").c_str());
+    std::remove((std::string(dir) + "/context_engine_state.wal").c_str());
+    rmdir(dir);
+}
+
+void benchLinUCB(const Options& opt) {
+    std::printf("\n== LinUCB ==\n");
+    std::printf("%8s %16s %16s\n", "arms", "select(ops/s)", "update(ops/s)");
+
+    for (int arms : {8, 64}) {
+        LinUCB bandit(1.0);
+        std::vector<std::string> actionIds;
+        for (int a = 0; a < arms; a++) actionIds.push_back("action_" + std::to_string(a));
+
+        ContextStream stream(opt.seed + 3);
+        int iterations = opt.quick ? 500 : 5000;
+        std::vector<ContextMap> contexts;
+        contexts.reserve(iterations);
+        for (int i = 0; i < iterations; i++) contexts.push_back(stream.next());
+
+        std::mt19937 rng(opt.seed);
+        auto updStart = Clock::now();
+        for (int i = 0; i < iterations; i++) {
+            bandit.update(actionIds[rng() % arms], (rng() % 3) * 0.5, contexts[i]);
+        }
+        int64_t updNs = elapsedNs(updStart);
+
+        volatile int sink = 0;
+        auto selStart = Clock::now();
+        for (int i = 0; i < iterations; i++) {
+            sink = sink + bandit.select(actionIds, contexts[i]);
+        }
+        int64_t selNs = elapsedNs(selStart);
+
+        std::printf("%8d %16.0f %16.0f\n", arms,
+                    iterations / (selNs / 1e9), iterations / (updNs / 1e9));
+    }
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    Options opt = parseArgs(argc, argv);
+    std::printf("context_engine bench (seed=%u%s)\n", opt.seed, opt.quick ? ", quick" : "");
+    benchRuleEngine(opt);
+    benchEventBuffer(opt);
+    benchRulePacks(opt);
+    benchInstances(opt);
+    benchStateLog(opt);
+    benchLinUCB(opt);
+    return 0;
+}
@@ -0,0 +1,248 @@
+/**
+ * data_tray_bench.cpp — 传感器数据托盘 host 基准测试
+ *
+ * Measures SensorDataTray put / get / getSnapshot latency single-threaded
+ * (including the cached snapshot() path when nothing changed),
+ * then getSnapshot throughput and latency while writer threads keep putting
+ * sensor values (the sensor-callback vs engine-read contention case), and
+ * finally put cost with the mmap backing file open.
+ *
+ * Usage: data_tray_bench [--quick]
+ */
+#include "data_tray.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace data_tray;
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+double nsPerOp(Clock::time_point start, size_t ops) {
+    return static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        Clock::now() - start).count()) / static_cast<double>(ops);
+}
+
+const char* const kSensorKeys[] = {
+    "timeOfDay", "hour", "dayOfWeek", "isWeekend", "motionState", "batteryLevel",
+    "isCharging", "networkType", "geofence", "wifiSsid", "cellId", "latitude",
+    "longitude", "stepCount", "heartRate",
+};
+constexpr size_t kSensorKeyCount = sizeof(kSensorKeys) / sizeof(kSensorKeys[0]);
+
+void fillTray(SensorDataTray& tray) {
+    tray.put("timeOfDay", "morning");
+    tray.putInt("hour", 8);
+    tray.put("dayOfWeek", "2");
+    tray.put("isWeekend", "false");
+    tray.putEnum("motionState", "walking");
+    tray.putInt("batteryLevel", 76);
+    tray.put("isCharging", "false");
+    tray.put("networkType", "wifi");
+    tray.put("geofence", "work");
+    tray.put("wifiSsid", "CorpNet-5G-Floor12");
+    tray.put("cellId", "460_00_12345_67890");
+    tray.putNumber("latitude", 31.230416);
+    tray.putNumber("longitude", 121.473701);
+    tray.put("stepCount", "4211");
+}
+
+void benchSingleThread(SensorDataTray& tray, size_t ops) {
+    std::printf("== Single thread ==\n");
+    char value[32];
+    auto start = Clock::now();
+    for (size_t i = 0; i < ops; i++) {
+        std::snprintf(value, sizeof(value), "%zu", i % 100);
+        tray.put(kSensorKeys[i % kSensorKeyCount], value, 0.9, "bench");
+    }
+    std::printf("put:         %8.1f ns/op\n", nsPerOp(start, ops));
+    start = Clock::now();
+    for (size_t i = 0; i < ops; i++) tray.putInt("batteryLevel", static_cast<int64_t>(i % 100), 0.9, "bench");
+    std::printf("putInt:      %8.1f ns/op\n", nsPerOp(start, ops));
+    // With a subscriber every put also compares against the previous value
+    std::atomic<size_t> notified{0};
+    int sub = tray.subscribe([&](const std::vector<std::string>& keys) { notified += keys.size(); }, 50);
+    start = Clock::now();
+    for (size_t i = 0; i < ops; i++) tray.putInt("batteryLevel", static_cast<int64_t>(i / 1000 % 100), 0.9, "bench");
+    std::printf("putInt+sub:  %8.1f ns/op (%zu values changed)\n", nsPerOp(start, ops), ops / 1000);
+    tray.unsubscribe(sub);
+    // A full context refresh: 15 single puts vs one putMany batch
+    std::vector<TrayPut> batch;
+    for (size_t k = 0; k < kSensorKeyCount; k++) batch.push_back({kSensorKeys[k], TrayValue::ofInt(42), 0.9, "bench"});
+    start = Clock::now();
+    for (size_t i = 0; i < ops / kSensorKeyCount; i++) {
+        for (const auto& item : batch) tray.putValue(item.key, item.value, item.quality, item.source);
+    }
+    std::printf("15x put:     %8.1f ns/batch\n", nsPerOp(start, ops / kSensorKeyCount));
+    start = Clock::now();
+    for (size_t i = 0; i < ops / kSensorKeyCount; i++) tray.putMany(batch);
+    std::printf("putMany(15): %8.1f ns/batch\n", nsPerOp(start, ops / kSensorKeyCount));
+    std::vector<std::string> keys(kSensorKeys, kSensorKeys + kSensorKeyCount);
+    size_t found = 0;
+    start = Clock::now();
+    for (size_t i = 0; i < ops / kSensorKeyCount; i++) found += tray.getMany(keys).size();
+    std::printf("getMany(15): %8.1f ns/batch\n", nsPerOp(start, ops / kSensorKeyCount));
+    // Registry lookup behind every slot / TTL resolution (compile-time perfect hash)
+    size_t known = 0;
+    start = Clock::now();
+    for (size_t i = 0; i < ops; i++) known += keyId(keys[i % kSensorKeyCount]) >= 0;
+    std::printf("keyId:       %8.1f ns/op (%zu known)\n", nsPerOp(start, ops), known);
+    (void)found;
+    // Bounded history: one ring insert per put, aggregate is O(log n)
+    tray.enableHistory("heartRate", 4096);
+    start = Clock::now();
+    for (size_t i = 0; i < ops; i++) tray.putInt("heartRate", static_cast<int64_t>(60 + i % 40));
+    std::printf("put+history: %8.1f ns/op\n", nsPerOp(start, ops));
+    double meanSum = 0.0;
+    start = Clock::now();
+    for (size_t i = 0; i < ops / 10; i++) meanSum += tray.aggregate("heartRate", 60000)->mean;
+    std::printf("aggregate:   %8.1f ns/op (4096 samples)\n", nsPerOp(start, ops / 10));
+    tray.disableHistory("heartRate");
+    (void)meanSum;
+    fillTray(tray);
+
+    size_t hits = 0;
+    start = Clock::now();
+    for (size_t i = 0; i < ops; i++) hits += tray.get(kSensorKeys[i % kSensorKeyCount]).value.has_value();
+    std::printf("get:         %8.1f ns/op (%zu hits)\n", nsPerOp(start, ops), hits);
+
+    size_t bytes = 0;
+    start = Clock::now();
+    for (size_t i = 0; i < ops / 10; i++) bytes += tray.getSnapshot().motionState.size();
+    std::printf("getSnapshot: %8.1f ns/op\n", nsPerOp(start, ops / 10));
+    // Typed read of every key, as the engine's evaluateFromTray does
+    start = Clock::now();
+    for (size_t i = 0; i < ops / 10; i++) bytes += tray.readAll().size();
+    std::printf("readAll:     %8.1f ns/op\n", nsPerOp(start, ops / 10));
+
+    // Unchanged tray: the cached immutable snapshot is shared, not rebuilt
+    start = Clock::now();
+    for (size_t i = 0; i < ops; i++) bytes += tray.snapshot()->motionState.size();
+    std::printf("snapshot():  %8.1f ns/op (unchanged)\n", nsPerOp(start, ops));
+    start = Clock::now();
+    for (size_t i = 0; i < ops / 10; i++) {
+        tray.putInt("hour", static_cast<int64_t>(i % 24));
+        bytes += tray.snapshot()->motionState.size();
+    }
+    std::printf("put+snapshot:%8.1f ns/op (rebuilt)\n", nsPerOp(start, ops / 10));
+    (void)bytes;
+}
+
+void benchContended(SensorDataTray& tray, size_t snapshots, int writers) {
+    std::printf("\n== getSnapshot with %d writer threads (%u cores) ==\n", writers,
+                std::thread::hardware_concurrency());
+    fillTray(tray);
+    std::atomic<bool> stop{false};
+    std::atomic<size_t> puts{0};
+    std::vector<std::thread> pool;
+    for (int w = 0; w < writers; w++) {
+        pool.emplace_back([&, w] {
+            char value[32];
+            size_t n = 0;
+            while (!stop.load(std::memory_order_relaxed)) {
+                std::snprintf(value, sizeof(value), "%zu", n % 1000);
+                tray.put(kSensorKeys[(n * 7 + w) % kSensorKeyCount], value);
+                n++;
+            }
+            puts += n;
+        });
+    }
+
+    std::vector<double> latencies;
+    latencies.reserve(snapshots);
+    size_t torn = 0;
+    auto start = Clock::now();
+    for (size_t i = 0; i < snapshots; i++) {
+        auto t0 = Clock::now();
+        ContextSnapshot snap = tray.getSnapshot();
+        latencies.push_back(static_cast<double>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - t0).count()));
+        // Writers only store short decimal strings or the fillTray values
+        if (snap.hour.empty() || snap.hour.size() > 3) torn++;
+    }
+    double seconds = nsPerOp(start, 1) / 1e9;
+    stop = true;
+    for (auto& t : pool) t.join();
+
+    std::sort(latencies.begin(), latencies.end());
+    std::printf("%zu snapshots in %.2f s (%.0f/s), p50 %.0f ns, p99 %.0f ns, max %.0f ns; "
+                "%zu concurrent puts; %zu malformed\n",
+                snapshots, seconds, snapshots / seconds, latencies[latencies.size() / 2],
+                latencies[latencies.size() * 99 / 100], latencies.back(), puts.load(), torn);
+}
+
+void benchBacking(SensorDataTray& tray, size_t ops) {
+    std::printf("\n== mmap backing ==\n");
+    const char* path = "/tmp/data_tray_bench.slots";
+    std::remove(path);
+    if (tray.openBacking(path) < 0) {
+        std::printf("openBacking failed\n");
+        return;
+    }
+    auto start = Clock::now();
+    for (size_t i = 0; i < ops; i++) tray.putInt("batteryLevel", static_cast<int64_t>(i % 100), 0.9, "bench");
+    std::printf("putInt:      %8.1f ns/op (write-through)\n", nsPerOp(start, ops));
+}
+
+void benchExpiry(SensorDataTray& tray, size_t ops) {
+    std::printf("\n== TTL expiry (timer wheel) ==\n");
+    tray.enableExpiry(1000);
+    // Already armed: the put only checks the slot's flag
+    auto start = Clock::now();
+    for (size_t i = 0; i < ops; i++) tray.putInt("batteryLevel", static_cast<int64_t>(i % 100), 0.9, "bench");
+    std::printf("putInt:      %8.1f ns/op (armed)\n", nsPerOp(start, ops));
+    // First write of a key schedules its timer
+    char key[32];
+    size_t fresh = ops / 10;
+    start = Clock::now();
+    for (size_t i = 0; i < fresh; i++) {
+        std::snprintf(key, sizeof(key), "exp_%zu", i);
+        tray.putInt(key, 1);
+    }
+    std::printf("put(new key):%8.1f ns/op (%zu timers)\n", nsPerOp(start, fresh), fresh);
+}
+
+void benchDerived(SensorDataTray& tray, size_t ops) {
+    std::printf("\n== Derived slots ==\n");
+    tray.registerStandardDerived();
+    size_t hits = 0;
+    // Memoized: the minute and the wifiLost_work input don't move during the loop
+    auto start = Clock::now();
+    for (size_t i = 0; i < ops; i++) hits += tray.get("hour").value.has_value();
+    std::printf("get(hour):   %8.1f ns/op (memoized, %zu hits)\n", nsPerOp(start, ops), hits);
+    start = Clock::now();
+    for (size_t i = 0; i < ops / 10; i++) {
+        tray.put("wifiLost_work", i % 2 ? "true" : "false");
+        hits += tray.get("wifiLostWork").value.has_value();
+    }
+    std::printf("put+derive:  %8.1f ns/op (wifiLostWork recomputed)\n", nsPerOp(start, ops / 10));
+
+    // Losing another category's WiFi afterwards must not drop wifiLostWork
+    tray.put("wifiLost_work", "true");
+    tray.put("wifiLost", "true");
+    tray.put("wifiLostCategory", "home");
+    tray.put("wifiLost_home", "true");
+    std::printf("work then home lost: wifiLostWork %s\n",
+                tray.get("wifiLostWork").value.has_value() ? "kept" : "DROPPED");
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    bool quick = argc > 1 && std::strcmp(argv[1], "--quick") == 0;
+    auto& tray = SensorDataTray::getInstance();
+    std::printf("data_tray bench%s\n", quick ? " (quick)" : "");
+    benchSingleThread(tray, quick ? 200000 : 2000000);
+    benchContended(tray, quick ? 20000 : 200000, 2);
+    benchBacking(tray, quick ? 200000 : 2000000);
+    benchExpiry(tray, quick ? 200000 : 2000000);
+    benchDerived(tray, quick ? 200000 : 2000000);
+    return 0;
+}
@@ -0,0 +1,135 @@
+/**
+ * geo_utils_bench.cpp — 批量地理距离 host 基准测试
+ *
+ * Compares a haversineDistance loop with the SoA batch kernel (haversineDistances)
+ * on a city-sized point set (small-angle path) and a global one (polynomial path),
+ * reporting the speedup and the largest deviation from the scalar result.
+ * Then the radius query (pointsWithin vs a scalar filter) and a DBSCAN run.
+ *
+ * Usage: geo_utils_bench [--quick]
+ */
+#include "geo_utils.h"
+#include "dbscan_cluster.h"
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <vector>
+
+using namespace geo_utils;
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+double nsPerOp(Clock::time_point start, size_t ops) {
+    return static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        Clock::now() - start).count()) / static_cast<double>(ops);
+}
+
+/** n points uniformly within ±spreadDeg (latitude: at most ±90) of (lat, lon), clamped to valid coordinates */
+std::vector<GeoPoint> randomPoints(size_t n, double lat, double lon, double spreadDeg, uint32_t seed) {
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<double> dLat(-std::min(spreadDeg, 90.0), std::min(spreadDeg, 90.0));
+    std::uniform_real_distribution<double> dLon(-spreadDeg, spreadDeg);
+    std::vector<GeoPoint> points(n);
+    for (size_t i = 0; i < n; i++) {
+        points[i].latitude = std::max(-90.0, std::min(90.0, lat + dLat(rng)));
+        points[i].longitude = std::max(-180.0, std::min(180.0, lon + dLon(rng)));
+        points[i].timestamp = static_cast<int64_t>(i) * 60000;
+    }
+    return points;
+}
+
+void benchDistances(const char* name, const std::vector<GeoPoint>& points, size_t rounds) {
+    GeoBatch batch = GeoBatch::of(points);
+    std::vector<double> scalar(points.size()), batched(points.size());
+    const GeoPoint& q = points[points.size() / 2];
+
+    auto start = Clock::now();
+    for (size_t r = 0; r < rounds; r++) {
+        for (size_t i = 0; i < points.size(); i++) {
+            scalar[i] = haversineDistance(q.latitude, q.longitude, points[i].latitude, points[i].longitude);
+        }
+    }
+    double scalarNs = nsPerOp(start, rounds * points.size());
+
+    start = Clock::now();
+    for (size_t r = 0; r < rounds; r++) {
+        haversineDistances(q.latitude, q.longitude, batch, batched.data());
+    }
+    double batchNs = nsPerOp(start, rounds * points.size());
+
+    double maxErr = 0;
+    for (size_t i = 0; i < points.size(); i++) maxErr = std::max(maxErr, std::fabs(batched[i] - scalar[i]));
+    std::printf("%-8s scalar %5.2f ns/pt, batch %5.2f ns/pt (%.1fx), max |diff| %.2e m\n",
+                name, scalarNs, batchNs, scalarNs / batchNs, maxErr);
+}
+
+void benchRadius(const std::vector<GeoPoint>& points, double radius, size_t rounds) {
+    GeoBatch batch = GeoBatch::of(points);
+    std::vector<size_t> hits;
+    const GeoPoint& q = points[points.size() / 2];
+
+    size_t scalarHits = 0;
+    auto start = Clock::now();
+    for (size_t r = 0; r < rounds; r++) {
+        hits.clear();
+        for (size_t i = 0; i < points.size(); i++) {
+            if (haversineDistance(q.latitude, q.longitude, points[i].latitude, points[i].longitude) <= radius) {
+                hits.push_back(i);
+            }
+        }
+        scalarHits = hits.size();
+    }
+    double scalarNs = nsPerOp(start, rounds * points.size());
+
+    size_t batchHits = 0;
+    start = Clock::now();
+    for (size_t r = 0; r < rounds; r++) {
+        hits.clear();
+        pointsWithin(q.latitude, q.longitude, batch, radius, hits);
+        batchHits = hits.size();
+    }
+    double batchNs = nsPerOp(start, rounds * points.size());
+    std::printf("within %.0fm: scalar %5.2f ns/pt, batch %5.2f ns/pt (%.1fx), hits %zu / %zu\n",
+                radius, scalarNs, batchNs, scalarNs / batchNs, scalarHits, batchHits);
+}
+
+void benchDbscan(const std::vector<GeoPoint>& points) {
+    dbscan::ClusterConfig config;
+    config.epsilonMeters = 50.0;
+    config.minSamples = 10;
+    dbscan::DBSCAN dbscan(config);
+    auto start = Clock::now();
+    auto clusters = dbscan.cluster(points);
+    double ms = nsPerOp(start, 1) / 1e6;
+    std::printf("dbscan:  %zu points → %zu clusters in %.1f ms\n", points.size(), clusters.size(), ms);
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    bool quick = argc > 1 && std::strcmp(argv[1], "--quick") == 0;
+    size_t n = quick ? 4096 : 65536;
+    size_t rounds = quick ? 20 : 100;
+    std::printf("geo_utils bench%s\n", quick ? " (quick)" : "");
+    // ~5 km around a city center: small-angle path
+    auto city = randomPoints(n, 31.23, 121.47, 0.02, 1);
+    // whole globe: polynomial haversine path
+    auto globe = randomPoints(n, 0.0, 0.0, 180.0, 2);
+    benchDistances("city:", city, rounds);
+    benchDistances("globe:", globe, rounds);
+    benchRadius(city, 500.0, rounds);
+    benchRadius(globe, 2000000.0, rounds);
+    // GPS history: dense stays (a few hundred meters) plus commute noise
+    std::vector<GeoPoint> history;
+    for (uint32_t s = 0; s < 4; s++) {
+        auto stay = randomPoints(quick ? 500 : 2500, 31.2 + 0.02 * s, 121.4 + 0.03 * s, 0.001, 10 + s);
+        history.insert(history.end(), stay.begin(), stay.end());
+    }
+    auto noise = randomPoints(quick ? 500 : 2000, 31.23, 121.45, 0.05, 20);
+    history.insert(history.end(), noise.begin(), noise.end());
+    benchDbscan(history);
+    return 0;
+}
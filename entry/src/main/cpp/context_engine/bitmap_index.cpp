@@ -0,0 +1,155 @@
+/**
+ * bitmap_index.cpp — 位图索引候选规则筛选
+ *
+ * 每个 eq/in 条件的取值 → 规则下标位图；evaluate 时按上下文逐 key 做
+ * AND(values[v] | unused)，只有存活规则进入 soft match。
+ * 64-bit word 位运算 (ARM 上用 NEON 一次处理两个 word)，新增规则可增量更新。
+ * 位序号是规则在 score 上界排序中的位置，候选按上界从高到低产出。
+ */
+#include "context_engine.h"
+#include <algorithm>
+#include <sstream>
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define CONTEXT_ENGINE_NEON 1
+#endif
+
+namespace context_engine {
+
+static size_t wordsFor(size_t numRules) {
+    return (numRules + 63) / 64;
+}
+
+// Same tokenization as soft_match "in": comma-separated, trimmed, empty items skipped
+static std::vector<std::string> splitValues(const std::string& s) {
+    std::vector<std::string> parts;
+    std::istringstream ss(s);
+    std::string item;
+    while (std::getline(ss, item, ',')) {
+        auto start = item.find_first_not_of(" \t");
+        auto end = item.find_last_not_of(" \t");
+        if (start != std::string::npos) {
+            parts.push_back(item.substr(start, end - start + 1));
+        }
+    }
+    return parts;
+}
+
+// acc &= vals | unused; words past the end of `vals` are zero
+static void andOrInto(uint64_t* acc, const uint64_t* vals, size_t valWords,
+                      const uint64_t* unused, size_t words) {
+    size_t n = std::min(valWords, words);
+    size_t w = 0;
+#ifdef CONTEXT_ENGINE_NEON
+    for (; w + 2 <= n; w += 2) {
+        uint64x2_t keep = vorrq_u64(vld1q_u64(vals + w), vld1q_u64(unused + w));
+        vst1q_u64(acc + w, vandq_u64(vld1q_u64(acc + w), keep));
+    }
+#endif
+    for (; w < n; w++) acc[w] &= vals[w] | unused[w];
+    for (; w < words; w++) acc[w] &= unused[w];
+}
+
+void RuleBitmapIndex::build(const std::vector<Rule>& rules, const std::vector<int>& order) {
+    keys_.clear();
+    enabled_.clear();
+    numRules_ = 0;
+    growTo(order.size());
+    for (size_t pos = 0; pos < order.size(); pos++) {
+        insertRule(static_cast<int>(pos), rules[order[pos]]);
+    }
+}
+
+void RuleBitmapIndex::setRule(int pos, const Rule& rule) {
+    if (static_cast<size_t>(pos) >= numRules_) {
+        growTo(static_cast<size_t>(pos) + 1);
+    } else {
+        clearRule(pos);
+    }
+    insertRule(pos, rule);
+}
+
+void RuleBitmapIndex::growTo(size_t numRules) {
+    size_t words = wordsFor(numRules);
+    enabled_.resize(words, 0);
+    for (auto& [key, ki] : keys_) {
+        ki.unused.resize(words, 0);
+        for (size_t r = numRules_; r < numRules; r++) {
+            ki.unused[r / 64] |= uint64_t{1} << (r % 64);
+        }
+    }
+    numRules_ = numRules;
+}
+
+void RuleBitmapIndex::clearRule(int pos) {
+    size_t word = static_cast<size_t>(pos) / 64;
+    uint64_t bit = uint64_t{1} << (pos % 64);
+    enabled_[word] &= ~bit;
+    for (auto& [key, ki] : keys_) {
+        ki.unused[word] |= bit;
+        for (auto& [value, bits] : ki.values) {
+            if (word < bits.size()) bits[word] &= ~bit;
+        }
+    }
+}
+
+void RuleBitmapIndex::insertRule(int pos, const Rule& rule) {
+    size_t word = static_cast<size_t>(pos) / 64;
+    uint64_t bit = uint64_t{1} << (pos % 64);
+    if (rule.enabled) enabled_[word] |= bit;
+
+    // Values a rule accepts on a key = intersection over its eq/in conditions on it
+    std::unordered_map<std::string, std::vector<std::string>> accepted;
+    for (const auto& cond : rule.conditions) {
+        if (cond.op != "eq" && cond.op != "in") continue;
+        auto values = cond.op == "eq" ? std::vector<std::string>{cond.value} : splitValues(cond.value);
+        auto it = accepted.find(cond.key);
+        if (it == accepted.end()) {
+            accepted.emplace(cond.key, std::move(values));
+            continue;
+        }
+        auto& kept = it->second;
+        kept.erase(std::remove_if(kept.begin(), kept.end(), [&](const std::string& v) {
+            return std::find(values.begin(), values.end(), v) == values.end();
+        }), kept.end());
+    }
+
+    for (const auto& [key, values] : accepted) {
+        auto [it, inserted] = keys_.try_emplace(key);
+        auto& ki = it->second;
+        if (inserted) {
+            // A new key: every existing rule is unused on it
+            ki.unused.assign(wordsFor(numRules_), ~uint64_t{0});
+            if (numRules_ % 64 != 0) ki.unused.back() = (uint64_t{1} << (numRules_ % 64)) - 1;
+        }
+        ki.unused[word] &= ~bit;
+        for (const auto& value : values) {
+            auto& bits = ki.values[value];
+            if (bits.size() <= word) bits.resize(word + 1, 0);
+            bits[word] |= bit;
+        }
+    }
+}
+
+size_t RuleBitmapIndex::candidates(const ContextMap& ctx, std::vector<uint64_t>& out) const {
+    out.assign(enabled_.begin(), enabled_.end());
+    size_t words = out.size();
+    for (const auto& [key, ki] : keys_) {
+        auto ctxIt = ctx.find(key);
+        if (ctxIt == ctx.end()) continue;  // missing → soft match 0.5, prune nothing
+        auto valIt = ki.values.find(ctxIt->second);
+        if (valIt == ki.values.end()) {
+            andOrInto(out.data(), nullptr, 0, ki.unused.data(), words);
+        } else {
+            andOrInto(out.data(), valIt->second.data(), valIt->second.size(),
+                      ki.unused.data(), words);
+        }
+    }
+
+    size_t count = 0;
+    for (uint64_t w : out) count += static_cast<size_t>(__builtin_popcountll(w));
+    return count;
+}
+
+}  // namespace context_engine
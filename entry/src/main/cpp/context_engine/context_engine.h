@@ -7,10 +7,15 @@
  *   - Multi-Armed Bandit (epsilon-greedy) for action selection
  *   - Event buffer for temporal/sequence conditions
  *   - Enhanced cooldown (per-rule, per-category, global rate limit)
+ *   - Traffic profile for profile-guided tree recompilation
+ *   - Bitmap-index evaluation mode (alternative to the tree)
+ *   - Write-ahead log for bandit and cooldown state
+ *   - Offline (replay / IPS) evaluation of bandit policies on logged data
  */
 #pragma once
 
 #include <string>
+#include <string_view>
 #include <vector>
 #include <array>
 #include <unordered_map>
@@ -21,6 +26,10 @@
 #include <deque>
 #include <cerrno>
 #include <cstdlib>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <random>
 
 namespace context_engine {
 
@@ -37,20 +46,106 @@ inline double safe_stod(const std::string& s, double defVal = 0.0) {
     return val;
 }
 
+/** Whole-string number parse (trailing blanks allowed); false if not a number */
+inline bool parseNumber(const std::string& s, double& out) {
+    if (s.empty()) return false;
+    const char* start = s.c_str();
+    char* end = nullptr;
+    errno = 0;
+    double val = strtod(start, &end);
+    if (end == start || errno == ERANGE) return false;
+    while (*end == ' ' || *end == '\t') end++;
+    if (*end != '\0') return false;
+    out = val;
+    return true;
+}
+
 // ============================================================
 // Data types
 // ============================================================
 
+/**
+ * A context or condition value: the string every comparison sees, plus the
+ * number it encodes, decoded once when the value is set. Typed producers
+ * (JSON numbers/booleans, the data tray) pass the number directly, so numeric
+ * conditions and LinUCB features never re-parse per evaluation.
+ * The string is read-only; assigning a new value re-parses the number.
+ */
+class ContextValue {
+public:
+    ContextValue() = default;
+    ContextValue(std::string s) : str_(std::move(s)) { hasNumber_ = looksNumeric() && parseNumber(str_, number_); }
+    ContextValue(const char* s) : ContextValue(std::string(s)) {}
+    ContextValue(double v) : str_(formatNumber(v)), number_(v), hasNumber_(true) {}
+    ContextValue(int64_t v) : str_(std::to_string(v)), number_(static_cast<double>(v)), hasNumber_(true) {}
+    ContextValue(bool v) : str_(v ? "true" : "false") {}
+
+    ContextValue& operator=(std::string s) { return *this = ContextValue(std::move(s)); }
+    ContextValue& operator=(const char* s) { return *this = ContextValue(std::string(s)); }
+
+    const std::string& str() const { return str_; }
+    operator const std::string&() const { return str_; }
+    bool empty() const { return str_.empty(); }
+    size_t size() const { return str_.size(); }
+    const char* c_str() const { return str_.c_str(); }
+
+    friend bool operator==(const ContextValue& a, const ContextValue& b) { return a.str_ == b.str_; }
+    friend bool operator==(const ContextValue& a, const std::string& b) { return a.str_ == b; }
+    friend bool operator==(const std::string& a, const ContextValue& b) { return a == b.str_; }
+    friend bool operator==(const ContextValue& a, const char* b) { return a.str_ == b; }
+    friend bool operator!=(const ContextValue& a, const ContextValue& b) { return a.str_ != b.str_; }
+    friend bool operator!=(const ContextValue& a, const std::string& b) { return a.str_ != b; }
+    friend bool operator!=(const std::string& a, const ContextValue& b) { return a != b.str_; }
+    friend bool operator!=(const ContextValue& a, const char* b) { return a.str_ != b; }
+
+    /** The numeric value, if the string is a number */
+    bool number(double& out) const {
+        if (hasNumber_) out = number_;
+        return hasNumber_;
+    }
+
+    /**
+     * How far the reading is trusted (0~1, default 1). Set from the data tray's
+     * effective quality by evaluateFromTray; softMatch scales matches by it.
+     */
+    double quality() const { return quality_; }
+    void setQuality(double q) { quality_ = q < 0.0 ? 0.0 : (q > 1.0 ? 1.0 : q); }
+
+    /** Shortest round-trip-ish text for a double ("76", "31.230416") */
+    static std::string formatNumber(double v) {
+        char buf[32];
+        std::snprintf(buf, sizeof(buf), "%.15g", v);
+        return buf;
+    }
+
+private:
+    bool looksNumeric() const {
+        // Cheap pre-check so categorical values ("walking") skip strtod
+        if (str_.empty()) return false;
+        char c = str_.front();
+        return (c >= '0' && c <= '9') || std::strchr("+-. \t\n\r\v\fiInN", c) != nullptr;
+    }
+
+    std::string str_;
+    double number_ = 0.0;
+    double quality_ = 1.0;
+    bool hasNumber_ = false;
+};
+
 /** A single condition in a rule: key op value */
 struct Condition {
     std::string key;       // e.g. "timeOfDay", "motionState", "geofence"
-                           // For recent: "event:<eventType>" e.g. "event:geofence_enter"
+                           // For recent/countWithin/rateWithin: "event:<eventType>"
+                           //   e.g. "event:geofence_enter"
                            // For sequence: "sequence:<typeA>,<typeB>"
     std::string op;        // "eq", "neq", "gt", "lt", "gte", "lte", "in", "range",
                            // "recent" (event happened within N ms),
-                           // "within" (sequence A→B within N ms)
-    std::string value;     // single value, JSON array for "in", "lo,hi" for "range",
-                           // milliseconds string for "recent"/"within"
+                           // "within" (sequence A→B within N ms),
+                           // "countWithin" (≥ C events within N ms),
+                           // "rateWithin" (≥ R events per minute over N ms)
+    ContextValue value;    // single value, JSON array for "in", "lo,hi" for "range",
+                           // milliseconds string for "recent"/"within",
+                           // "N,C" / "N,R" for "countWithin"/"rateWithin"
 };
 
 /** An action to recommend when a rule fires */
@@ -79,7 +174,76 @@ struct MatchResult {
 };
 
 /** Context snapshot — key-value pairs from sensors */
-using ContextMap = std::unordered_map<std::string, std::string>;
+using ContextMap = std::unordered_map<std::string, ContextValue>;
+
+// ============================================================
+// Built-in rule packs (constexpr tables generated at build time)
+// ============================================================
+
+/** A pack condition; keyId indexes RulePack::keys */
+struct PackCondition {
+    uint16_t keyId;
+    const char* op;
+    const char* value;
+};
+
+/** A pack rule; its conditions are conditions[firstCondition, +conditionCount) */
+struct PackRule {
+    const char* id;
+    const char* name;
+    const char* actionId;
+    const char* actionType;
+    const char* actionPayload;
+    double priority;
+    int64_t cooldownMs;
+    bool enabled;
+    uint32_t firstCondition;
+    uint32_t conditionCount;
+};
+
+/** A branch of a pre-built tree node: value → child node */
+struct PackBranch {
+    const char* value;
+    int32_t child;
+};
+
+/** A pre-built decision tree node, flattened (mirrors TreeNode) */
+struct PackTreeNode {
+    int32_t splitKeyId;        // index into RulePack::keys, -1 for a leaf
+    uint32_t firstBranch;
+    uint32_t branchCount;
+    int32_t defaultChild;      // -1 if none
+    uint32_t firstLeafRule;    // leaf: RulePack::leafRules[firstLeafRule, +leafRuleCount)
+    uint32_t leafRuleCount;
+};
+
+/**
+ * A rule pack compiled by gen_rule_packs.py from rule JSON (e.g. rawfile
+ * config/default_rules.json → "default"), including the decision tree that
+ * compileTree() would build statically. Loaded with RuleEngine::loadRulePack.
+ */
+struct RulePack {
+    const char* name;
+    const char* const* keys;   // interned condition keys
+    size_t keyCount;
+    const PackCondition* conditions;
+    size_t conditionCount;
+    const PackRule* rules;
+    size_t ruleCount;
+    const PackTreeNode* nodes;
+    size_t nodeCount;
+    const PackBranch* branches;
+    const uint32_t* leafRules;
+};
+
+/** Built-in pack by name, or nullptr (defined in the generated rule_packs.cpp) */
+const RulePack* findRulePack(const std::string& name);
+
+/** The pack's rules as Rule values, in pack order */
+std::vector<Rule> packRules(const RulePack& pack);
+
+/** Rules as the JSON array exportRules returns */
+std::string rulesToJson(const std::vector<Rule>& rules);
 
 // ============================================================
 // Event buffer (temporal context)
@@ -87,7 +251,7 @@ using ContextMap = std::unordered_map<std::string, std::string>;
 
 /** A context event pushed from ArkTS when something notable happens */
 struct ContextEvent {
-    ContextMap context;       // snapshot at the time
+    ContextMap context;       // snapshot at the time (stored delta-encoded by EventBuffer)
     int64_t timestampMs;      // when it happened (steady_clock ms)
     std::string eventType;    // e.g. "geofence_enter", "motion_change", "app_open"
 };
@@ -99,10 +263,28 @@ struct RateLimits {
     int globalMaxPerHour = 10;              // max total recommendations per hour
 };
 
-/** Thread-safe circular event buffer with auto-expiry */
+/**
+ * Thread-safe columnar event ring with auto-expiry.
+ *
+ * Events are stored as three columns (timestamp, interned type id, context
+ * offset) instead of full ContextEvent copies. Contexts go to a word arena,
+ * dictionary-encoded (16-bit key id, 16-bit value id per word) as deltas against the previous
+ * event's context, with a full keyframe every KEYFRAME_INTERVAL contexts.
+ * Columns and arena start small and double up to their limits, so a
+ * partly filled buffer only pays for what it holds. When the arena wraps,
+ * the oldest contexts are dropped; the events themselves are kept until
+ * they age out or the ring is full. Type names and their counters are
+ * dropped once a type has no event left in the last 24 h.
+ */
 class EventBuffer {
 public:
-    explicit EventBuffer(size_t maxSize = 100);
+    /** Default ring size: one event every ~10 s for 24 h (MAX_AGE_MS) */
+    static constexpr size_t DEFAULT_CAPACITY = 8192;
+    /** Default context arena limit in 32-bit words (256 KB) */
+    static constexpr size_t DEFAULT_ARENA_WORDS = 65536;
+
+    explicit EventBuffer(size_t capacity = DEFAULT_CAPACITY,
+                         size_t arenaWords = DEFAULT_ARENA_WORDS);
 
     /** Push a new event. Automatically expires events older than 24 hours. */
     void push(const ContextEvent& event);
@@ -117,14 +299,154 @@ public:
     bool hasSequence(const std::string& eventA, const std::string& eventB,
                      int64_t withinMs) const;
 
+    /** Timestamp of the latest eventType within withinMs of now, or -1 */
+    int64_t lastSeen(const std::string& eventType, int64_t withinMs) const;
+
+    /**
+     * Timestamp of the event A that currently satisfies hasSequence(A, B),
+     * i.e. the latest A before the latest B within the window, or -1.
+     * The sequence stops matching once this A ages out.
+     */
+    int64_t sequenceStart(const std::string& eventA, const std::string& eventB,
+                          int64_t withinMs) const;
+
+    /**
+     * Number of eventType events within withinMs of now, from per-type counters
+     * at 1 s / 1 min / 1 h resolution (windows up to 60 s / 60 min / 24 h).
+     * O(1) in the number of events; may include events up to one bucket older
+     * than the window.
+     */
+    int64_t countWithin(const std::string& eventType, int64_t withinMs) const;
+
+    /** countWithin as events per minute over the window */
+    double rateWithin(const std::string& eventType, int64_t withinMs) const;
+
+    /**
+     * Time (steady ms) at which countWithin(eventType, withinMs) drops below
+     * minCount as its oldest buckets leave the window; -1 if already below.
+     */
+    int64_t countDropsAt(const std::string& eventType, int64_t withinMs,
+                         int64_t minCount) const;
+
     size_t size() const;
 
+    /** Context of the i-th retained event (0 = oldest); empty if none or evicted */
+    ContextMap contextAt(size_t i) const;
+
+    /** Approximate heap footprint (columns, arena, dictionaries) */
+    size_t memoryBytes() const;
+
 private:
+    static constexpr int64_t MAX_AGE_MS = 86400000;  // 24 hours
+    static constexpr uint32_t NONE = 0xFFFFFFFFu;    // no context / key absent
+    static constexpr uint32_t KEYFRAME_FLAG = 0x80000000u;
+    static constexpr int KEYFRAME_INTERVAL = 32;
+    /** Distinct context keys / values before the dictionaries and arena are reset (16-bit ids) */
+    static constexpr size_t MAX_DICT_VALUES = 65535;
+    /** Value id of a key a delta removes (0xFFFF is never a dictionary id) */
+    static constexpr uint32_t ABSENT_VALUE = 0xFFFFu;
+    /** First allocation of the columns (events) and the arena (words); both double from there */
+    static constexpr size_t INITIAL_SLOTS = 64;
+    static constexpr size_t INITIAL_ARENA_WORDS = 1024;
+
+    /** Counter buckets per type: 60 × 1 s, 60 × 1 min, 24 × 1 h */
+    static constexpr size_t COUNTER_BUCKETS = 60 + 60 + 24;
+    /** Type count that triggers pruning between hourly passes; doubles with the live count */
+    static constexpr size_t PRUNE_TYPES_AT = 64;
+    struct CountBucket {
+        int64_t index = -1;   // timestamp / resolution of the events counted here
+        uint32_t count = 0;
+    };
+    using TypeCounters = std::array<CountBucket, COUNTER_BUCKETS>;
+
+    /**
+     * Interned strings: one character pool plus an open-addressing table of
+     * ids, ~4 bytes of overhead per string besides its characters and table slot.
+     */
+    struct StringPool {
+        std::string chars;
+        std::vector<uint32_t> ends;    // id → end of its characters in chars
+        std::vector<uint32_t> slots;   // hash table of ids, NONE = empty, power of two
+
+        size_t size() const { return ends.size(); }
+        std::string_view at(uint32_t id) const {
+            uint32_t begin = id > 0 ? ends[id - 1] : 0;
+            return std::string_view(chars).substr(begin, ends[id] - begin);
+        }
+        /** Id of s, or NONE */
+        uint32_t find(std::string_view s) const;
+        /** Id of s, adding it if new */
+        uint32_t intern(std::string_view s);
+        void clear();
+        size_t memoryBytes() const;
+    };
+
+    /** Drop events older than MAX_AGE_MS; prunes dead types once per hour bucket */
     void expireOld();
 
-    std::deque<ContextEvent> events_;
-    size_t maxSize_;
-    static constexpr int64_t MAX_AGE_MS = 86400000;  // 24 hours
+    /**
+     * Forget types with no retained event and no counted event within
+     * MAX_AGE_MS, renumbering the rest, so dynamic type names do not keep
+     * their name and counters forever
+     */
+    void pruneTypes(int64_t cutoff);
+
+    /** Make room for one more event: double the columns (unrolling the ring) up to capacity_ */
+    void growColumns();
+
+    /** Double the arena until `words` fit, up to arenaLimit_, keeping every valid record */
+    void growArena(size_t words);
+
+    /** Add an event at timestampMs to the type's counters */
+    void countEvent(uint32_t type, int64_t timestampMs);
+
+    /** Per-bucket counts covering withinMs of now at the finest fitting resolution */
+    template <typename Fn>
+    void forEachWindowBucket(uint32_t type, int64_t now, int64_t withinMs, Fn&& fn) const;
+
+    /** Ring slot of the i-th retained event (0 = oldest) */
+    size_t slot(size_t i) const { return (head_ + i) % timestamps_.size(); }
+
+    /** Type id, or NONE if the type was never pushed */
+    uint32_t findType(const std::string& eventType) const;
+
+    /** Latest retained event of `type` at or after cutoff, scanning newest first; -1 if none */
+    int64_t latestOf(uint32_t type, int64_t cutoff, int64_t before) const;
+
+    /** Encode a context into the arena; returns its offset or NONE */
+    uint32_t appendContext(const ContextMap& ctx);
+
+    /** True while the arena record at `offset` has not been overwritten or reset */
+    bool arenaValid(uint32_t offset) const {
+        return static_cast<uint32_t>(offset - arenaFloor_) < static_cast<uint32_t>(arenaWritten_ - arenaFloor_);
+    }
+    uint32_t arenaAt(uint32_t offset) const { return arena_[offset % arena_.size()]; }
+
+    // Event columns (ring over the allocated slots, at most capacity_; head_ = oldest, count_ retained)
+    size_t capacity_;
+    size_t head_ = 0;
+    size_t count_ = 0;
+    std::vector<int64_t> timestamps_;
+    std::vector<uint32_t> types_;
+    std::vector<uint32_t> ctxOffsets_;
+
+    // Interned event types
+    StringPool typeNames_;
+    std::vector<TypeCounters> counters_;  // by type id
+    int64_t pruneHour_ = -1;              // hour bucket of the last pruneTypes
+    size_t pruneAtTypes_ = PRUNE_TYPES_AT;
+
+    // Context arena: record = [count | KEYFRAME_FLAG?, (keyId << 16 | valueId) × count]
+    std::vector<uint32_t> arena_;
+    size_t arenaLimit_;
+    uint32_t arenaWritten_ = 0;      // words written so far (wraps)
+    uint32_t arenaFloor_ = 0;        // oldest word still valid
+    StringPool keyNames_;
+    StringPool valueNames_;
+    std::vector<uint32_t> lastContext_;  // keyId → valueId of the previous context (NONE = absent)
+    std::vector<uint32_t> scratch_;      // appendContext working copy, swapped with lastContext_
+    int sinceKeyframe_ = KEYFRAME_INTERVAL;
+
     mutable std::mutex mu_;
 };
 
@@ -138,10 +460,184 @@ struct TreeNode {
     std::vector<std::pair<std::string, int>> branches;  // value → child index
     int defaultChild;                              // fallback child index (-1 if leaf)
 
-    // Leaf node: candidate rules to evaluate
+    // Leaf node: candidate rules to evaluate, highest score bound first
     std::vector<int> ruleIndices;                  // indices into RuleEngine::rules_
 };
 
+// ============================================================
+// Bitmap index (alternative candidate selection)
+// ============================================================
+
+/** How evaluate() selects candidate rules before soft matching */
+enum class EvalMode {
+    Tree,     // compiled decision tree (default)
+    Bitmap,   // per-value rule bitsets AND-ed across context keys
+};
+
+/**
+ * Categorical index over rule positions. For every key used by an eq/in
+ * condition, each mentioned value maps to the bitset of rules that accept it,
+ * plus an "unused" bitset of rules with no eq/in condition on the key.
+ * Candidates = enabled ∧ ⋀_k (values[ctx[k]] ∨ unused_k) over present keys;
+ * a missing key prunes nothing (soft match scores it 0.5).
+ * Only eq/in mismatches are pruned, so the survivors' soft-match results
+ * equal a linear scan over all rules.
+ *
+ * Bits are positions, not rule indices: the engine lays rules out by score
+ * bound so candidates come out best-first.
+ */
+class RuleBitmapIndex {
+public:
+    /** Rebuild from scratch; position p holds rules[order[p]] */
+    void build(const std::vector<Rule>& rules, const std::vector<int>& order);
+
+    /** Insert or replace the rule at `pos` (pos ≤ current size) without a rebuild */
+    void setRule(int pos, const Rule& rule);
+
+    /** Reset position `pos` so it is never a candidate */
+    void clearRule(int pos);
+
+    /**
+     * Compute candidate positions for a context into `out` (one bit per position).
+     * @returns number of candidates
+     */
+    size_t candidates(const ContextMap& ctx, std::vector<uint64_t>& out) const;
+
+    size_t ruleCount() const { return numRules_; }
+
+private:
+    using Bits = std::vector<uint64_t>;
+
+    struct KeyIndex {
+        std::unordered_map<std::string, Bits> values;  // value → accepting rules (may be short)
+        Bits unused;                                    // rules without eq/in on this key
+    };
+
+    /** Extend every bitset to `numRules`; new positions start as "unused" on all keys */
+    void growTo(size_t numRules);
+
+    /** Set the bits of the rule at `pos` (assumes the position is clear) */
+    void insertRule(int pos, const Rule& rule);
+
+    std::unordered_map<std::string, KeyIndex> keys_;
+    Bits enabled_;
+    size_t numRules_ = 0;
+};
+
+// ============================================================
+// Traffic profile (observed context value distributions)
+// ============================================================
+
+/**
+ * Value-frequency statistics for the keys the decision tree can split on.
+ * Collected on every evaluate; used by recompileWithProfile() to shape the
+ * tree by expected evaluation cost instead of raw rule coverage.
+ */
+class ContextProfile {
+public:
+    /** Distinct values tracked per key; further values are counted as "other" */
+    static constexpr size_t MAX_VALUES_PER_KEY = 64;
+
+    /** Restrict recording to these keys (split candidates). Keeps existing counts. */
+    void setTrackedKeys(const std::vector<std::string>& keys);
+
+    /** Record one evaluated context. Caller serializes access. */
+    void record(const ContextMap& ctx);
+
+    /**
+     * Estimated P(key == value), Laplace-smoothed over numValues candidate
+     * values so that keys without samples degrade to a uniform estimate.
+     */
+    double probability(const std::string& key, const std::string& value,
+                       size_t numValues) const;
+
+    int64_t samples() const { return samples_; }
+
+    void clear();
+
+    /** Serialize as {"samples":N,"keys":{"k":{"missing":M,"other":O,"values":{"v":C}}}} */
+    std::string toJson() const;
+
+    /** Load from toJson() output (replaces current counts). */
+    bool fromJson(const std::string& json);
+
+private:
+    struct KeyStats {
+        int64_t total = 0;       // missing + other + Σ values
+        int64_t missing = 0;
+        int64_t other = 0;
+        std::unordered_map<std::string, int64_t> values;
+    };
+
+    int64_t samples_ = 0;
+    std::unordered_map<std::string, KeyStats> keys_;
+    // Pointers into keys_ (node-based map → stable across rehash)
+    std::vector<std::pair<std::string, KeyStats*>> tracked_;
+};
+
+/** Evaluation counters (cumulative since last reset) */
+struct EvalStats {
+    int64_t evaluations = 0;          // evaluate() calls
+    int64_t rulesEvaluated = 0;       // candidate rules whose conditions were matched
+    int64_t conditionsEvaluated = 0;  // condition matches actually computed
+    int64_t memoHits = 0;             // condition uses served from the per-evaluate memo
+    int64_t reorders = 0;             // adaptive condition reorder passes
+    int64_t boundStops = 0;           // evaluations cut short: top-K beat every remaining bound
+    int64_t budgetStops = 0;          // evaluations cut short by the time budget
+
+    // Condition uses per scored rule (computed + memoized), split at the first
+    // reorder after loadRules: authoring order vs. adaptive order
+    int64_t rulesBeforeReorder = 0;
+    int64_t condsBeforeReorder = 0;
+    int64_t rulesAfterReorder = 0;
+    int64_t condsAfterReorder = 0;
+
+    double condsPerRuleBefore() const {
+        return rulesBeforeReorder > 0 ? static_cast<double>(condsBeforeReorder) / rulesBeforeReorder : 0.0;
+    }
+    double condsPerRuleAfter() const {
+        return rulesAfterReorder > 0 ? static_cast<double>(condsAfterReorder) / rulesAfterReorder : 0.0;
+    }
+};
+
+// ============================================================
+// Adaptive condition ordering
+// ============================================================
+
+/** Per-condition runtime statistics */
+struct ConditionStats {
+    uint32_t evaluated = 0;
+    uint32_t rejected = 0;    // match ≤ MIN_CONFIDENCE → rule can no longer fire
+};
+
+/**
+ * A distinct condition in the common-subexpression table. Rules that repeat
+ * the same key/op/value share one entry, so it is matched at most once per
+ * evaluate (memoized) and its statistics pool every rule's observations.
+ */
+struct SharedCondition {
+    Condition cond;
+    int cost = 1;              // relative evaluation cost
+    // Pre-parsed temporal operands ("recent"/"countWithin"/"rateWithin": eventA;
+    // "within": eventA → eventB)
+    std::string eventA;
+    std::string eventB;
+    int64_t windowMs = -1;     // -1 → malformed, always matches 0
+    double threshold = 0.0;    // min count ("countWithin") or events/min ("rateWithin")
+    ConditionStats stats;
+};
+
+/**
+ * Evaluation plan for one rule: the order its conditions are matched in.
+ * Periodically re-sorted by cost ÷ rejection rate so cheap, selective
+ * conditions run first. The product is order-independent, so results do not change.
+ */
+struct RulePlan {
+    std::vector<int> order;      // indices into Rule::conditions
+    std::vector<int> condIds;    // Rule::conditions[i] → index into the shared table
+    bool dirty = false;          // scored since last reorder
+};
+
 // ============================================================
 // Multi-Armed Bandit (epsilon-greedy)
 // ============================================================
@@ -168,9 +664,16 @@ public:
     /** Load stats from serialized data */
     void loadStats(const std::unordered_map<std::string, ArmStats>& stats);
 
+    /** Replace one arm's stats (state-log replay) */
+    void setArm(const std::string& actionId, const ArmStats& stats);
+
+    /** Reseed exploration (reproducible offline evaluation) */
+    void seed(uint32_t seed);
+
 private:
     double epsilon_;
     std::unordered_map<std::string, ArmStats> arms_;
+    std::mt19937 rng_{std::random_device{}()};
     mutable std::mutex mu_;
 };
 
@@ -203,6 +706,16 @@ public:
     /** Update arm with observed reward and the context that was active. */
     void update(const std::string& actionId, double reward, const ContextMap& ctx);
 
+    /** Update arm with an already-built feature vector (what update() logs and replays) */
+    void updateFeatures(const std::string& actionId, double reward,
+                        const std::array<double, LINUCB_DIM>& x);
+
+    /** Copy of every arm's state (state-log snapshot) */
+    std::unordered_map<std::string, LinUCBArm> arms() const;
+
+    /** Replace one arm's state (state-log replay) */
+    void setArm(const std::string& actionId, const LinUCBArm& arm);
+
     /** Export all arm state as JSON (for persistence). */
     std::string exportJson() const;
 
@@ -215,11 +728,143 @@ private:
     mutable std::mutex mu_;
 };
 
+// ============================================================
+// Learning-state write-ahead log
+// ============================================================
+
+/** One state-log record: a delta (log) or a full entry (snapshot) */
+struct StateRecord {
+    enum Type : uint8_t {
+        MabUpdate = 'M',      // id, reward
+        LinUCBUpdate = 'L',   // id, reward, x
+        Firing = 'F',         // id (rule), timeMs
+        ClearFirings = 'C',   // rules replaced: forget every lastFired
+        MabArm = 'm',         // id, pulls, totalReward
+        LinUCBArmState = 'l', // id, arm
+        Header = 'H',         // generation (first record of each file, internal)
+    };
+    Type type = MabUpdate;
+    std::string id;
+    double reward = 0.0;
+    std::array<double, LINUCB_DIM> x{};
+    int64_t timeMs = 0;       // steady-clock ms in memory, wall-clock ms on disk
+    ArmStats stats{0, 0.0};
+    LinUCBArm arm{};
+    uint32_t generation = 0;
+};
+
+/**
+ * Append-only log of bandit updates and rule firings, so learning state
+ * persists with O(1) I/O per update instead of a full export. Periodically
+ * compacted into a snapshot (written to a temp file, then renamed) after which
+ * the log is truncated. Both files start with a generation header, so a log
+ * already folded into the snapshot (crash between rename and truncate) is not
+ * replayed twice. Records are length- and checksum-framed; replay stops at a
+ * torn tail. Files: <dir>/<name>.{snap,wal}; the log is flock()ed while open,
+ * so a second log (this or another process) on the same files is refused.
+ */
+class StateLog {
+public:
+    /** Log records between automatic compactions */
+    static constexpr size_t COMPACT_RECORDS = 4096;
+
+    StateLog() = default;
+    ~StateLog();
+    StateLog(const StateLog&) = delete;
+    StateLog& operator=(const StateLog&) = delete;
+
+    /** File name prefix used when the caller does not give one */
+    static constexpr const char* DEFAULT_NAME = "context_engine_state";
+
+    /**
+     * Read the snapshot, then the log, calling fn for each record (oldest
+     * first), and open the log for appending. A torn tail is truncated.
+     * @returns records replayed, or -1 if the log cannot be opened, name is
+     *          not a plain file name, or another open log holds the files
+     */
+    int64_t open(const std::string& dir, const std::string& name,
+                 const std::function<void(const StateRecord&)>& fn);
+
+    bool isOpen() const;
+    void close();
+
+    /** Append one delta record (no-op while closed) */
+    void append(const StateRecord& record);
+
+    /** Records appended since the last compaction */
+    size_t pendingRecords() const;
+
+    /** Replace the snapshot with `records` and truncate the log */
+    bool compact(const std::vector<StateRecord>& records);
+
+private:
+    std::string snapPath() const { return base_ + ".snap"; }
+    std::string walPath() const { return base_ + ".wal"; }
+
+    /** Truncate the log and start it with the current generation header */
+    bool resetLog();
+
+    std::string base_;          // <dir>/<name>
+    int fd_ = -1;
+    size_t pending_ = 0;
+    uint32_t generation_ = 0;   // generation of the current snapshot
+    mutable std::mutex mu_;
+};
+
+// ============================================================
+// Offline policy evaluation
+// ============================================================
+
+/** One logged bandit decision: what was offered, what was chosen, what it earned */
+struct LoggedDecision {
+    ContextMap ctx;
+    std::vector<std::string> candidates;
+    int chosen = -1;            // index into candidates
+    double reward = 0.0;
+    double propensity = 0.0;    // P(chosen | ctx) under the logging policy; <= 0 = uniform
+};
+
+/** Policy to evaluate, built fresh for each run with the production select/update code */
+struct PolicySpec {
+    enum Kind { EpsilonGreedy, LinUCBPolicy };
+    Kind kind = EpsilonGreedy;
+    double param = 0.1;         // epsilon (EpsilonGreedy) or alpha (LinUCBPolicy)
+    std::string name;
+};
+
+/** Per-policy estimate of the mean reward per decision */
+struct PolicyEstimate {
+    std::string name;
+    size_t decisions = 0;       // usable logged decisions
+    size_t matched = 0;         // decisions where the policy chose the logged action
+    double replay = 0.0;        // mean reward over matched decisions (rejection replay)
+    double ips = 0.0;           // inverse propensity scoring
+    double snips = 0.0;         // self-normalized IPS
+    double ipsStdErr = 0.0;
+    double seconds = 0.0;
+};
+
+/**
+ * Replay a decision log through each policy. The policy selects among the
+ * logged candidates; only decisions where it agrees with the logged action
+ * are scored and fed back to update(), so learning policies are evaluated as
+ * they would have learned online. Policies run in parallel on up to `threads`
+ * threads (0 = hardware concurrency); `seed` fixes epsilon-greedy exploration.
+ * Results are in `policies` order.
+ */
+std::vector<PolicyEstimate> evaluatePolicies(const std::vector<LoggedDecision>& log,
+                                             const std::vector<PolicySpec>& policies,
+                                             int threads = 0, uint32_t seed = 1);
+
 // ============================================================
 // Soft matching
 // ============================================================
 
-/** Evaluate a single condition against context, returning 0~1 confidence */
+/**
+ * Evaluate a single condition against context, returning 0~1 confidence.
+ * A match on a value with quality q < 1 is pulled toward the missing-data 0.5
+ * (q = 0 counts as no reading); mismatches stay 0, so tree/bitmap pruning holds.
+ */
 double softMatch(const Condition& cond, const ContextMap& ctx);
 
 // ============================================================
@@ -234,21 +879,65 @@ public:
     /** Load rules (replaces all existing rules). Auto-compiles decision tree. */
     bool loadRules(const std::vector<Rule>& rules);
 
+    /**
+     * Load a built-in pack with `userRules` merged on top (same id replaces the
+     * pack rule, others are appended), then drop the rules in `removedIds`.
+     * Replaces all rules. Tree mode installs the pack's pre-built tree and patches
+     * the merged rules into it instead of compiling one.
+     */
+    bool loadRulePack(const RulePack& pack, const std::vector<Rule>& userRules = {},
+                      const std::vector<std::string>& removedIds = {});
+
     /** Add a single rule. Re-compiles tree. */
     bool addRule(const Rule& rule);
 
     /** Remove a rule by id. Re-compiles tree. */
     bool removeRule(const std::string& ruleId);
 
-    /** Evaluate context against all rules. Returns matches sorted by confidence × priority. */
-    std::vector<MatchResult> evaluate(const ContextMap& ctx, int maxResults = 5);
+    /**
+     * Evaluate context against all rules. Returns the top `maxResults` matches sorted
+     * by confidence × priority (ties: higher priority, then earlier rule).
+     * Candidates are scored best-bound first and scoring stops once the K-th result
+     * beats every remaining bound (priority × 1.0).
+     * @param budgetUs > 0: stop after this much time and return the best found so far
+     */
+    std::vector<MatchResult> evaluate(const ContextMap& ctx, int maxResults = 5,
+                                      int64_t budgetUs = 0);
 
     /** Push a context event into the event buffer (for recent/sequence conditions) */
     void pushEvent(const ContextEvent& event);
 
+    /**
+     * Earliest time (ms from now) at which evaluate(ctx) could return a different
+     * result while the sensed context stays the same: a clock-derived key
+     * (hour/minute/timeOfDay/dayOfWeek/isWeekend) crossing a condition threshold,
+     * a recent/within window expiring, a cooldown or rate-limit window ending.
+     * New events and context changes are not predicted; re-evaluate on those.
+     * @returns delay in ms (0 = now), or -1 if nothing time-dependent is pending
+     */
+    int64_t nextEvaluationDeadline(const ContextMap& ctx);
+
     /** Configure rate limits (category cooldown, global rate limit) */
     void setLimits(const RateLimits& limits);
 
+    /**
+     * Record user feedback: MAB update, plus a LinUCB update when ctx is given.
+     * Logged to the state log when one is open.
+     */
+    void updateReward(const std::string& actionId, double reward, const ContextMap* ctx = nullptr);
+
+    /**
+     * Restore bandit and cooldown state from dir's state log and keep logging
+     * updateReward deltas and rule firings there. Call after loadRules
+     * (loading rules clears cooldowns). Engines sharing a dir need distinct
+     * names; a log already held by another engine or process is refused.
+     * @returns records replayed (0 = fresh state), or -1 on I/O error or conflict
+     */
+    int64_t openStateLog(const std::string& dir, const std::string& name = StateLog::DEFAULT_NAME);
+
+    /** Snapshot current state and truncate the log (also runs automatically) */
+    bool compactStateLog();
+
     /** Get the MAB for external reward updates */
     MAB& mab() { return mab_; }
 
@@ -261,13 +950,106 @@ public:
     /** Export rules as JSON string */
     std::string exportRulesJson() const;
 
+    /**
+     * Rebuild the decision tree using the collected traffic profile.
+     * Later loadRules/addRule/removeRule keep using the profile.
+     */
+    void recompileWithProfile();
+
+    /** Export the traffic profile as JSON (for persistence). */
+    std::string exportProfileJson() const;
+
+    /** Import a persisted traffic profile. Does not recompile by itself. */
+    bool importProfileJson(const std::string& json);
+
+    /** Get evaluation counters */
+    EvalStats evalStats() const;
+
+    /** Reset evaluation counters */
+    void resetEvalStats();
+
+    /** Number of distinct conditions after sharing identical ones across rules */
+    size_t sharedConditionCount() const;
+
+    /**
+     * Switch candidate selection between the decision tree and the bitmap index.
+     * The index (or tree) for the new mode is built on switch.
+     */
+    void setEvalMode(EvalMode mode);
+
+    EvalMode evalMode() const;
+
 private:
+    /** A rule fires only if its combined confidence exceeds this */
+    static constexpr double MIN_CONFIDENCE = 0.1;
+    /** Evaluations between adaptive condition reorders */
+    static constexpr int REORDER_INTERVAL = 128;
+    /** Candidates scored between time-budget checks */
+    static constexpr int BUDGET_CHECK_INTERVAL = 16;
+
     void compileTree();
-    void evaluateNode(int nodeIdx, const ContextMap& ctx,
-                      std::vector<MatchResult>& results);
 
-    /** Evaluate a single condition, handling "recent"/"within" via event buffer */
-    double matchCondition(const Condition& cond, const ContextMap& ctx);
+    /**
+     * Install the pack's pre-built tree, pack rule i appearing as rules_[packToRule[i]]
+     * (-1: left out). Caller inserts other rules, then calls finishTree().
+     */
+    void installPackTree(const RulePack& pack, const std::vector<int>& packToRule);
+
+    /** Add rules_[ruleIdx] to the leaves compileTree() would put it in */
+    void insertTreeRule(int ruleIdx);
+
+    /** Track eq-condition keys in the profile and sort leaves by score bound */
+    void finishTree();
+
+    /** Snapshot and truncate the state log. Caller must hold mu_. */
+    bool compactStateLogLocked();
+
+    /** Append to the state log, compacting when it is full. Caller must hold mu_. */
+    void logState(const StateRecord& record);
+
+    /** Replace rules_ and reset plans and firing history (caller recompiles) */
+    void resetRules(std::vector<Rule> rules);
+
+    /** Leaf reached by ctx, or -1 */
+    int findLeaf(const ContextMap& ctx) const;
+
+    /** Upper bound of confidence × priority for a rule that fires (confidence ∈ (0.1, 1]) */
+    static double scoreBound(double priority) {
+        return priority >= 0.0 ? priority : priority * MIN_CONFIDENCE;
+    }
+
+    /** Recompute boundOrder_ / boundRank_ after a rule change */
+    void compileRuleOrder();
+
+    /** Lay the bitmap index out in bound order (clears the unordered tail) */
+    void rebuildBitmap();
+
+    /** Combined confidence of rules_[ruleIdx], matching conditions in plan order */
+    double matchRule(int ruleIdx, const ContextMap& ctx);
+
+    /** Re-sort the condition order of rules whose stats changed */
+    void reorderConditions();
+
+    /** Fresh authoring-order plan for a rule */
+    static RulePlan makePlan(const Rule& rule);
+
+    /** Rebuild the shared conditions and the active mode's index after a rule change */
+    void recompile();
+
+    /**
+     * Check cooldowns and rate limits, then soft-match one rule.
+     * @returns confidence if the rule fires (> MIN_CONFIDENCE), else 0
+     */
+    double scoreRule(int ruleIdx, const ContextMap& ctx, int64_t now);
+
+    /** Rebuild the shared condition table and every plan's condIds (keeps stats) */
+    void compileConditions();
+
+    /** Evaluate a shared condition, handling "recent"/"within" via event buffer */
+    double matchCondition(const SharedCondition& sc, const ContextMap& ctx);
+
+    /** Deadline contribution of clock-derived context keys (-1 if none) */
+    int64_t clockDeadline(const ContextMap& ctx) const;
 
     /** Check enhanced cooldown: category throttle + global rate limit */
     bool isRateLimited(const Action& action, int64_t now);
@@ -276,10 +1058,34 @@ private:
     void recordFiring(const Action& action, int64_t now);
 
     std::vector<Rule> rules_;
+    std::vector<RulePlan> plans_;          // parallel to rules_
+    std::vector<double> matchScratch_;     // per-condition matches of the rule being scored
+    std::vector<SharedCondition> sharedConds_;
+    // Per-evaluate memo: slot i is valid when memoEpoch_[i] == evalEpoch_
+    std::vector<double> memoValue_;
+    std::vector<uint32_t> memoEpoch_;
+    uint32_t evalEpoch_ = 0;
+    int evalsSinceReorder_ = 0;
+    bool reordered_ = false;               // plans adapted since the last loadRules
     std::vector<TreeNode> tree_;
+    // Rule indices by descending score bound (ties: lower index first), and its inverse
+    std::vector<int> boundOrder_;
+    std::vector<int> boundRank_;
+    EvalMode evalMode_ = EvalMode::Tree;
+    RuleBitmapIndex bitmap_;               // built only in Bitmap mode
+    // Bitmap position → rule index (-1 = dead). Positions < bitmapSorted_ follow
+    // boundOrder_; later ones were appended by addRule and are scored unordered.
+    std::vector<int> bitmapRules_;
+    std::vector<int> bitmapPos_;           // rule index → bitmap position
+    size_t bitmapSorted_ = 0;
+    std::vector<uint64_t> candidateBits_;  // scratch for bitmap candidates
+    ContextProfile profile_;
+    bool profileGuided_ = false;   // compileTree() consults profile_
+    EvalStats evalStats_;
     MAB mab_;
     LinUCB linucb_;
     std::unordered_map<std::string, int64_t> lastFired_;  // ruleId → timestamp
+    StateLog stateLog_;
     EventBuffer eventBuffer_;
     RateLimits rateLimits_;
 
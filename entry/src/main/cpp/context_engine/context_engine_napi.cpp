@@ -3,31 +3,84 @@
  *
  * Exposed functions:
  *   loadRules(rulesJson: string): boolean
+ *   loadRulePack(name: string, userRulesJson?: string,
+ *                removedIdsJson?: string): boolean  // built-in pack + user rules − removed
  *   addRule(ruleJson: string): boolean
  *   removeRule(ruleId: string): boolean
- *   evaluate(contextJson: string, maxResults?: number): string  // returns JSON
- *   updateReward(actionId: string, reward: number): void
+ *   evaluate(contextJson: string, maxResults?: number, budgetMs?: number): string  // returns JSON
+ *   evaluateFromTray(maxResults?: number, extraContextJson?: string, useQuality?: boolean,
+ *                    budgetMs?: number): string  // context read natively from the data tray
+ *   updateReward(actionId: string, reward: number, contextJson?: string): void
  *   getStats(): string  // MAB stats as JSON
- *   loadStats(statsJson: string): void
+ *   loadStats(statsJson: string): number  // arms loaded
  *   getRuleCount(): number
  *   exportRules(): string
+ *   exportRulePack(name: string): string    // built-in pack's rules, same format as exportRules
  *   pushEvent(eventJson: string): void      // push event to buffer
  *   setLimits(limitsJson: string): void      // configure rate limits
+ *   recompileWithProfile(): void             // rebuild tree from traffic profile
+ *   exportProfile(): string                  // traffic profile as JSON
+ *   importProfile(profileJson: string): boolean
+ *   getEvalStats(): string                   // evaluation counters as JSON
+ *   setEvalMode(mode: string): boolean       // "tree" | "bitmap"
+ *   getEvalMode(): string
+ *   nextEvaluationDeadline(contextJson: string): number  // ms until evaluate may change, -1 = none
+ *   openStateLog(dir: string, name?: string): number  // restore + log bandit/cooldown state; records replayed, -1 = error/held
+ *   compactStateLog(): boolean               // snapshot state, truncate the log
+ *
+ * Exposed class:
+ *   new ContextEngine()  — independent engine with the methods above; the plain
+ *                          functions operate on a shared module-level engine.
+ *                          A method invoked on another `this` throws.
  */
 #include <napi/native_api.h>
 #include "context_engine.h"
+#include "data_tray/data_tray.h"
+#include <dlfcn.h>
+#include <atomic>
 #include <string>
 #include <memory>
 #include <sstream>
 #include <chrono>
+#include <algorithm>
 
 // Simple JSON parsing helpers (no external deps)
 // For MVP we use a minimal approach — production could use nlohmann/json
 
 namespace {
 
+/** Module-level engine used by the plain function exports */
 context_engine::RuleEngine g_engine;
 
+/** Descriptor data marking the ContextEngine prototype methods */
+int g_methodTag = 0;
+
+/**
+ * Engine wrapped in `this` for a ContextEngine method. Throws and returns
+ * nullptr when `this` is not a ContextEngine instance.
+ */
+context_engine::RuleEngine* instanceEngine(napi_env env, napi_value thisArg) {
+    void* data = nullptr;
+    if (thisArg == nullptr || napi_unwrap(env, thisArg, &data) != napi_ok || data == nullptr) {
+        napi_throw_error(env, nullptr, "ContextEngine: method called on an object that is not a ContextEngine");
+        return nullptr;
+    }
+    return static_cast<context_engine::RuleEngine*>(data);
+}
+
+/**
+ * Engine a call operates on: the wrapped instance for ContextEngine methods
+ * (see instanceEngine), g_engine for the plain function exports.
+ * nullptr means an exception is pending.
+ */
+context_engine::RuleEngine* engineFor(napi_env env, napi_callback_info info) {
+    napi_value thisArg = nullptr;
+    void* tag = nullptr;
+    napi_get_cb_info(env, info, nullptr, nullptr, &thisArg, &tag);
+    if (tag == &g_methodTag) return instanceEngine(env, thisArg);
+    return &g_engine;
+}
+
 std::string napiGetString(napi_env env, napi_value val) {
     size_t len = 0;
     napi_get_value_string_utf8(env, val, nullptr, 0, &len);
@@ -229,11 +282,106 @@ context_engine::ContextMap parseContextMap(const std::string& json) {
     return ctx;
 }
 
+// Parse MAB stats JSON as written by getStats: {"actionId":{"pulls":n,"totalReward":r,...},...}
+std::unordered_map<std::string, context_engine::ArmStats> parseArmStats(const std::string& json) {
+    std::unordered_map<std::string, context_engine::ArmStats> stats;
+    size_t pos = json.find('{');
+    if (pos == std::string::npos) return stats;
+    pos++;
+    while (pos < json.size()) {
+        auto keyStart = json.find('"', pos);
+        if (keyStart == std::string::npos) break;
+        auto keyEnd = json.find('"', keyStart + 1);
+        if (keyEnd == std::string::npos) break;
+        auto objStart = json.find('{', keyEnd + 1);
+        if (objStart == std::string::npos) break;
+        auto objEnd = json.find('}', objStart + 1);
+        if (objEnd == std::string::npos) break;
+
+        std::string arm = json.substr(objStart, objEnd - objStart + 1);
+        int pulls = static_cast<int>(jsonGetNum(arm, "pulls", 0));
+        if (pulls > 0) {
+            stats[json.substr(keyStart + 1, keyEnd - keyStart - 1)] = {pulls, jsonGetNum(arm, "totalReward", 0)};
+        }
+        pos = objEnd + 1;
+    }
+    return stats;
+}
+
+/** Budget argument in ms → µs; capped at one minute, a budget that large is effectively unlimited */
+int64_t budgetUsFromMs(double budgetMs) {
+    return budgetMs > 0.0 ? static_cast<int64_t>(std::min(budgetMs, 60000.0) * 1000.0) : 0;
+}
+
+// Serialize match results as the JSON array evaluate() returns
+std::string resultsJson(const std::vector<context_engine::MatchResult>& results) {
+    std::ostringstream ss;
+    ss << "[";
+    for (size_t i = 0; i < results.size(); i++) {
+        if (i > 0) ss << ",";
+        ss << "{\"ruleId\":\"" << results[i].ruleId
+           << "\",\"confidence\":" << results[i].confidence
+           << ",\"action\":{\"id\":\"" << results[i].action.id
+           << "\",\"type\":\"" << results[i].action.type
+           << "\",\"payload\":\"" << results[i].action.payload << "\"}}";
+    }
+    ss << "]";
+    return ss.str();
+}
+
+/**
+ * The tray singleton owned by libdata_tray.so, or nullptr until ArkTS has
+ * imported that module (RTLD_NOLOAD: never loaded from here).
+ */
+data_tray::SensorDataTray* sharedTray() {
+    static std::atomic<data_tray::SensorDataTray*> tray{nullptr};
+    data_tray::SensorDataTray* cached = tray.load(std::memory_order_acquire);
+    if (cached != nullptr) return cached;
+
+    void* handle = dlopen("libdata_tray.so", RTLD_NOW | RTLD_NOLOAD);
+    if (handle == nullptr) return nullptr;
+    auto accessor = reinterpret_cast<data_tray::SharedTrayAccessor>(
+        dlsym(handle, data_tray::SHARED_TRAY_SYMBOL));
+    cached = accessor != nullptr ? accessor(sizeof(data_tray::SensorDataTray)) : nullptr;
+    // Drops only our reference; the module stays loaded for ArkTS
+    dlclose(handle);
+    tray.store(cached, std::memory_order_release);
+    return cached;
+}
+
+// Typed tray entries → ContextMap, no string round trip for numbers/booleans
+context_engine::ContextMap contextFromTray(const std::vector<data_tray::TrayEntry>& entries, bool useQuality) {
+    context_engine::ContextMap ctx;
+    ctx.reserve(entries.size());
+    for (const auto& entry : entries) {
+        context_engine::ContextValue value;
+        switch (entry.value.type) {
+            case data_tray::TrayValueType::Double:
+                value = context_engine::ContextValue(entry.value.number);
+                break;
+            case data_tray::TrayValueType::Int:
+                value = context_engine::ContextValue(entry.value.integer);
+                break;
+            case data_tray::TrayValueType::Bool:
+                value = context_engine::ContextValue(entry.value.integer != 0);
+                break;
+            default:
+                value = context_engine::ContextValue(entry.value.text);
+                break;
+        }
+        if (useQuality) value.setQuality(entry.quality);
+        ctx[entry.key] = std::move(value);
+    }
+    return ctx;
+}
+
 }  // namespace
 
 // NAPI functions
 
 static napi_value LoadRules(napi_env env, napi_callback_info info) {
+    auto* engine = engineFor(env, info);
+    if (engine == nullptr) return nullptr;
     size_t argc = 1;
     napi_value args[1];
     napi_get_cb_info(env, info, &argc, args, nullptr, nullptr);
@@ -243,11 +391,47 @@ static napi_value LoadRules(napi_env env, napi_callback_info info) {
     }
     auto json = napiGetString(env, args[0]);
     auto rules = parseRulesArray(json);
-    bool ok = g_engine.loadRules(rules);
+    bool ok = engine->loadRules(rules);
     return napiBool(env, ok);
 }
 
+// Parse simple JSON array of strings: ["id1","id2",...]
+static std::vector<std::string> parseStringArray(const std::string& json) {
+    std::vector<std::string> result;
+    size_t pos = 0;
+    while (pos < json.size()) {
+        auto qs = json.find('"', pos);
+        if (qs == std::string::npos) break;
+        auto qe = json.find('"', qs + 1);
+        if (qe == std::string::npos) break;
+        result.push_back(json.substr(qs + 1, qe - qs - 1));
+        pos = qe + 1;
+    }
+    return result;
+}
+
+static napi_value LoadRulePack(napi_env env, napi_callback_info info) {
+    auto* engine = engineFor(env, info);
+    if (engine == nullptr) return nullptr;
+    size_t argc = 3;
+    napi_value args[3];
+    napi_get_cb_info(env, info, &argc, args, nullptr, nullptr);
+    if (argc < 1) {
+        napi_throw_error(env, nullptr, "loadRulePack requires a pack name");
+        return nullptr;
+    }
+    const auto* pack = context_engine::findRulePack(napiGetString(env, args[0]));
+    if (pack == nullptr) return napiBool(env, false);
+    std::vector<context_engine::Rule> userRules;
+    if (argc > 1) userRules = parseRulesArray(napiGetString(env, args[1]));
+    std::vector<std::string> removedIds;
+    if (argc > 2) removedIds = parseStringArray(napiGetString(env, args[2]));
+    return napiBool(env, engine->loadRulePack(*pack, userRules, removedIds));
+}
+
 static napi_value AddRule(napi_env env, napi_callback_info info) {
+    auto* engine = engineFor(env, info);
+    if (engine == nullptr) return nullptr;
     size_t argc = 1;
     napi_value args[1];
     napi_get_cb_info(env, info, &argc, args, nullptr, nullptr);
@@ -257,11 +441,13 @@ static napi_value AddRule(napi_env env, napi_callback_info info) {
     }
     auto json = napiGetString(env, args[0]);
     auto rule = parseRule(json);
-    bool ok = g_engine.addRule(rule);
+    bool ok = engine->addRule(rule);
     return napiBool(env, ok);
 }
 
 static napi_value RemoveRule(napi_env env, napi_callback_info info) {
+    auto* engine = engineFor(env, info);
+    if (engine == nullptr) return nullptr;
     size_t argc = 1;
     napi_value args[1];
     napi_get_cb_info(env, info, &argc, args, nullptr, nullptr);
@@ -270,13 +456,15 @@ static napi_value RemoveRule(napi_env env, napi_callback_info info) {
         return nullptr;
     }
     auto ruleId = napiGetString(env, args[0]);
-    bool ok = g_engine.removeRule(ruleId);
+    bool ok = engine->removeRule(ruleId);
     return napiBool(env, ok);
 }
 
 static napi_value Evaluate(napi_env env, napi_callback_info info) {
-    size_t argc = 2;
-    napi_value args[2];
+    auto* engine = engineFor(env, info);
+    if (engine == nullptr) return nullptr;
+    size_t argc = 3;
+    napi_value args[3];
     napi_get_cb_info(env, info, &argc, args, nullptr, nullptr);
     if (argc < 1) {
         napi_throw_error(env, nullptr, "evaluate requires a context JSON string");
@@ -288,27 +476,65 @@ static napi_value Evaluate(napi_env env, napi_callback_info info) {
     if (argc > 1) {
         napi_get_value_int32(env, args[1], &maxResults);
     }
+    double budgetMs = 0.0;
+    if (argc > 2) {
+        napi_get_value_double(env, args[2], &budgetMs);
+    }
 
     auto ctx = parseContextMap(contextJson);
-    auto results = g_engine.evaluate(ctx, maxResults);
+    auto results = engine->evaluate(ctx, maxResults, budgetUsFromMs(budgetMs));
+    return napiString(env, resultsJson(results));
+}
 
-    // Build JSON result
-    std::ostringstream ss;
-    ss << "[";
-    for (size_t i = 0; i < results.size(); i++) {
-        if (i > 0) ss << ",";
-        ss << "{\"ruleId\":\"" << results[i].ruleId
-           << "\",\"confidence\":" << results[i].confidence
-           << ",\"action\":{\"id\":\"" << results[i].action.id
-           << "\",\"type\":\"" << results[i].action.type
-           << "\",\"payload\":\"" << results[i].action.payload << "\"}}";
+/**
+ * evaluate() on the data tray's current values, read in-process: no snapshot
+ * object, no context JSON. extraContextJson adds keys the tray does not hold
+ * (they override tray keys); useQuality feeds each value's effective tray
+ * quality into soft matching.
+ */
+static napi_value EvaluateFromTray(napi_env env, napi_callback_info info) {
+    auto* engine = engineFor(env, info);
+    if (engine == nullptr) return nullptr;
+    size_t argc = 4;
+    napi_value args[4];
+    napi_get_cb_info(env, info, &argc, args, nullptr, nullptr);
+
+    auto* tray = sharedTray();
+    if (tray == nullptr) {
+        napi_throw_error(env, nullptr, "evaluateFromTray: libdata_tray.so is not loaded");
+        return nullptr;
     }
-    ss << "]";
 
-    return napiString(env, ss.str());
+    int maxResults = 5;
+    if (argc > 0) {
+        napi_get_value_int32(env, args[0], &maxResults);
+    }
+    std::string extraJson;
+    if (argc > 1) {
+        napi_valuetype type;
+        napi_typeof(env, args[1], &type);
+        if (type == napi_string) extraJson = napiGetString(env, args[1]);
+    }
+    bool useQuality = false;
+    if (argc > 2) {
+        napi_get_value_bool(env, args[2], &useQuality);
+    }
+    double budgetMs = 0.0;
+    if (argc > 3) {
+        napi_get_value_double(env, args[3], &budgetMs);
+    }
+
+    auto ctx = contextFromTray(tray->readAll(), useQuality);
+    if (!extraJson.empty()) {
+        for (auto& [key, value] : parseContextMap(extraJson)) ctx[key] = std::move(value);
+    }
+    auto results = engine->evaluate(ctx, maxResults, budgetUsFromMs(budgetMs));
+    return napiString(env, resultsJson(results));
 }
 
 static napi_value UpdateReward(napi_env env, napi_callback_info info) {
+    auto* engine = engineFor(env, info);
+    if (engine == nullptr) return nullptr;
     size_t argc = 3;
     napi_value args[3];
     napi_get_cb_info(env, info, &argc, args, nullptr, nullptr);
@@ -320,21 +546,21 @@ static napi_value UpdateReward(napi_env env, napi_callback_info info) {
     double reward;
     napi_get_value_double(env, args[1], &reward);
 
-    // Always update MAB (backward compat)
-    g_engine.mab().update(actionId, reward);
-
-    // If context provided, also update LinUCB
+    // Always update MAB (backward compat); LinUCB too if context provided
     if (argc >= 3) {
-        auto contextJson = napiGetString(env, args[2]);
-        auto ctx = parseContextMap(contextJson);
-        g_engine.linucb().update(actionId, reward, ctx);
+        auto ctx = parseContextMap(napiGetString(env, args[2]));
+        engine->updateReward(actionId, reward, &ctx);
+    } else {
+        engine->updateReward(actionId, reward);
     }
 
     return nullptr;
 }
 
 static napi_value GetStats(napi_env env, napi_callback_info info) {
-    auto stats = g_engine.mab().getStats();
+    auto* engine = engineFor(env, info);
+    if (engine == nullptr) return nullptr;
+    auto stats = engine->mab().getStats();
     std::ostringstream ss;
     ss << "{";
     bool first = true;
@@ -350,45 +576,50 @@ static napi_value GetStats(napi_env env, napi_callback_info info) {
 }
 
 static napi_value LoadStats(napi_env env, napi_callback_info info) {
+    auto* engine = engineFor(env, info);
+    if (engine == nullptr) return nullptr;
     size_t argc = 1;
     napi_value args[1];
     napi_get_cb_info(env, info, &argc, args, nullptr, nullptr);
     if (argc < 1) return nullptr;
 
-    auto json = napiGetString(env, args[0]);
-    // Minimal parse of stats JSON
-    std::unordered_map<std::string, context_engine::ArmStats> stats;
-    // TODO: proper parsing for loadStats
-    g_engine.mab().loadStats(stats);
-    return nullptr;
+    auto stats = parseArmStats(napiGetString(env, args[0]));
+    engine->mab().loadStats(stats);
+    napi_value val;
+    napi_create_int32(env, static_cast<int>(stats.size()), &val);
+    return val;
 }
 
 static napi_value GetRuleCount(napi_env env, napi_callback_info info) {
+    auto* engine = engineFor(env, info);
+    if (engine == nullptr) return nullptr;
     napi_value val;
-    napi_create_int32(env, static_cast<int>(g_engine.ruleCount()), &val);
+    napi_create_int32(env, static_cast<int>(engine->ruleCount()), &val);
     return val;
 }
 
 static napi_value ExportRules(napi_env env, napi_callback_info info) {
-    return napiString(env, g_engine.exportRulesJson());
+    auto* engine = engineFor(env, info);
+    if (engine == nullptr) return nullptr;
+    return napiString(env, engine->exportRulesJson());
 }
 
-// Parse simple JSON array of strings: ["id1","id2",...]
-static std::vector<std::string> parseStringArray(const std::string& json) {
-    std::vector<std::string> result;
-    size_t pos = 0;
-    while (pos < json.size()) {
-        auto qs = json.find('"', pos);
-        if (qs == std::string::npos) break;
-        auto qe = json.find('"', qs + 1);
-        if (qe == std::string::npos) break;
-        result.push_back(json.substr(qs + 1, qe - qs - 1));
-        pos = qe + 1;
+static napi_value ExportRulePack(napi_env env, napi_callback_info info) {
+    size_t argc = 1;
+    napi_value args[1];
+    napi_get_cb_info(env, info, &argc, args, nullptr, nullptr);
+    if (argc < 1) {
+        napi_throw_error(env, nullptr, "exportRulePack requires a pack name");
+        return nullptr;
     }
-    return result;
+    const auto* pack = context_engine::findRulePack(napiGetString(env, args[0]));
+    if (pack == nullptr) return napiString(env, "[]");
+    return napiString(env, context_engine::rulesToJson(context_engine::packRules(*pack)));
 }
 
 static napi_value SelectAction(napi_env env, napi_callback_info info) {
+    auto* engine = engineFor(env, info);
+    if (engine == nullptr) return nullptr;
     size_t argc = 2;
     napi_value args[2];
     napi_get_cb_info(env, info, &argc, args, nullptr, nullptr);
@@ -405,10 +636,10 @@ static napi_value SelectAction(napi_env env, napi_callback_info info) {
         // Context provided → use LinUCB
         auto contextJson = napiGetString(env, args[1]);
         auto ctx = parseContextMap(contextJson);
-        idx = g_engine.linucb().select(actionIds, ctx);
+        idx = engine->linucb().select(actionIds, ctx);
     } else {
         // No context → fallback to epsilon-greedy MAB
-        idx = g_engine.mab().select(actionIds);
+        idx = engine->mab().select(actionIds);
     }
 
     napi_value val;
@@ -417,20 +648,26 @@ static napi_value SelectAction(napi_env env, napi_callback_info info) {
 }
 
 static napi_value ExportLinUCB(napi_env env, napi_callback_info info) {
-    return napiString(env, g_engine.linucb().exportJson());
+    auto* engine = engineFor(env, info);
+    if (engine == nullptr) return nullptr;
+    return napiString(env, engine->linucb().exportJson());
 }
 
 static napi_value ImportLinUCB(napi_env env, napi_callback_info info) {
+    auto* engine = engineFor(env, info);
+    if (engine == nullptr) return nullptr;
     size_t argc = 1;
     napi_value args[1];
     napi_get_cb_info(env, info, &argc, args, nullptr, nullptr);
     if (argc < 1) return nullptr;
     auto json = napiGetString(env, args[0]);
-    g_engine.linucb().importJson(json);
+    engine->linucb().importJson(json);
     return nullptr;
 }
 
 static napi_value PushEvent(napi_env env, napi_callback_info info) {
+    auto* engine = engineFor(env, info);
+    if (engine == nullptr) return nullptr;
     size_t argc = 1;
     napi_value args[1];
     napi_get_cb_info(env, info, &argc, args, nullptr, nullptr);
@@ -463,11 +700,13 @@ static napi_value PushEvent(napi_env env, napi_callback_info info) {
         }
     }
 
-    g_engine.pushEvent(event);
+    engine->pushEvent(event);
     return nullptr;
 }
 
 static napi_value SetLimits(napi_env env, napi_callback_info info) {
+    auto* engine = engineFor(env, info);
+    if (engine == nullptr) return nullptr;
     size_t argc = 1;
     napi_value args[1];
     napi_get_cb_info(env, info, &argc, args, nullptr, nullptr);
@@ -486,31 +725,189 @@ static napi_value SetLimits(napi_env env, napi_callback_info info) {
     limits.globalMaxPerHour = static_cast<int>(
         jsonGetNum(json, "globalMaxPerHour", 10));
 
-    g_engine.setLimits(limits);
+    engine->setLimits(limits);
     return nullptr;
 }
 
+static napi_value RecompileWithProfile(napi_env env, napi_callback_info info) {
+    auto* engine = engineFor(env, info);
+    if (engine == nullptr) return nullptr;
+    engine->recompileWithProfile();
+    return nullptr;
+}
+
+static napi_value ExportProfile(napi_env env, napi_callback_info info) {
+    auto* engine = engineFor(env, info);
+    if (engine == nullptr) return nullptr;
+    return napiString(env, engine->exportProfileJson());
+}
+
+static napi_value ImportProfile(napi_env env, napi_callback_info info) {
+    auto* engine = engineFor(env, info);
+    if (engine == nullptr) return nullptr;
+    size_t argc = 1;
+    napi_value args[1];
+    napi_get_cb_info(env, info, &argc, args, nullptr, nullptr);
+    if (argc < 1) {
+        napi_throw_error(env, nullptr, "importProfile requires a JSON string");
+        return nullptr;
+    }
+    auto json = napiGetString(env, args[0]);
+    return napiBool(env, engine->importProfileJson(json));
+}
+
+static napi_value GetEvalStats(napi_env env, napi_callback_info info) {
+    auto* engine = engineFor(env, info);
+    if (engine == nullptr) return nullptr;
+    auto stats = engine->evalStats();
+    double avgRules = stats.evaluations > 0
+        ? static_cast<double>(stats.rulesEvaluated) / stats.evaluations : 0.0;
+    double avgConds = stats.rulesEvaluated > 0
+        ? static_cast<double>(stats.conditionsEvaluated) / stats.rulesEvaluated : 0.0;
+    std::ostringstream ss;
+    ss << "{\"evaluations\":" << stats.evaluations
+       << ",\"rulesEvaluated\":" << stats.rulesEvaluated
+       << ",\"avgRulesPerEval\":" << avgRules
+       << ",\"conditionsEvaluated\":" << stats.conditionsEvaluated
+       << ",\"avgCondsPerRule\":" << avgConds
+       << ",\"memoHits\":" << stats.memoHits
+       << ",\"sharedConditions\":" << engine->sharedConditionCount()
+       << ",\"reorders\":" << stats.reorders
+       << ",\"boundStops\":" << stats.boundStops
+       << ",\"budgetStops\":" << stats.budgetStops
+       << ",\"condsPerRuleBeforeReorder\":" << stats.condsPerRuleBefore()
+       << ",\"condsPerRuleAfterReorder\":" << stats.condsPerRuleAfter() << "}";
+    return napiString(env, ss.str());
+}
+
+static napi_value SetEvalMode(napi_env env, napi_callback_info info) {
+    auto* engine = engineFor(env, info);
+    if (engine == nullptr) return nullptr;
+    size_t argc = 1;
+    napi_value args[1];
+    napi_get_cb_info(env, info, &argc, args, nullptr, nullptr);
+    if (argc < 1) {
+        napi_throw_error(env, nullptr, "setEvalMode requires \"tree\" or \"bitmap\"");
+        return nullptr;
+    }
+    auto mode = napiGetString(env, args[0]);
+    if (mode == "tree") {
+        engine->setEvalMode(context_engine::EvalMode::Tree);
+    } else if (mode == "bitmap") {
+        engine->setEvalMode(context_engine::EvalMode::Bitmap);
+    } else {
+        return napiBool(env, false);
+    }
+    return napiBool(env, true);
+}
+
+static napi_value GetEvalMode(napi_env env, napi_callback_info info) {
+    auto* engine = engineFor(env, info);
+    if (engine == nullptr) return nullptr;
+    return napiString(env, engine->evalMode() == context_engine::EvalMode::Bitmap ? "bitmap" : "tree");
+}
+
+static napi_value NextEvaluationDeadline(napi_env env, napi_callback_info info) {
+    auto* engine = engineFor(env, info);
+    if (engine == nullptr) return nullptr;
+    size_t argc = 1;
+    napi_value args[1];
+    napi_get_cb_info(env, info, &argc, args, nullptr, nullptr);
+    if (argc < 1) {
+        napi_throw_error(env, nullptr, "nextEvaluationDeadline requires a context JSON string");
+        return nullptr;
+    }
+    auto ctx = parseContextMap(napiGetString(env, args[0]));
+    napi_value result;
+    napi_create_int64(env, engine->nextEvaluationDeadline(ctx), &result);
+    return result;
+}
+
+static napi_value OpenStateLog(napi_env env, napi_callback_info info) {
+    auto* engine = engineFor(env, info);
+    if (engine == nullptr) return nullptr;
+    size_t argc = 2;
+    napi_value args[2];
+    napi_get_cb_info(env, info, &argc, args, nullptr, nullptr);
+    if (argc < 1) {
+        napi_throw_error(env, nullptr, "openStateLog requires a directory path");
+        return nullptr;
+    }
+    std::string name = argc >= 2 ? napiGetString(env, args[1]) : context_engine::StateLog::DEFAULT_NAME;
+    napi_value result;
+    napi_create_int64(env, engine->openStateLog(napiGetString(env, args[0]), name), &result);
+    return result;
+}
+
+static napi_value CompactStateLog(napi_env env, napi_callback_info info) {
+    auto* engine = engineFor(env, info);
+    if (engine == nullptr) return nullptr;
+    return napiBool(env, engine->compactStateLog());
+}
+
+// ContextEngine class: independent instances (own rules, limits, bandits, event buffer)
+
+static void EngineFinalize(napi_env env, void* data, void* hint) {
+    delete static_cast<context_engine::RuleEngine*>(data);
+}
+
+static napi_value EngineConstructor(napi_env env, napi_callback_info info) {
+    napi_value thisArg = nullptr;
+    napi_get_cb_info(env, info, nullptr, nullptr, &thisArg, nullptr);
+    auto* engine = new context_engine::RuleEngine();
+    if (napi_wrap(env, thisArg, engine, EngineFinalize, nullptr, nullptr) != napi_ok) {
+        delete engine;
+        napi_throw_error(env, nullptr, "ContextEngine: failed to wrap native engine");
+        return nullptr;
+    }
+    return thisArg;
+}
+
 // Module registration
 
 EXTERN_C_START
 static napi_value Init(napi_env env, napi_value exports) {
     napi_property_descriptor desc[] = {
         {"loadRules",    nullptr, LoadRules,    nullptr, nullptr, nullptr, napi_default, nullptr},
+        {"loadRulePack", nullptr, LoadRulePack, nullptr, nullptr, nullptr, napi_default, nullptr},
         {"addRule",      nullptr, AddRule,      nullptr, nullptr, nullptr, napi_default, nullptr},
         {"removeRule",   nullptr, RemoveRule,   nullptr, nullptr, nullptr, napi_default, nullptr},
         {"evaluate",     nullptr, Evaluate,     nullptr, nullptr, nullptr, napi_default, nullptr},
+        {"evaluateFromTray", nullptr, EvaluateFromTray, nullptr, nullptr, nullptr, napi_default, nullptr},
         {"updateReward", nullptr, UpdateReward, nullptr, nullptr, nullptr, napi_default, nullptr},
         {"selectAction", nullptr, SelectAction, nullptr, nullptr, nullptr, napi_default, nullptr},
         {"getStats",     nullptr, GetStats,     nullptr, nullptr, nullptr, napi_default, nullptr},
         {"loadStats",    nullptr, LoadStats,    nullptr, nullptr, nullptr, napi_default, nullptr},
         {"getRuleCount", nullptr, GetRuleCount, nullptr, nullptr, nullptr, napi_default, nullptr},
         {"exportRules",  nullptr, ExportRules,  nullptr, nullptr, nullptr, napi_default, nullptr},
+        {"exportRulePack", nullptr, ExportRulePack, nullptr, nullptr, nullptr, napi_default, nullptr},
         {"exportLinUCB", nullptr, ExportLinUCB, nullptr, nullptr, nullptr, napi_default, nullptr},
         {"importLinUCB", nullptr, ImportLinUCB, nullptr, nullptr, nullptr, napi_default, nullptr},
         {"pushEvent",    nullptr, PushEvent,    nullptr, nullptr, nullptr, napi_default, nullptr},
         {"setLimits",    nullptr, SetLimits,    nullptr, nullptr, nullptr, napi_default, nullptr},
+        {"recompileWithProfile", nullptr, RecompileWithProfile, nullptr, nullptr, nullptr, napi_default, nullptr},
+        {"exportProfile", nullptr, ExportProfile, nullptr, nullptr, nullptr, napi_default, nullptr},
+        {"importProfile", nullptr, ImportProfile, nullptr, nullptr, nullptr, napi_default, nullptr},
+        {"getEvalStats", nullptr, GetEvalStats, nullptr, nullptr, nullptr, napi_default, nullptr},
+        {"setEvalMode",  nullptr, SetEvalMode,  nullptr, nullptr, nullptr, napi_default, nullptr},
+        {"getEvalMode",  nullptr, GetEvalMode,  nullptr, nullptr, nullptr, napi_default, nullptr},
+        {"nextEvaluationDeadline", nullptr, NextEvaluationDeadline, nullptr, nullptr, nullptr, napi_default, nullptr},
+        {"openStateLog", nullptr, OpenStateLog, nullptr, nullptr, nullptr, napi_default, nullptr},
+        {"compactStateLog", nullptr, CompactStateLog, nullptr, nullptr, nullptr, napi_default, nullptr},
     };
-    napi_define_properties(env, exports, sizeof(desc) / sizeof(desc[0]), desc);
+    size_t count = sizeof(desc) / sizeof(desc[0]);
+    napi_define_properties(env, exports, count, desc);
+
+    // Same callbacks as prototype methods, tagged so engineFor() requires the wrapped instance
+    napi_property_descriptor methods[sizeof(desc) / sizeof(desc[0])];
+    for (size_t i = 0; i < count; i++) {
+        methods[i] = desc[i];
+        methods[i].data = &g_methodTag;
+    }
+    napi_value engineClass;
+    napi_define_class(env, "ContextEngine", NAPI_AUTO_LENGTH, EngineConstructor, nullptr,
+                      count, methods, &engineClass);
+    napi_set_named_property(env, exports, "ContextEngine", engineClass);
     return exports;
 }
 EXTERN_C_END
@@ -0,0 +1,167 @@
+/**
+ * context_profile.cpp — 流量画像 (context value distributions)
+ *
+ * 记录 evaluate 时各 split 候选 key 的取值频率，供 recompileWithProfile()
+ * 按期望评估代价重建决策树。持久化为 JSON，由 ArkTS 保存/恢复。
+ */
+#include "context_engine.h"
+#include <sstream>
+
+namespace context_engine {
+
+void ContextProfile::setTrackedKeys(const std::vector<std::string>& keys) {
+    tracked_.clear();
+    tracked_.reserve(keys.size());
+    for (const auto& key : keys) {
+        tracked_.emplace_back(key, &keys_[key]);
+    }
+}
+
+void ContextProfile::record(const ContextMap& ctx) {
+    samples_++;
+    for (auto& [key, stats] : tracked_) {
+        stats->total++;
+        auto it = ctx.find(key);
+        if (it == ctx.end()) {
+            stats->missing++;
+            continue;
+        }
+        auto valIt = stats->values.find(it->second);
+        if (valIt != stats->values.end()) {
+            valIt->second++;
+        } else if (stats->values.size() < MAX_VALUES_PER_KEY) {
+            stats->values.emplace(it->second, 1);
+        } else {
+            stats->other++;
+        }
+    }
+}
+
+double ContextProfile::probability(const std::string& key, const std::string& value,
+                                   size_t numValues) const {
+    int64_t count = 0;
+    int64_t total = 0;
+    auto it = keys_.find(key);
+    if (it != keys_.end()) {
+        const auto& stats = it->second;
+        total = stats.total;
+        auto valIt = stats.values.find(value);
+        if (valIt != stats.values.end()) count = valIt->second;
+    }
+    // +1 slot for "missing / any other value"
+    return (static_cast<double>(count) + 1.0) /
+           (static_cast<double>(total) + static_cast<double>(numValues) + 1.0);
+}
+
+void ContextProfile::clear() {
+    samples_ = 0;
+    for (auto& [key, stats] : keys_) {
+        stats.total = 0;
+        stats.missing = 0;
+        stats.other = 0;
+        stats.values.clear();
+    }
+}
+
+std::string ContextProfile::toJson() const {
+    std::ostringstream ss;
+    ss << "{\"samples\":" << samples_ << ",\"keys\":{";
+    bool firstKey = true;
+    for (const auto& [key, stats] : keys_) {
+        if (!firstKey) ss << ",";
+        firstKey = false;
+        ss << "\"" << key << "\":{\"missing\":" << stats.missing
+           << ",\"other\":" << stats.other << ",\"values\":{";
+        bool firstVal = true;
+        for (const auto& [value, count] : stats.values) {
+            if (!firstVal) ss << ",";
+            firstVal = false;
+            ss << "\"" << value << "\":" << count;
+        }
+        ss << "}}";
+    }
+    ss << "}}";
+    return ss.str();
+}
+
+// Find the matching '}' for the '{' at openPos; returns npos if unbalanced
+static size_t matchBrace(const std::string& json, size_t openPos) {
+    int depth = 1;
+    size_t pos = openPos + 1;
+    while (pos < json.size() && depth > 0) {
+        if (json[pos] == '{') depth++;
+        else if (json[pos] == '}') depth--;
+        pos++;
+    }
+    return depth == 0 ? pos - 1 : std::string::npos;
+}
+
+static int64_t numberAfter(const std::string& json, const std::string& key) {
+    auto pos = json.find("\"" + key + "\"");
+    if (pos == std::string::npos) return 0;
+    auto colon = json.find(':', pos);
+    if (colon == std::string::npos) return 0;
+    return static_cast<int64_t>(safe_stod(json.substr(colon + 1, 24), 0.0));
+}
+
+bool ContextProfile::fromJson(const std::string& json) {
+    auto keysPos = json.find("\"keys\"");
+    if (keysPos == std::string::npos) return false;
+    auto keysOpen = json.find('{', keysPos);
+    if (keysOpen == std::string::npos) return false;
+    auto keysClose = matchBrace(json, keysOpen);
+    if (keysClose == std::string::npos) return false;
+
+    clear();
+    samples_ = numberAfter(json.substr(0, keysPos), "samples");
+
+    // Each entry: "key":{"missing":M,"other":O,"values":{"v":C,...}}
+    size_t pos = keysOpen + 1;
+    while (pos < keysClose) {
+        auto qStart = json.find('"', pos);
+        if (qStart == std::string::npos || qStart >= keysClose) break;
+        auto qEnd = json.find('"', qStart + 1);
+        if (qEnd == std::string::npos) break;
+        std::string key = json.substr(qStart + 1, qEnd - qStart - 1);
+
+        auto objOpen = json.find('{', qEnd);
+        if (objOpen == std::string::npos || objOpen >= keysClose) break;
+        auto objClose = matchBrace(json, objOpen);
+        if (objClose == std::string::npos) break;
+        std::string obj = json.substr(objOpen, objClose - objOpen + 1);
+
+        auto& stats = keys_[key];
+        auto valuesPos = obj.find("\"values\"");
+        stats.missing = numberAfter(obj.substr(0, valuesPos), "missing");
+        stats.other = numberAfter(obj.substr(0, valuesPos), "other");
+
+        if (valuesPos != std::string::npos) {
+            auto valOpen = obj.find('{', valuesPos);
+            auto valClose = valOpen == std::string::npos ? std::string::npos : matchBrace(obj, valOpen);
+            size_t vp = valOpen == std::string::npos ? obj.size() : valOpen + 1;
+            while (valClose != std::string::npos && vp < valClose) {
+                auto vs = obj.find('"', vp);
+                if (vs == std::string::npos || vs >= valClose) break;
+                auto ve = obj.find('"', vs + 1);
+                if (ve == std::string::npos) break;
+                auto colon = obj.find(':', ve);
+                if (colon == std::string::npos) break;
+                auto next = obj.find_first_of(",}", colon);
+                int64_t count = static_cast<int64_t>(
+                    safe_stod(obj.substr(colon + 1, next - colon - 1), 0.0));
+                if (stats.values.size() < MAX_VALUES_PER_KEY) {
+                    stats.values[obj.substr(vs + 1, ve - vs - 1)] = count;
+                } else {
+                    stats.other += count;
+                }
+                vp = next == std::string::npos ? valClose : next + 1;
+            }
+        }
+        stats.total = stats.missing + stats.other;
+        for (const auto& [value, count] : stats.values) stats.total += count;
+        pos = objClose + 1;
+    }
+    return true;
+}
+
+}  // namespace context_engine
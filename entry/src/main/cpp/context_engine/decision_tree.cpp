@@ -6,40 +6,42 @@
  *   2. 按 cost-aware ordering 选择 split key (便宜的特征优先)
  *   3. 递归构建子树
  *
- * Cost ordering (cheap → expensive):
- *   timeOfDay, dayOfWeek, isWeekend < motionState < batteryLevel < geofence < location
+ * Profile-guided mode (recompileWithProfile):
+ *   用 evaluate 时收集的取值分布估计每个 split 的期望剩余规则数，
+ *   score = 期望剪枝规则数 ÷ (1 + cost)，使树形贴合真实流量。
+ *
+ * Leaf rule lists are sorted by score bound (priority) for branch-and-bound.
+ *
+ * Built-in rule packs ship the static tree pre-built (gen_rule_packs.py mirrors
+ * pickSplitKey / build below); installPackTree() loads it without compiling,
+ * masking overlaid pack rules, and insertTreeRule() places the overlay into it.
+ *
+ * Cost ordering (cheap → expensive), from the key registry (data_tray/context_keys.h):
+ *   time features < device state < motion (and unknown keys) < location
  */
 #include "context_engine.h"
+#include "data_tray/context_keys.h"
 #include <algorithm>
 #include <unordered_set>
 
 namespace context_engine {
 
 // Feature cost: lower = cheaper to evaluate (prefer splitting on cheap features first)
-static int featureCost(const std::string& key) {
-    // Time features: pure computation, zero cost
-    if (key == "timeOfDay" || key == "dayOfWeek" || key == "isWeekend" ||
-        key == "hour" || key == "minute") return 0;
-    // Device state: already available
-    if (key == "batteryLevel" || key == "isCharging" || key == "networkType") return 1;
-    // Motion: sensor, low power
-    if (key == "motionState" || key == "stepCount") return 2;
-    // Location: GPS, higher power
-    if (key == "geofence" || key == "location" || key == "latitude" || key == "longitude") return 3;
-    // Unknown features: medium cost
-    return 2;
-}
+using data_tray::featureCost;
 
 /** Pick the best split key for a set of rules.
- *  Heuristic: maximize coverage (rules using this key) ÷ cost */
+ *  Heuristic: maximize coverage (rules using this key) ÷ cost.
+ *  Ties go to the key seen first, so the tree does not depend on hash order
+ *  (gen_rule_packs.py reproduces it for pre-built packs). */
 static std::string pickSplitKey(const std::vector<Rule>& rules,
                                  const std::vector<int>& indices,
                                  const std::unordered_set<std::string>& usedKeys) {
     std::unordered_map<std::string, int> keyCount;
+    std::vector<const std::string*> seenOrder;
     for (int idx : indices) {
         for (const auto& cond : rules[idx].conditions) {
             if (usedKeys.count(cond.key) == 0) {
-                keyCount[cond.key]++;
+                if (keyCount[cond.key]++ == 0) seenOrder.push_back(&cond.key);
             }
         }
     }
@@ -48,9 +50,54 @@ static std::string pickSplitKey(const std::vector<Rule>& rules,
 
     std::string bestKey;
     double bestScore = -1.0;
-    for (const auto& [key, count] : keyCount) {
+    for (const std::string* key : seenOrder) {
         // Score = coverage / (1 + cost)
-        double score = static_cast<double>(count) / (1.0 + featureCost(key));
+        double score = static_cast<double>(keyCount[*key]) / (1.0 + featureCost(*key));
+        if (score > bestScore) {
+            bestScore = score;
+            bestKey = *key;
+        }
+    }
+    return bestKey;
+}
+
+/** Profile-guided split selection.
+ *  After splitting on key k, a context with value v visits group_v + noCond rules,
+ *  any other value (or a missing key) visits noCond rules only:
+ *    E[rules | k] = noCond + Σ_v P(v) · |group_v|
+ *  Score = (n − E[rules | k]) ÷ (1 + cost), i.e. expected rules pruned per unit cost.
+ *  P(v) uses marginal frequencies (keys assumed independent along the path). */
+static std::string pickSplitKeyProfiled(const std::vector<Rule>& rules,
+                                         const std::vector<int>& indices,
+                                         const std::unordered_set<std::string>& usedKeys,
+                                         const ContextProfile& profile) {
+    // key → (value → rules with `key eq value`)
+    std::unordered_map<std::string, std::unordered_map<std::string, int>> groups;
+    for (int idx : indices) {
+        const auto& conds = rules[idx].conditions;
+        for (size_t c = 0; c < conds.size(); c++) {
+            const auto& cond = conds[c];
+            if (cond.op != "eq" || usedKeys.count(cond.key) != 0) continue;
+            // build() places a rule by its first eq condition on the key
+            bool earlier = false;
+            for (size_t e = 0; e < c && !earlier; e++) {
+                earlier = conds[e].key == cond.key && conds[e].op == "eq";
+            }
+            if (!earlier) groups[cond.key][cond.value]++;
+        }
+    }
+
+    std::string bestKey;
+    double bestScore = 0.0;
+    const double n = static_cast<double>(indices.size());
+    for (const auto& [key, byValue] : groups) {
+        int grouped = 0;
+        for (const auto& [value, count] : byValue) grouped += count;
+        double expected = n - grouped;  // noCond rules are always visited
+        for (const auto& [value, count] : byValue) {
+            expected += profile.probability(key, value, byValue.size()) * count;
+        }
+        double score = (n - expected) / (1.0 + featureCost(key));
         if (score > bestScore) {
             bestScore = score;
             bestKey = key;
@@ -60,6 +107,8 @@ static std::string pickSplitKey(const std::vector<Rule>& rules,
 }
 
 void RuleEngine::compileTree() {
+    compileConditions();
+    compileRuleOrder();
     tree_.clear();
     if (rules_.empty()) return;
 
@@ -78,13 +127,16 @@ void RuleEngine::compileTree() {
     struct BuildContext {
         const std::vector<Rule>& rules;
         std::vector<TreeNode>& tree;
+        const ContextProfile* profile;   // nullptr → static coverage heuristic
 
         int build(const std::vector<int>& indices, std::unordered_set<std::string> usedKeys) {
             int nodeIdx = static_cast<int>(tree.size());
             tree.push_back(TreeNode{});
 
             // Find best split key
-            std::string splitKey = pickSplitKey(rules, indices, usedKeys);
+            std::string splitKey = profile
+                ? pickSplitKeyProfiled(rules, indices, usedKeys, *profile)
+                : pickSplitKey(rules, indices, usedKeys);
 
             // Leaf if: no good split, or few rules, or max depth reached
             if (splitKey.empty() || indices.size() <= 2 || usedKeys.size() >= 5) {
@@ -144,8 +196,110 @@ void RuleEngine::compileTree() {
         }
     };
 
-    BuildContext ctx{rules_, tree_};
+    BuildContext ctx{rules_, tree_, profileGuided_ ? &profile_ : nullptr};
     ctx.build(allIndices, {});
+    finishTree();
+}
+
+void RuleEngine::installPackTree(const RulePack& pack, const std::vector<int>& packToRule) {
+    // Caller must hold mu_
+    compileConditions();
+    compileRuleOrder();
+    tree_.clear();
+    tree_.resize(pack.nodeCount);
+    for (size_t n = 0; n < pack.nodeCount; n++) {
+        const auto& src = pack.nodes[n];
+        auto& node = tree_[n];
+        node.splitKey = src.splitKeyId >= 0 ? pack.keys[src.splitKeyId] : "";
+        node.defaultChild = src.defaultChild;
+        node.branches.reserve(src.branchCount);
+        for (uint32_t b = 0; b < src.branchCount; b++) {
+            const auto& branch = pack.branches[src.firstBranch + b];
+            node.branches.emplace_back(branch.value, branch.child);
+        }
+        node.ruleIndices.reserve(src.leafRuleCount);
+        for (uint32_t r = 0; r < src.leafRuleCount; r++) {
+            int ruleIdx = packToRule[pack.leafRules[src.firstLeafRule + r]];
+            if (ruleIdx >= 0) node.ruleIndices.push_back(ruleIdx);
+        }
+    }
+}
+
+void RuleEngine::insertTreeRule(int ruleIdx) {
+    // Caller must hold mu_. Same placement as build(): under the branch of the rule's
+    // first eq condition on the split key, in every child if it has none. A value
+    // without a branch goes to the default child, where such contexts land.
+    const Rule& rule = rules_[ruleIdx];
+    std::vector<int> pending{0};
+    while (!pending.empty()) {
+        int nodeIdx = pending.back();
+        pending.pop_back();
+        if (tree_[nodeIdx].splitKey.empty()) {
+            tree_[nodeIdx].ruleIndices.push_back(ruleIdx);
+            continue;
+        }
+
+        const std::string* value = nullptr;
+        for (const auto& cond : rule.conditions) {
+            if (cond.key == tree_[nodeIdx].splitKey && cond.op == "eq") {
+                value = &cond.value.str();
+                break;
+            }
+        }
+        int child = -1;
+        for (const auto& [branchValue, branchChild] : tree_[nodeIdx].branches) {
+            if (value == nullptr) {
+                pending.push_back(branchChild);
+            } else if (branchValue == *value) {
+                child = branchChild;
+                break;
+            }
+        }
+        if (child < 0) {
+            if (tree_[nodeIdx].defaultChild < 0) {
+                tree_[nodeIdx].defaultChild = static_cast<int>(tree_.size());
+                tree_.push_back(TreeNode{"", {}, -1, {}});
+            }
+            child = tree_[nodeIdx].defaultChild;
+        }
+        pending.push_back(child);
+    }
+}
+
+void RuleEngine::finishTree() {
+    // Caller must hold mu_. Track the keys a split can branch on (eq conditions)
+    // in the traffic profile
+    std::unordered_set<std::string> eqKeys;
+    for (const auto& rule : rules_) {
+        if (!rule.enabled) continue;
+        for (const auto& cond : rule.conditions) {
+            if (cond.op == "eq") eqKeys.insert(cond.key);
+        }
+    }
+    profile_.setTrackedKeys(std::vector<std::string>(eqKeys.begin(), eqKeys.end()));
+
+    // Leaves list rules best score bound first for branch-and-bound evaluation
+    for (auto& node : tree_) {
+        if (!node.splitKey.empty()) continue;
+        std::sort(node.ruleIndices.begin(), node.ruleIndices.end(),
+                  [&](int a, int b) { return boundRank_[a] < boundRank_[b]; });
+    }
+}
+
+void RuleEngine::recompileWithProfile() {
+    std::lock_guard<std::mutex> lock(mu_);
+    profileGuided_ = true;
+    if (evalMode_ == EvalMode::Tree) compileTree();  // Bitmap mode: applied on switch back
+}
+
+std::string RuleEngine::exportProfileJson() const {
+    std::lock_guard<std::mutex> lock(mu_);
+    return profile_.toJson();
+}
+
+bool RuleEngine::importProfileJson(const std::string& json) {
+    std::lock_guard<std::mutex> lock(mu_);
+    return profile_.fromJson(json);
 }
 
 }  // namespace context_engine
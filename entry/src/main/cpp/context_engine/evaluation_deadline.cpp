@@ -0,0 +1,155 @@
+/**
+ * evaluation_deadline.cpp — 下次评估时间计算
+ *
+ * nextEvaluationDeadline(ctx): 在上下文不变的前提下，evaluate 结果最早可能
+ * 变化的时刻。ArkTS 据此精确定时唤醒，替代固定间隔轮询:
+ *   1. 时钟派生 key (hour/minute/timeOfDay/dayOfWeek/isWeekend) 跨越条件阈值
+ *   2. recent/within 窗口内的事件过期
+ *   3. 规则 cooldown、类别节流、全局限流窗口结束
+ */
+#include "context_engine.h"
+#include <cmath>
+#include <chrono>
+#include <ctime>
+
+namespace context_engine {
+
+static int64_t nowMs() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Same buckets as ContextAwarenessService.refreshTray()
+static const char* timeOfDayFor(int hour) {
+    if (hour >= 5 && hour < 12) return "morning";
+    if (hour >= 12 && hour < 17) return "afternoon";
+    if (hour >= 17 && hour < 21) return "evening";
+    return "night";
+}
+
+static constexpr int MINUTES_PER_DAY = 24 * 60;
+
+int64_t RuleEngine::clockDeadline(const ContextMap& ctx) const {
+    // Caller must hold mu_
+    bool hasHour = ctx.count("hour") != 0;
+    bool hasMinute = ctx.count("minute") != 0;
+    bool hasTimeOfDay = ctx.count("timeOfDay") != 0;
+    bool hasDay = ctx.count("dayOfWeek") != 0 || ctx.count("isWeekend") != 0;
+
+    // Conditions whose value can change as the wall clock advances
+    std::vector<std::pair<const Condition*, double>> clockConds;  // (condition, current match)
+    bool minuteGranular = false;
+    bool dayConds = false;
+    for (const auto& sc : sharedConds_) {
+        const auto& key = sc.cond.key;
+        if ((key == "hour" && hasHour) || (key == "timeOfDay" && hasTimeOfDay)) {
+            clockConds.emplace_back(&sc.cond, softMatch(sc.cond, ctx));
+        } else if (key == "minute" && hasMinute) {
+            clockConds.emplace_back(&sc.cond, softMatch(sc.cond, ctx));
+            minuteGranular = true;
+        } else if ((key == "dayOfWeek" || key == "isWeekend") && hasDay) {
+            dayConds = true;
+        }
+    }
+    if (clockConds.empty() && !dayConds) return -1;
+
+    auto wallNow = std::chrono::system_clock::now();
+    std::time_t tt = std::chrono::system_clock::to_time_t(wallNow);
+    std::tm local{};
+    localtime_r(&tt, &local);
+    int64_t msIntoMinute = local.tm_sec * 1000LL +
+        std::chrono::duration_cast<std::chrono::milliseconds>(wallNow.time_since_epoch()).count() % 1000;
+    int minuteOfDay = local.tm_hour * 60 + local.tm_min;
+    auto msUntil = [&](int minutesAhead) { return minutesAhead * 60000LL - msIntoMinute; };
+
+    // Day keys flip at midnight; conservatively wake then
+    int64_t best = dayConds ? msUntil(MINUTES_PER_DAY - minuteOfDay) : -1;
+
+    // Walk minute (or hour) boundaries over the next day until some condition changes
+    if (!clockConds.empty()) {
+        int step = minuteGranular ? 1 : 60;
+        int first = minuteGranular ? 1 : 60 - local.tm_min;
+        ContextMap probe;
+        for (int ahead = first; ahead <= MINUTES_PER_DAY; ahead += step) {
+            if (best >= 0 && msUntil(ahead) >= best) break;
+            int t = (minuteOfDay + ahead) % MINUTES_PER_DAY;
+            if (hasHour) probe["hour"] = std::to_string(t / 60);
+            if (hasMinute) probe["minute"] = std::to_string(t % 60);
+            if (hasTimeOfDay) probe["timeOfDay"] = timeOfDayFor(t / 60);
+
+            bool changed = false;
+            for (const auto& [cond, current] : clockConds) {
+                if (softMatch(*cond, probe) != current) {
+                    changed = true;
+                    break;
+                }
+            }
+            if (changed) {
+                best = msUntil(ahead);
+                break;
+            }
+        }
+    }
+    return best;
+}
+
+int64_t RuleEngine::nextEvaluationDeadline(const ContextMap& ctx) {
+    std::lock_guard<std::mutex> lock(mu_);
+    int64_t now = nowMs();
+    int64_t best = -1;
+    auto consider = [&best](int64_t delayMs) {
+        if (delayMs < 0) delayMs = 0;
+        if (best < 0 || delayMs < best) best = delayMs;
+    };
+
+    // 1. Clock-derived keys
+    int64_t clock = clockDeadline(ctx);
+    if (clock >= 0) consider(clock);
+
+    // 2. Temporal conditions currently matching stop matching when their event ages out
+    //    (hasRecent keeps an event while timestamp ≥ now − window)
+    //    countWithin/rateWithin stop matching once enough old buckets leave the window
+    for (const auto& sc : sharedConds_) {
+        if (sc.windowMs < 0) continue;
+        if (sc.cond.op == "countWithin" || sc.cond.op == "rateWithin") {
+            double minCount = sc.cond.op == "countWithin"
+                ? sc.threshold : sc.threshold * static_cast<double>(sc.windowMs) / 60000.0;
+            if (minCount <= 0.0) continue;  // always matches
+            int64_t dropsAt = eventBuffer_.countDropsAt(
+                sc.eventA, sc.windowMs, static_cast<int64_t>(std::ceil(minCount - 1e-9)));
+            if (dropsAt >= 0) consider(dropsAt - now);
+            continue;
+        }
+        int64_t ts = sc.cond.op == "recent"
+            ? eventBuffer_.lastSeen(sc.eventA, sc.windowMs)
+            : eventBuffer_.sequenceStart(sc.eventA, sc.eventB, sc.windowMs);
+        if (ts >= 0) consider(ts + sc.windowMs + 1 - now);
+    }
+
+    // 3. Per-rule cooldowns
+    for (const auto& rule : rules_) {
+        if (!rule.enabled || rule.cooldownMs <= 0) continue;
+        auto lastIt = lastFired_.find(rule.id);
+        if (lastIt == lastFired_.end()) continue;
+        int64_t readyAt = lastIt->second + rule.cooldownMs;
+        if (readyAt > now) consider(readyAt - now);
+    }
+
+    // 4. Rate limits lift once enough in-window firings expire
+    //    (isRateLimited drops timestamps < now − window and blocks while count ≥ limit)
+    auto limitLifts = [&](const std::deque<int64_t>& firings, int64_t windowMs, int limit) {
+        size_t first = 0;
+        while (first < firings.size() && firings[first] < now - windowMs) first++;
+        size_t inWindow = firings.size() - first;
+        if (limit <= 0 || inWindow < static_cast<size_t>(limit)) return;
+        consider(firings[first + (inWindow - limit)] + windowMs + 1 - now);
+    };
+    for (const auto& [type, firings] : categoryFirings_) {
+        limitLifts(firings, rateLimits_.categoryCooldownWindowMs, rateLimits_.categoryCooldownCount);
+    }
+    limitLifts(globalFirings_, 3600000, rateLimits_.globalMaxPerHour);
+
+    return best;
+}
+
+}  // namespace context_engine
@@ -0,0 +1,403 @@
+/**
+ * event_buffer.cpp — 列式事件环形缓冲
+ *
+ * 每个事件只存三列: timestamp / 类型 ID (字典) / context 偏移。
+ * context 以 (keyId, valueId) 字典编码 (各 16 位，合成一个字) 写入 arena，
+ * 相对上一个事件只记差量，每 KEYFRAME_INTERVAL 个写一次全量关键帧。
+ * 列和 arena 按需倍增，上限按 24h 事件量设定；字典是单个字符池 + 开放寻址 id 表。
+ * 另按类型维护 秒/分/时 三级分桶计数，countWithin/rateWithin 无需扫描。
+ * 24h 内既无保留事件也无计数的类型每小时 (或类型数翻倍时) 清除并重新编号。
+ */
+#include "context_engine.h"
+#include <algorithm>
+#include <chrono>
+
+namespace context_engine {
+
+// Counter tiers: resolution, first bucket in TypeCounters, bucket count
+struct CounterTier {
+    int64_t resolutionMs;
+    size_t offset;
+    size_t buckets;
+};
+static constexpr CounterTier COUNTER_TIERS[] = {
+    {1000, 0, 60},        // last minute by second
+    {60000, 60, 60},      // last hour by minute
+    {3600000, 120, 24},   // last day by hour
+};
+
+static int64_t steadyNowMs() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// ============================================================
+// StringPool
+// ============================================================
+
+uint32_t EventBuffer::StringPool::find(std::string_view s) const {
+    if (slots.empty()) return NONE;
+    size_t mask = slots.size() - 1;
+    for (size_t h = std::hash<std::string_view>{}(s) & mask;; h = (h + 1) & mask) {
+        uint32_t id = slots[h];
+        if (id == NONE || at(id) == s) return id;
+    }
+}
+
+uint32_t EventBuffer::StringPool::intern(std::string_view s) {
+    uint32_t id = find(s);
+    if (id != NONE) return id;
+    id = static_cast<uint32_t>(ends.size());
+    chars.append(s);
+    ends.push_back(static_cast<uint32_t>(chars.size()));
+
+    // Keep the table at most half full; on growth reinsert every id
+    bool rehash = 2 * ends.size() > slots.size();
+    if (rehash) slots.assign(std::max<size_t>(16, 2 * slots.size()), NONE);
+    size_t mask = slots.size() - 1;
+    for (uint32_t i = rehash ? 0 : id; i <= id; i++) {
+        size_t h = std::hash<std::string_view>{}(at(i)) & mask;
+        while (slots[h] != NONE) h = (h + 1) & mask;
+        slots[h] = i;
+    }
+    return id;
+}
+
+void EventBuffer::StringPool::clear() {
+    chars.clear();
+    ends.clear();
+    slots.clear();
+}
+
+size_t EventBuffer::StringPool::memoryBytes() const {
+    return chars.capacity() + (ends.capacity() + slots.capacity()) * sizeof(uint32_t);
+}
+
+// ============================================================
+// EventBuffer
+// ============================================================
+
+EventBuffer::EventBuffer(size_t capacity, size_t arenaWords)
+    : capacity_(capacity > 0 ? capacity : 1),
+      arenaLimit_(arenaWords > 0 ? arenaWords : 1) {}
+
+void EventBuffer::push(const ContextEvent& event) {
+    std::lock_guard<std::mutex> lock(mu_);
+    expireOld();
+
+    uint32_t type = typeNames_.find(event.eventType);
+    if (type == NONE) {
+        if (typeNames_.size() >= pruneAtTypes_) {
+            pruneTypes(steadyNowMs() - MAX_AGE_MS);
+            pruneAtTypes_ = std::max(PRUNE_TYPES_AT, 2 * typeNames_.size());
+        }
+        type = typeNames_.intern(event.eventType);
+        counters_.emplace_back();
+    }
+    countEvent(type, event.timestampMs);
+
+    if (count_ == timestamps_.size()) {
+        if (timestamps_.size() < capacity_) {
+            growColumns();
+        } else {
+            head_ = (head_ + 1) % timestamps_.size();  // overwrite oldest
+            count_--;
+        }
+    }
+    size_t s = slot(count_);
+    timestamps_[s] = event.timestampMs;
+    types_[s] = type;
+    ctxOffsets_[s] = event.context.empty() ? NONE : appendContext(event.context);
+    count_++;
+}
+
+uint32_t EventBuffer::appendContext(const ContextMap& ctx) {
+    // Caller must hold mu_
+    if (valueNames_.size() + ctx.size() > MAX_DICT_VALUES ||
+        keyNames_.size() + ctx.size() > MAX_DICT_VALUES) {
+        // Dictionary full: drop every stored context and start over with a keyframe
+        keyNames_.clear();
+        valueNames_.clear();
+        lastContext_.clear();
+        arenaFloor_ = arenaWritten_;  // invalidates all offsets
+        sinceKeyframe_ = KEYFRAME_INTERVAL;
+    }
+
+    // Current context as keyId → valueId (reuses the previous pass's storage)
+    std::vector<uint32_t>& current = scratch_;
+    current.assign(keyNames_.size(), NONE);
+    for (const auto& [key, value] : ctx) {
+        uint32_t keyId = keyNames_.intern(key);
+        if (keyId >= current.size()) current.resize(keyId + 1, NONE);
+        current[keyId] = valueNames_.intern(value.str());
+    }
+    lastContext_.resize(current.size(), NONE);
+
+    // A delta is only decodable if the previous context is still in the arena
+    bool keyframe = ++sinceKeyframe_ >= KEYFRAME_INTERVAL;
+    uint32_t count = 0;
+    for (size_t k = 0; k < current.size(); k++) {
+        if (keyframe ? current[k] != NONE : current[k] != lastContext_[k]) count++;
+    }
+    size_t words = 1 + static_cast<size_t>(count);
+    if (words > arenaLimit_ / 4) return NONE;  // pathological context: don't record
+    if (keyframe) sinceKeyframe_ = 0;
+    growArena(words);
+
+    uint32_t offset = arenaWritten_;
+    auto put = [&](uint32_t w) { arena_[arenaWritten_++ % arena_.size()] = w; };
+    put(count | (keyframe ? KEYFRAME_FLAG : 0));
+    for (size_t k = 0; k < current.size(); k++) {
+        if (keyframe ? current[k] != NONE : current[k] != lastContext_[k]) {
+            put(static_cast<uint32_t>(k) << 16 | (current[k] == NONE ? ABSENT_VALUE : current[k]));
+        }
+    }
+    lastContext_.swap(current);
+    if (static_cast<uint32_t>(arenaWritten_ - arenaFloor_) > arena_.size()) {
+        arenaFloor_ = arenaWritten_ - static_cast<uint32_t>(arena_.size());  // wrapped over the oldest
+    }
+    return offset;
+}
+
+void EventBuffer::growColumns() {
+    // Caller must hold mu_ and the ring must be full (count_ == allocated slots)
+    size_t slots = std::min(capacity_, std::max(INITIAL_SLOTS, 2 * timestamps_.size()));
+    auto unroll = [this, slots](auto& column) {
+        std::rotate(column.begin(), column.begin() + static_cast<std::ptrdiff_t>(head_), column.end());
+        column.resize(slots);
+    };
+    unroll(timestamps_);
+    unroll(types_);
+    unroll(ctxOffsets_);
+    head_ = 0;
+}
+
+void EventBuffer::growArena(size_t words) {
+    // Caller must hold mu_
+    size_t needed = static_cast<uint32_t>(arenaWritten_ - arenaFloor_) + words;
+    if (needed <= arena_.size() || arena_.size() >= arenaLimit_) return;
+    size_t size = std::max(INITIAL_ARENA_WORDS, arena_.size());
+    while (size < needed && size < arenaLimit_) size *= 2;
+    size = std::min(size, arenaLimit_);
+
+    // Offsets are positions in the unbounded word stream; re-place the valid range
+    std::vector<uint32_t> grown(size);
+    for (uint32_t o = arenaFloor_; o != arenaWritten_; o++) grown[o % size] = arenaAt(o);
+    arena_.swap(grown);
+}
+
+ContextMap EventBuffer::contextAt(size_t i) const {
+    std::lock_guard<std::mutex> lock(mu_);
+    ContextMap result;
+    if (i >= count_ || ctxOffsets_[slot(i)] == NONE) return result;
+
+    // Walk back to the nearest keyframe, then replay deltas forward
+    size_t start = i;
+    while (true) {
+        uint32_t offset = ctxOffsets_[slot(start)];
+        if (offset != NONE) {
+            if (!arenaValid(offset)) return result;
+            if (arenaAt(offset) & KEYFRAME_FLAG) break;
+        }
+        if (start == 0) return result;  // keyframe already left the ring
+        start--;
+    }
+
+    std::vector<uint32_t> state(keyNames_.size(), NONE);
+    for (size_t e = start; e <= i; e++) {
+        uint32_t offset = ctxOffsets_[slot(e)];
+        if (offset == NONE) continue;
+        uint32_t header = arenaAt(offset);
+        uint32_t count = header & ~KEYFRAME_FLAG;
+        if (header & KEYFRAME_FLAG) std::fill(state.begin(), state.end(), NONE);
+        for (uint32_t p = 0; p < count; p++) {
+            uint32_t pair = arenaAt(offset + 1 + p);
+            uint32_t value = pair & 0xFFFFu;
+            state[pair >> 16] = value == ABSENT_VALUE ? NONE : value;
+        }
+    }
+    for (size_t k = 0; k < state.size(); k++) {
+        if (state[k] != NONE) {
+            result.emplace(std::string(keyNames_.at(static_cast<uint32_t>(k))), std::string(valueNames_.at(state[k])));
+        }
+    }
+    return result;
+}
+
+uint32_t EventBuffer::findType(const std::string& eventType) const {
+    return typeNames_.find(eventType);
+}
+
+int64_t EventBuffer::latestOf(uint32_t type, int64_t cutoff, int64_t before) const {
+    // Caller must hold mu_. Search backward (most recent first) for efficiency
+    for (size_t i = count_; i-- > 0;) {
+        size_t s = slot(i);
+        if (timestamps_[s] < cutoff) break;  // all older events are before cutoff
+        if (types_[s] == type && timestamps_[s] < before) return timestamps_[s];
+    }
+    return -1;
+}
+
+bool EventBuffer::hasRecent(const std::string& eventType, int64_t withinMs) const {
+    return lastSeen(eventType, withinMs) >= 0;
+}
+
+bool EventBuffer::hasSequence(const std::string& eventA, const std::string& eventB,
+                              int64_t withinMs) const {
+    return sequenceStart(eventA, eventB, withinMs) >= 0;
+}
+
+int64_t EventBuffer::lastSeen(const std::string& eventType, int64_t withinMs) const {
+    std::lock_guard<std::mutex> lock(mu_);
+    uint32_t type = findType(eventType);
+    if (type == NONE) return -1;
+    return latestOf(type, steadyNowMs() - withinMs, INT64_MAX);
+}
+
+int64_t EventBuffer::sequenceStart(const std::string& eventA, const std::string& eventB,
+                                   int64_t withinMs) const {
+    std::lock_guard<std::mutex> lock(mu_);
+    uint32_t typeA = findType(eventA);
+    uint32_t typeB = findType(eventB);
+    if (typeA == NONE || typeB == NONE) return -1;
+    int64_t cutoff = steadyNowMs() - withinMs;
+
+    // Find latest B within window, then the latest A before it
+    int64_t latestB = latestOf(typeB, cutoff, INT64_MAX);
+    if (latestB < 0) return -1;
+    return latestOf(typeA, cutoff, latestB);
+}
+
+void EventBuffer::countEvent(uint32_t type, int64_t timestampMs) {
+    // Caller must hold mu_
+    if (timestampMs < 0) return;
+    auto& counters = counters_[type];
+    for (const auto& tier : COUNTER_TIERS) {
+        int64_t index = timestampMs / tier.resolutionMs;
+        auto& bucket = counters[tier.offset + static_cast<size_t>(index) % tier.buckets];
+        if (bucket.index == index) {
+            bucket.count++;
+        } else if (bucket.index < index) {
+            bucket.index = index;  // stale bucket from an earlier lap
+            bucket.count = 1;
+        }
+        // else: older than this tier's span
+    }
+}
+
+template <typename Fn>
+void EventBuffer::forEachWindowBucket(uint32_t type, int64_t now, int64_t withinMs,
+                                      Fn&& fn) const {
+    // Caller must hold mu_. Calls fn(bucketEndMs, count) oldest first for every
+    // non-empty bucket overlapping (now − withinMs, now]
+    const CounterTier* tier = &COUNTER_TIERS[0];
+    for (const auto& t : COUNTER_TIERS) {
+        tier = &t;
+        if (withinMs <= t.resolutionMs * static_cast<int64_t>(t.buckets)) break;
+    }
+    const auto& counters = counters_[type];
+    int64_t newest = now / tier->resolutionMs;
+    int64_t oldest = std::max(newest - static_cast<int64_t>(tier->buckets) + 1,
+                              std::max<int64_t>(now - withinMs, 0) / tier->resolutionMs);
+    for (int64_t index = oldest; index <= newest; index++) {
+        const auto& bucket = counters[tier->offset + static_cast<size_t>(index) % tier->buckets];
+        if (bucket.index == index && bucket.count > 0) {
+            fn((index + 1) * tier->resolutionMs, static_cast<int64_t>(bucket.count));
+        }
+    }
+}
+
+int64_t EventBuffer::countWithin(const std::string& eventType, int64_t withinMs) const {
+    std::lock_guard<std::mutex> lock(mu_);
+    uint32_t type = findType(eventType);
+    if (type == NONE || withinMs <= 0) return 0;
+    int64_t total = 0;
+    forEachWindowBucket(type, steadyNowMs(), withinMs,
+                        [&total](int64_t, int64_t count) { total += count; });
+    return total;
+}
+
+double EventBuffer::rateWithin(const std::string& eventType, int64_t withinMs) const {
+    if (withinMs <= 0) return 0.0;
+    return static_cast<double>(countWithin(eventType, withinMs)) * 60000.0 /
+           static_cast<double>(withinMs);
+}
+
+int64_t EventBuffer::countDropsAt(const std::string& eventType, int64_t withinMs,
+                                  int64_t minCount) const {
+    std::lock_guard<std::mutex> lock(mu_);
+    uint32_t type = findType(eventType);
+    if (type == NONE || withinMs <= 0) return -1;
+
+    // A bucket leaves the window once now − withinMs reaches its end
+    std::vector<std::pair<int64_t, int64_t>> buckets;  // (endMs, count), oldest first
+    int64_t total = 0;
+    forEachWindowBucket(type, steadyNowMs(), withinMs, [&](int64_t endMs, int64_t count) {
+        buckets.emplace_back(endMs, count);
+        total += count;
+    });
+    if (total < minCount) return -1;
+    for (const auto& [endMs, count] : buckets) {
+        total -= count;
+        if (total < minCount) return endMs + withinMs;
+    }
+    return -1;
+}
+
+size_t EventBuffer::size() const {
+    std::lock_guard<std::mutex> lock(mu_);
+    return count_;
+}
+
+size_t EventBuffer::memoryBytes() const {
+    std::lock_guard<std::mutex> lock(mu_);
+    size_t bytes = timestamps_.capacity() * sizeof(int64_t) +
+                   (types_.capacity() + ctxOffsets_.capacity()) * sizeof(uint32_t) +
+                   arena_.capacity() * sizeof(uint32_t) +
+                   (lastContext_.capacity() + scratch_.capacity()) * sizeof(uint32_t) +
+                   counters_.capacity() * sizeof(TypeCounters);
+    return bytes + typeNames_.memoryBytes() + keyNames_.memoryBytes() + valueNames_.memoryBytes();
+}
+
+void EventBuffer::expireOld() {
+    // Caller must hold mu_
+    int64_t now = steadyNowMs();
+    int64_t cutoff = now - MAX_AGE_MS;
+    while (count_ > 0 && timestamps_[head_] < cutoff) {
+        head_ = (head_ + 1) % timestamps_.size();
+        count_--;
+    }
+    int64_t hour = now / COUNTER_TIERS[2].resolutionMs;
+    if (hour != pruneHour_) {
+        pruneHour_ = hour;
+        pruneTypes(cutoff);
+    }
+}
+
+void EventBuffer::pruneTypes(int64_t cutoff) {
+    // Caller must hold mu_. remap: old id → new id, NONE = dead
+    std::vector<uint32_t> remap(typeNames_.size(), NONE);
+    for (size_t i = 0; i < count_; i++) remap[types_[slot(i)]] = 0;
+    const auto& hours = COUNTER_TIERS[2];
+    for (uint32_t t = 0; t < remap.size(); t++) {
+        for (size_t b = 0; b < hours.buckets && remap[t] == NONE; b++) {
+            const auto& bucket = counters_[t][hours.offset + b];
+            if (bucket.count > 0 && (bucket.index + 1) * hours.resolutionMs > cutoff) remap[t] = 0;
+        }
+    }
+    if (std::find(remap.begin(), remap.end(), NONE) == remap.end()) return;
+
+    // Live types keep their order, so new ids never exceed old ones
+    StringPool live;
+    for (uint32_t t = 0; t < remap.size(); t++) {
+        if (remap[t] == NONE) continue;
+        remap[t] = live.intern(typeNames_.at(t));
+        counters_[remap[t]] = counters_[t];
+    }
+    typeNames_ = std::move(live);
+    counters_.resize(typeNames_.size());
+    counters_.shrink_to_fit();
+    for (size_t i = 0; i < count_; i++) types_[slot(i)] = remap[types_[slot(i)]];
+}
+
+}  // namespace context_engine
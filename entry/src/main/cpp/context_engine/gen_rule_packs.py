@@ -0,0 +1,262 @@
+#!/usr/bin/env python3
+"""
+gen_rule_packs.py — 内置规则包生成器 (run by CMake when python3 is available)
+
+Turns rule-pack JSON (same format as loadRules) into constexpr C++ tables
+so built-in packs load via RuleEngine::loadRulePack() without JSON parsing.
+Fields follow the NAPI parseRule(): id, name, action{id,type,payload},
+priority (1.0), cooldownMs (0), enabled (true), conditions[{key,op,value}].
+Conditions with an empty key are dropped; excludeConditions is ArkTS-only.
+
+The static decision tree is pre-built here too. build_tree() mirrors
+RuleEngine::compileTree() without a traffic profile (decision_tree.cpp:
+pickSplitKey, BuildContext::build); keep them in sync. Ties between equally
+good split keys go to the first key seen. Feature costs are read from the key
+registry (data_tray/context_keys.h), and the output static_asserts each cost it
+used against data_tray::featureCost, so a stale copy fails to compile.
+
+CMake generates into the build directory. A copy is checked in
+(context_engine/rule_packs.cpp) for builds without python3; the
+check_rule_packs target fails when it is stale. Regenerate it with:
+  python3 gen_rule_packs.py rule_packs.cpp \
+      default=../../resources/rawfile/config/default_rules.json
+
+Usage: gen_rule_packs.py [--keys context_keys.h] OUTPUT.cpp NAME=PACK.json [...]
+"""
+import json
+import os
+import re
+import sys
+
+KEYS_HEADER = os.path.join(os.path.dirname(os.path.abspath(__file__)),
+                           '..', 'data_tray', 'context_keys.h')
+
+
+def c_string(value):
+    """C++ string literal; UTF-8 passes through unchanged."""
+    out = ['"']
+    for ch in str(value):
+        if ch == '\\':
+            out.append('\\\\')
+        elif ch == '"':
+            out.append('\\"')
+        elif ch == '\n':
+            out.append('\\n')
+        elif ch == '\r':
+            out.append('\\r')
+        elif ch == '\t':
+            out.append('\\t')
+        elif ord(ch) < 0x20:
+            out.append('\\%03o' % ord(ch))
+        else:
+            out.append(ch)
+    out.append('"')
+    return ''.join(out)
+
+
+def c_double(value):
+    text = repr(float(value))
+    return text if ('.' in text or 'e' in text or 'inf' in text or 'nan' in text) else text + '.0'
+
+
+def identifier(name):
+    return 'k' + ''.join(part[:1].upper() + part[1:] for part in
+                         ''.join(c if c.isalnum() else '_' for c in name).split('_') if part)
+
+
+def load_feature_costs(path):
+    """Cost column of KEYS and FALLBACK_FEATURE_COST from context_keys.h."""
+    with open(path, encoding='utf-8') as f:
+        text = f.read()
+    costs = dict((key, int(cost)) for key, cost in re.findall(
+        r'\{"(\w+)",\s*TrayValueType::\w+,\s*[^,]+,\s*(\d+),', text))
+    fallback = re.search(r'FALLBACK_FEATURE_COST\s*=\s*(\d+)', text)
+    if not costs or not fallback:
+        raise SystemExit('%s: no KEYS table / FALLBACK_FEATURE_COST found' % path)
+    return costs, int(fallback.group(1))
+
+
+FEATURE_COSTS, FALLBACK_FEATURE_COST = {}, 2
+
+
+def feature_cost(key):
+    return FEATURE_COSTS.get(key, FALLBACK_FEATURE_COST)
+
+
+def pick_split_key(conditions, indices, used_keys):
+    key_count = {}
+    for idx in indices:
+        for key, _, _ in conditions[idx]:
+            if key not in used_keys:
+                key_count[key] = key_count.get(key, 0) + 1
+    best_key, best_score = '', -1.0
+    for key, count in key_count.items():
+        score = count / (1.0 + feature_cost(key))
+        if score > best_score:
+            best_key, best_score = key, score
+    return best_key
+
+
+def build_tree(conditions, enabled):
+    """Nodes as (splitKey, [(value, child)], defaultChild, leafRules)."""
+    tree = []
+
+    def build(indices, used_keys):
+        node = len(tree)
+        tree.append(None)
+        split_key = pick_split_key(conditions, indices, used_keys)
+        if not split_key or len(indices) <= 2 or len(used_keys) >= 5:
+            tree[node] = ('', [], -1, list(indices))
+            return node
+
+        groups = {}
+        no_condition = []
+        for idx in indices:
+            for key, op, value in conditions[idx]:
+                if key == split_key and op == 'eq':
+                    groups.setdefault(value, []).append(idx)
+                    break
+            else:
+                no_condition.append(idx)
+
+        child_used = used_keys | {split_key}
+        branches = []
+        for value, rule_idxs in groups.items():
+            branches.append((value, build(rule_idxs + no_condition, child_used)))
+        default_child = build(no_condition, child_used) if no_condition else -1
+        tree[node] = (split_key, branches, default_child, [])
+        return node
+
+    all_indices = [i for i in range(len(conditions)) if enabled[i]]
+    if all_indices:
+        build(all_indices, frozenset())
+    return tree
+
+
+def emit_pack(name, rules, lines):
+    if isinstance(rules, dict):
+        rules = [rules]
+    prefix = identifier(name)
+    keys = []
+    key_ids = {}
+    conditions = []
+    entries = []
+    rule_conditions = []
+    enabled = []
+    for rule in rules:
+        action = rule.get('action') or {}
+        first = len(conditions)
+        parsed = []
+        for cond in rule.get('conditions') or []:
+            key = str(cond.get('key', ''))
+            if not key:
+                continue
+            if key not in key_ids:
+                key_ids[key] = len(keys)
+                keys.append(key)
+            op, value = str(cond.get('op', '')), str(cond.get('value', ''))
+            parsed.append((key, op, value))
+            conditions.append('    {%d, %s, %s},' % (key_ids[key], c_string(op), c_string(value)))
+        rule_conditions.append(parsed)
+        enabled.append(bool(rule.get('enabled', True)))
+        entries.append('    {%s, %s, %s, %s, %s, %s, %dLL, %s, %d, %d},' % (
+            c_string(rule.get('id', '')), c_string(rule.get('name', '')),
+            c_string(rule.get('actionId') or action.get('id', '')),
+            c_string(action.get('type', '')), c_string(action.get('payload', '')),
+            c_double(rule.get('priority', 1.0)), int(rule.get('cooldownMs', 0)),
+            'true' if rule.get('enabled', True) else 'false',
+            first, len(conditions) - first))
+
+    def table(ctype, suffix, rows):
+        if not rows:
+            return 'nullptr'
+        lines.append('constexpr %s %s%s[] = {' % (ctype, prefix, suffix))
+        lines.extend(rows)
+        lines.append('};')
+        lines.append('')
+        return prefix + suffix
+
+    nodes = []
+    branches = []
+    leaf_rules = []
+    for split_key, node_branches, default_child, leaf in build_tree(rule_conditions, enabled):
+        nodes.append('    {%d, %d, %d, %d, %d, %d},' % (
+            key_ids[split_key] if split_key else -1, len(branches), len(node_branches),
+            default_child, len(leaf_rules), len(leaf)))
+        branches.extend('    {%s, %d},' % (c_string(value), child) for value, child in node_branches)
+        leaf_rules.extend(leaf)
+
+    key_table = table('const char*', 'Keys', ['    %s,' % c_string(k) for k in keys])
+    cond_table = table('PackCondition', 'Conditions', conditions)
+    rule_table = table('PackRule', 'Rules', entries)
+    node_table = table('PackTreeNode', 'Nodes', nodes)
+    branch_table = table('PackBranch', 'Branches', branches)
+    leaf_table = table('uint32_t', 'LeafRules', ['    %s,' % ', '.join(
+        str(r) for r in leaf_rules[i:i + 16]) for i in range(0, len(leaf_rules), 16)])
+    return '    {%s, %s, %d, %s, %d, %s, %d, %s, %d, %s, %s},' % (
+        c_string(name), key_table, len(keys), cond_table, len(conditions), rule_table,
+        len(entries), node_table, len(nodes), branch_table, leaf_table)
+
+
+def main(argv):
+    global FEATURE_COSTS, FALLBACK_FEATURE_COST
+    args = argv[1:]
+    keys_header = KEYS_HEADER
+    if len(args) >= 2 and args[0] == '--keys':
+        keys_header, args = args[1], args[2:]
+    if len(args) < 2:
+        sys.stderr.write(__doc__)
+        return 2
+    FEATURE_COSTS, FALLBACK_FEATURE_COST = load_feature_costs(keys_header)
+    output = args[0]
+    lines = []
+    packs = []
+    pack_keys = []
+    for spec in args[1:]:
+        name, _, path = spec.partition('=')
+        with open(path, encoding='utf-8') as f:
+            rules = json.load(f)
+        packs.append(emit_pack(name, rules, lines))
+        for rule in rules if isinstance(rules, list) else [rules]:
+            for cond in rule.get('conditions') or []:
+                key = str(cond.get('key', ''))
+                if key and key not in pack_keys:
+                    pack_keys.append(key)
+    lines[:0] = [
+        '// Generated by gen_rule_packs.py from rule-pack JSON — do not edit.',
+        '#include "context_engine.h"',
+        '#include "data_tray/context_keys.h"',
+        '',
+        'namespace context_engine {',
+        '',
+        '// The pre-built trees used these split costs',
+    ] + ['static_assert(data_tray::featureCost(%s) == %d, "context_keys.h costs changed: regenerate rule packs");'
+         % (c_string(key), feature_cost(key)) for key in pack_keys] + [
+        '',
+        'namespace {',
+        '',
+    ]
+    lines.append('constexpr RulePack kPacks[] = {')
+    lines.extend(packs)
+    lines.extend([
+        '};',
+        '',
+        '}  // namespace',
+        '',
+        'const RulePack* findRulePack(const std::string& name) {',
+        '    for (const auto& pack : kPacks) {',
+        '        if (name == pack.name) return &pack;',
+        '    }',
+        '    return nullptr;',
+        '}',
+        '',
+        '}  // namespace context_engine',
+        '',
+    ])
+    with open(output, 'w', encoding='utf-8') as f:
+        f.write('\n'.join(lines))
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main(sys.argv))
@@ -7,6 +7,7 @@
  * Feature vector (d=8):
  *   [hour_sin, hour_cos, battery/100, isCharging, isWeekend,
  *    motion_stationary, motion_active, motion_vehicle]
+ * Keys and missing-value defaults come from the key registry (data_tray/context_keys.h).
  *
  * Algorithm:
  *   A_a = d×d matrix (init I_d), b_a = d-vector (init 0)
@@ -15,6 +16,7 @@
  *   Update: A_a += x*x^T, b_a += reward*x
  */
 #include "context_engine.h"
+#include "data_tray/context_keys.h"
 #include <cmath>
 #include <algorithm>
 #include <sstream>
@@ -119,6 +121,36 @@ bool invertMat(const Mat& src, Mat& inv) {
     return true;
 }
 
+// Feature keys, as registry IDs
+constexpr int HOUR_KEY = data_tray::keyId("hour");
+constexpr int BATTERY_KEY = data_tray::keyId("batteryLevel");
+constexpr int CHARGING_KEY = data_tray::keyId("isCharging");
+constexpr int WEEKEND_KEY = data_tray::keyId("isWeekend");
+constexpr int MOTION_KEY = data_tray::keyId("motionState");
+
+constexpr bool hasDefault(int id) {
+    return id >= 0 && data_tray::KEYS[id].defaultValue != nullptr;
+}
+static_assert(hasDefault(HOUR_KEY) && hasDefault(BATTERY_KEY) && hasDefault(CHARGING_KEY) &&
+              hasDefault(WEEKEND_KEY) && hasDefault(MOTION_KEY),
+              "LinUCB features must be registered keys with a default value");
+
+/** The context value of a registered key, or its registry default when absent */
+std::string featureValue(const ContextMap& ctx, int id) {
+    auto it = ctx.find(data_tray::KEYS[id].name);
+    return it != ctx.end() ? std::string(it->second) : std::string(data_tray::KEYS[id].defaultValue);
+}
+
+double featureNumber(const ContextMap& ctx, int id) {
+    double fallback = safe_stod(data_tray::KEYS[id].defaultValue);
+    auto it = ctx.find(data_tray::KEYS[id].name);
+    double value = fallback;
+    if (it != ctx.end() && !it->second.number(value)) {
+        value = safe_stod(it->second, fallback);
+    }
+    return value;
+}
+
 }  // namespace
 
 // ============================================================
@@ -131,35 +163,22 @@ Vec LinUCB::buildFeatureVec(const ContextMap& ctx) const {
     Vec x{};
 
     // hour → sin/cos encoding (normalized to [-1, 1])
-    double hour = 12.0;
-    auto it = ctx.find("hour");
-    if (it != ctx.end()) {
-        hour = safe_stod(it->second, 12.0);
-    }
+    double hour = featureNumber(ctx, HOUR_KEY);
     x[0] = std::sin(2.0 * M_PI * hour / 24.0);
     x[1] = std::cos(2.0 * M_PI * hour / 24.0);
 
     // battery / 100
-    double battery = 50.0;
-    it = ctx.find("batteryLevel");
-    if (it != ctx.end()) {
-        battery = safe_stod(it->second, 50.0);
-    }
-    x[2] = battery / 100.0;
+    x[2] = featureNumber(ctx, BATTERY_KEY) / 100.0;
 
     // isCharging
-    it = ctx.find("isCharging");
-    x[3] = (it != ctx.end() && it->second == "true") ? 1.0 : 0.0;
+    x[3] = featureValue(ctx, CHARGING_KEY) == "true" ? 1.0 : 0.0;
 
     // isWeekend
-    it = ctx.find("isWeekend");
-    x[4] = (it != ctx.end() && it->second == "true") ? 1.0 : 0.0;
+    x[4] = featureValue(ctx, WEEKEND_KEY) == "true" ? 1.0 : 0.0;
 
     // motionState → 3-dim encoding
-    // [stationary, walking/running, driving/transit]
-    std::string motion = "stationary";
-    it = ctx.find("motionState");
-    if (it != ctx.end()) motion = it->second;
+    // [stationary, walking/running, driving/transit]; unknown → all zero
+    std::string motion = featureValue(ctx, MOTION_KEY);
 
     x[5] = (motion == "stationary") ? 1.0 : 0.0;
     x[6] = (motion == "walking" || motion == "running") ? 1.0 : 0.0;
@@ -219,9 +238,11 @@ int LinUCB::select(const std::vector<std::string>& actionIds, const ContextMap&
 }
 
 void LinUCB::update(const std::string& actionId, double reward, const ContextMap& ctx) {
-    std::lock_guard<std::mutex> lock(mu_);
+    updateFeatures(actionId, reward, buildFeatureVec(ctx));
+}
 
-    Vec x = buildFeatureVec(ctx);
+void LinUCB::updateFeatures(const std::string& actionId, double reward, const Vec& x) {
+    std::lock_guard<std::mutex> lock(mu_);
 
     auto armIt = arms_.find(actionId);
     if (armIt == arms_.end()) {
@@ -242,6 +263,16 @@ void LinUCB::update(const std::string& actionId, double reward, const ContextMap
         arm.b[i] += reward * x[i];
 }
 
+std::unordered_map<std::string, LinUCBArm> LinUCB::arms() const {
+    std::lock_guard<std::mutex> lock(mu_);
+    return arms_;
+}
+
+void LinUCB::setArm(const std::string& actionId, const LinUCBArm& arm) {
+    std::lock_guard<std::mutex> lock(mu_);
+    arms_[actionId] = arm;
+}
+
 std::string LinUCB::exportJson() const {
     std::lock_guard<std::mutex> lock(mu_);
 
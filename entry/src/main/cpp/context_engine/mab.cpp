@@ -16,14 +16,12 @@ int MAB::select(const std::vector<std::string>& actionIds) {
 
     std::lock_guard<std::mutex> lock(mu_);
 
-    // Random generator
-    static thread_local std::mt19937 gen(std::random_device{}());
     std::uniform_real_distribution<> dist(0.0, 1.0);
 
     // Epsilon-greedy: explore with probability epsilon
-    if (dist(gen) < epsilon_) {
+    if (dist(rng_) < epsilon_) {
         std::uniform_int_distribution<> idist(0, static_cast<int>(actionIds.size()) - 1);
-        return idist(gen);
+        return idist(rng_);
     }
 
     // Exploit: pick the arm with highest average reward
@@ -61,4 +59,14 @@ void MAB::loadStats(const std::unordered_map<std::string, ArmStats>& stats) {
     arms_ = stats;
 }
 
+void MAB::setArm(const std::string& actionId, const ArmStats& stats) {
+    std::lock_guard<std::mutex> lock(mu_);
+    arms_[actionId] = stats;
+}
+
+void MAB::seed(uint32_t seed) {
+    std::lock_guard<std::mutex> lock(mu_);
+    rng_.seed(seed);
+}
+
 }  // namespace context_engine
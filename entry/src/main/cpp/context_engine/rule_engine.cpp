@@ -3,8 +3,16 @@
  *
  * Features:
  *   - Decision tree traversal + soft matching
- *   - Event buffer for "recent" and "sequence" (within) conditions
+ *   - "recent" and "sequence" (within) conditions via EventBuffer (event_buffer.cpp)
+ *   - "countWithin"/"rateWithin" frequency conditions via EventBuffer's bucketed counters
  *   - Enhanced cooldown: per-rule, per-category, global rate limit
+ *   - Adaptive condition ordering (cheap, selective conditions first)
+ *   - Shared condition table: identical conditions across rules are matched
+ *     once per evaluate and memoized
+ *   - Bitmap-index eval mode (see bitmap_index.cpp)
+ *   - Branch-and-bound top-K: candidates in descending priority bound, early
+ *     stop once the K-th result beats every remaining bound; optional time budget
+ *   - Built-in rule packs from generated constexpr tables (gen_rule_packs.py)
  */
 #include "context_engine.h"
 #include <algorithm>
@@ -14,117 +22,215 @@
 namespace context_engine {
 
 // ============================================================
-// EventBuffer implementation
+// RuleEngine implementation
 // ============================================================
 
-EventBuffer::EventBuffer(size_t maxSize) : maxSize_(maxSize) {}
+RuleEngine::RuleEngine() : mab_(0.1) {}
+RuleEngine::~RuleEngine() = default;
 
-void EventBuffer::push(const ContextEvent& event) {
+bool RuleEngine::loadRules(const std::vector<Rule>& rules) {
     std::lock_guard<std::mutex> lock(mu_);
-    expireOld();
-    if (events_.size() >= maxSize_) {
-        events_.pop_front();
+    resetRules(rules);
+    recompile();
+    return true;
+}
+
+void RuleEngine::resetRules(std::vector<Rule> rules) {
+    // Caller must hold mu_
+    rules_ = std::move(rules);
+    plans_.clear();
+    reordered_ = false;
+    plans_.reserve(rules_.size());
+    for (const auto& rule : rules_) plans_.push_back(makePlan(rule));
+    lastFired_.clear();
+    categoryFirings_.clear();
+    globalFirings_.clear();
+    StateRecord clear;
+    clear.type = StateRecord::ClearFirings;
+    logState(clear);
+}
+
+std::vector<Rule> packRules(const RulePack& pack) {
+    std::vector<Rule> rules;
+    rules.reserve(pack.ruleCount);
+    for (size_t r = 0; r < pack.ruleCount; r++) {
+        const auto& src = pack.rules[r];
+        Rule rule;
+        rule.id = src.id;
+        rule.name = src.name;
+        rule.action.id = src.actionId;
+        rule.action.type = src.actionType;
+        rule.action.payload = src.actionPayload;
+        rule.priority = src.priority;
+        rule.cooldownMs = src.cooldownMs;
+        rule.enabled = src.enabled;
+        rule.conditions.reserve(src.conditionCount);
+        for (uint32_t c = 0; c < src.conditionCount; c++) {
+            const auto& cond = pack.conditions[src.firstCondition + c];
+            rule.conditions.push_back({pack.keys[cond.keyId], cond.op, cond.value});
+        }
+        rules.push_back(std::move(rule));
     }
-    events_.push_back(event);
+    return rules;
 }
 
-bool EventBuffer::hasRecent(const std::string& eventType, int64_t withinMs) const {
-    std::lock_guard<std::mutex> lock(mu_);
-    int64_t now = std::chrono::duration_cast<std::chrono::milliseconds>(
-        std::chrono::steady_clock::now().time_since_epoch()).count();
-    int64_t cutoff = now - withinMs;
+bool RuleEngine::loadRulePack(const RulePack& pack, const std::vector<Rule>& userRules,
+                              const std::vector<std::string>& removedIds) {
+    std::vector<Rule> rules = packRules(pack);
+    rules.reserve(rules.size() + userRules.size());
+    std::unordered_map<std::string, size_t> byId;
+    for (size_t i = 0; i < rules.size(); i++) byId[rules[i].id] = i;
+    // Rules that differ from the pack: replaced pack rules and appended user rules
+    std::vector<bool> patched(rules.size(), false);
+    for (const auto& rule : userRules) {
+        auto it = byId.find(rule.id);
+        if (it != byId.end()) {
+            rules[it->second] = rule;
+            patched[it->second] = true;
+        } else {
+            byId[rule.id] = rules.size();
+            rules.push_back(rule);
+            patched.push_back(true);
+        }
+    }
+    std::vector<bool> removed(rules.size(), false);
+    for (const auto& id : removedIds) {
+        auto it = byId.find(id);
+        if (it != byId.end()) removed[it->second] = true;
+    }
 
-    // Search backward (most recent first) for efficiency
-    for (auto it = events_.rbegin(); it != events_.rend(); ++it) {
-        if (it->timestampMs < cutoff) break;  // all older events are before cutoff
-        if (it->eventType == eventType) return true;
+    // Compact, mapping pack rule index → rules index (-1: removed or replaced,
+    // i.e. no longer the rule the pre-built tree placed)
+    std::vector<int> packToRule(pack.ruleCount, -1);
+    std::vector<int> inserted;
+    size_t kept = 0;
+    for (size_t i = 0; i < rules.size(); i++) {
+        if (removed[i]) continue;
+        if (i < pack.ruleCount && !patched[i]) packToRule[i] = static_cast<int>(kept);
+        if (patched[i] && rules[i].enabled) inserted.push_back(static_cast<int>(kept));
+        if (kept != i) rules[kept] = std::move(rules[i]);
+        kept++;
     }
-    return false;
+    rules.resize(kept);
+
+    std::lock_guard<std::mutex> lock(mu_);
+    resetRules(std::move(rules));
+    // The pre-built tree is the static one; profile-guided trees are still compiled
+    if (pack.nodeCount > 0 && evalMode_ == EvalMode::Tree && !profileGuided_) {
+        installPackTree(pack, packToRule);
+        for (int ruleIdx : inserted) insertTreeRule(ruleIdx);
+        finishTree();
+    } else {
+        recompile();
+    }
+    return true;
 }
 
-bool EventBuffer::hasSequence(const std::string& eventA, const std::string& eventB,
-                               int64_t withinMs) const {
+bool RuleEngine::addRule(const Rule& rule) {
     std::lock_guard<std::mutex> lock(mu_);
-    int64_t now = std::chrono::duration_cast<std::chrono::milliseconds>(
-        std::chrono::steady_clock::now().time_since_epoch()).count();
-    int64_t cutoff = now - withinMs;
-
-    // Find latest B within window, then check if A happened before it
-    int64_t latestB = -1;
-    for (auto it = events_.rbegin(); it != events_.rend(); ++it) {
-        if (it->timestampMs < cutoff) break;
-        if (it->eventType == eventB) {
-            latestB = it->timestampMs;
-            break;
-        }
+    // Check for duplicate
+    size_t idx = 0;
+    while (idx < rules_.size() && rules_[idx].id != rule.id) idx++;
+    if (idx < rules_.size()) {
+        rules_[idx] = rule;  // update existing
+        plans_[idx] = makePlan(rule);
+    } else {
+        rules_.push_back(rule);
+        plans_.push_back(makePlan(rule));
     }
-    if (latestB < 0) return false;
 
-    // Check if A happened before B and within window
-    for (auto it = events_.rbegin(); it != events_.rend(); ++it) {
-        if (it->timestampMs < cutoff) break;
-        if (it->eventType == eventA && it->timestampMs < latestB) {
+    if (evalMode_ == EvalMode::Bitmap) {
+        // Only this rule's bits change: append it to the unordered tail, no full rebuild
+        compileConditions();
+        compileRuleOrder();
+        size_t tail = bitmapRules_.size() - bitmapSorted_;
+        if (tail >= 64 + rules_.size() / 16) {
+            rebuildBitmap();
             return true;
         }
+        if (idx < bitmapPos_.size()) {
+            bitmap_.clearRule(bitmapPos_[idx]);
+            bitmapRules_[bitmapPos_[idx]] = -1;
+        } else {
+            bitmapPos_.push_back(-1);
+        }
+        int pos = static_cast<int>(bitmapRules_.size());
+        bitmapRules_.push_back(static_cast<int>(idx));
+        bitmapPos_[idx] = pos;
+        bitmap_.setRule(pos, rule);
+    } else {
+        compileTree();
     }
-    return false;
+    return true;
 }
 
-size_t EventBuffer::size() const {
+bool RuleEngine::removeRule(const std::string& ruleId) {
     std::lock_guard<std::mutex> lock(mu_);
-    return events_.size();
+    size_t kept = 0;
+    for (size_t i = 0; i < rules_.size(); i++) {
+        if (rules_[i].id == ruleId) continue;
+        if (kept != i) {
+            rules_[kept] = std::move(rules_[i]);
+            plans_[kept] = std::move(plans_[i]);
+        }
+        kept++;
+    }
+    if (kept == rules_.size()) return false;
+    rules_.resize(kept);
+    plans_.resize(kept);
+    recompile();  // indices shift: rebuild
+    return true;
 }
 
-void EventBuffer::expireOld() {
+void RuleEngine::recompile() {
     // Caller must hold mu_
-    int64_t now = std::chrono::duration_cast<std::chrono::milliseconds>(
-        std::chrono::steady_clock::now().time_since_epoch()).count();
-    int64_t cutoff = now - MAX_AGE_MS;
-    while (!events_.empty() && events_.front().timestampMs < cutoff) {
-        events_.pop_front();
+    if (evalMode_ == EvalMode::Bitmap) {
+        compileConditions();
+        compileRuleOrder();
+        rebuildBitmap();
+    } else {
+        compileTree();
     }
 }
 
-// ============================================================
-// RuleEngine implementation
-// ============================================================
-
-RuleEngine::RuleEngine() : mab_(0.1), eventBuffer_(100) {}
-RuleEngine::~RuleEngine() = default;
+void RuleEngine::compileRuleOrder() {
+    // Caller must hold mu_
+    boundOrder_.resize(rules_.size());
+    for (size_t i = 0; i < boundOrder_.size(); i++) boundOrder_[i] = static_cast<int>(i);
+    std::stable_sort(boundOrder_.begin(), boundOrder_.end(), [&](int a, int b) {
+        return scoreBound(rules_[a].priority) > scoreBound(rules_[b].priority);
+    });
+    boundRank_.resize(rules_.size());
+    for (size_t r = 0; r < boundOrder_.size(); r++) boundRank_[boundOrder_[r]] = static_cast<int>(r);
+}
 
-bool RuleEngine::loadRules(const std::vector<Rule>& rules) {
-    std::lock_guard<std::mutex> lock(mu_);
-    rules_ = rules;
-    lastFired_.clear();
-    categoryFirings_.clear();
-    globalFirings_.clear();
-    compileTree();
-    return true;
+void RuleEngine::rebuildBitmap() {
+    // Caller must hold mu_
+    bitmapRules_ = boundOrder_;
+    bitmapPos_ = boundRank_;
+    bitmapSorted_ = bitmapRules_.size();
+    bitmap_.build(rules_, bitmapRules_);
 }
 
-bool RuleEngine::addRule(const Rule& rule) {
+void RuleEngine::setEvalMode(EvalMode mode) {
     std::lock_guard<std::mutex> lock(mu_);
-    // Check for duplicate
-    for (auto& r : rules_) {
-        if (r.id == rule.id) {
-            r = rule;  // update existing
-            compileTree();
-            return true;
-        }
+    if (mode == evalMode_) return;
+    evalMode_ = mode;
+    if (mode == EvalMode::Bitmap) {
+        tree_.clear();
+        rebuildBitmap();
+    } else {
+        bitmap_ = RuleBitmapIndex{};
+        bitmapRules_.clear();
+        bitmapPos_.clear();
+        bitmapSorted_ = 0;
+        compileTree();
     }
-    rules_.push_back(rule);
-    compileTree();
-    return true;
 }
 
-bool RuleEngine::removeRule(const std::string& ruleId) {
+EvalMode RuleEngine::evalMode() const {
     std::lock_guard<std::mutex> lock(mu_);
-    auto it = std::remove_if(rules_.begin(), rules_.end(),
-        [&](const Rule& r) { return r.id == ruleId; });
-    if (it == rules_.end()) return false;
-    rules_.erase(it, rules_.end());
-    compileTree();
-    return true;
+    return evalMode_;
 }
 
 static int64_t nowMs() {
@@ -157,22 +263,102 @@ void RuleEngine::setLimits(const RateLimits& limits) {
     rateLimits_ = limits;
 }
 
-double RuleEngine::matchCondition(const Condition& cond, const ContextMap& ctx) {
-    // Handle temporal ops via event buffer
+// ============================================================
+// Learning state (bandits + cooldowns) and its write-ahead log
+// ============================================================
+
+void RuleEngine::updateReward(const std::string& actionId, double reward, const ContextMap* ctx) {
+    std::lock_guard<std::mutex> lock(mu_);
+    StateRecord rec;
+    rec.type = StateRecord::MabUpdate;
+    rec.id = actionId;
+    rec.reward = reward;
+    mab_.update(actionId, reward);
+    logState(rec);
+    if (ctx) {
+        // Log the feature vector, not the context: replay must not depend on
+        // how buildFeatureVec() encodes keys in a later version
+        rec.type = StateRecord::LinUCBUpdate;
+        rec.x = linucb_.buildFeatureVec(*ctx);
+        linucb_.updateFeatures(actionId, reward, rec.x);
+        logState(rec);
+    }
+}
+
+int64_t RuleEngine::openStateLog(const std::string& dir, const std::string& name) {
+    std::lock_guard<std::mutex> lock(mu_);
+    return stateLog_.open(dir, name, [this](const StateRecord& rec) {
+        switch (rec.type) {
+            case StateRecord::MabUpdate: mab_.update(rec.id, rec.reward); break;
+            case StateRecord::LinUCBUpdate: linucb_.updateFeatures(rec.id, rec.reward, rec.x); break;
+            case StateRecord::Firing: lastFired_[rec.id] = rec.timeMs; break;
+            case StateRecord::ClearFirings: lastFired_.clear(); break;
+            case StateRecord::MabArm: mab_.setArm(rec.id, rec.stats); break;
+            case StateRecord::LinUCBArmState: linucb_.setArm(rec.id, rec.arm); break;
+            default: break;
+        }
+    });
+}
+
+bool RuleEngine::compactStateLog() {
+    std::lock_guard<std::mutex> lock(mu_);
+    return compactStateLogLocked();
+}
+
+bool RuleEngine::compactStateLogLocked() {
+    // Caller must hold mu_
+    std::vector<StateRecord> records;
+    StateRecord rec;
+    rec.type = StateRecord::MabArm;
+    for (const auto& [id, stats] : mab_.getStats()) {
+        rec.id = id;
+        rec.stats = stats;
+        records.push_back(rec);
+    }
+    rec.type = StateRecord::LinUCBArmState;
+    for (const auto& [id, arm] : linucb_.arms()) {
+        rec.id = id;
+        rec.arm = arm;
+        records.push_back(rec);
+    }
+    rec.type = StateRecord::Firing;
+    for (const auto& [id, timeMs] : lastFired_) {
+        rec.id = id;
+        rec.timeMs = timeMs;
+        records.push_back(rec);
+    }
+    return stateLog_.compact(records);
+}
+
+void RuleEngine::logState(const StateRecord& record) {
+    // Caller must hold mu_
+    if (!stateLog_.isOpen()) return;
+    stateLog_.append(record);
+    if (stateLog_.pendingRecords() >= StateLog::COMPACT_RECORDS) compactStateLogLocked();
+}
+
+double RuleEngine::matchCondition(const SharedCondition& sc, const ContextMap& ctx) {
+    const auto& cond = sc.cond;
+    // Handle temporal ops via event buffer (operands pre-parsed in compileConditions)
     if (cond.op == "recent") {
-        auto eventType = extractAfterPrefix(cond.key, "event:");
-        if (eventType.empty()) return 0.0;
-        int64_t withinMs = 0;
-        try { withinMs = std::stoll(cond.value); } catch (...) { return 0.0; }
-        return eventBuffer_.hasRecent(eventType, withinMs) ? 1.0 : 0.0;
+        if (sc.windowMs < 0) return 0.0;
+        return eventBuffer_.hasRecent(sc.eventA, sc.windowMs) ? 1.0 : 0.0;
     }
 
     if (cond.op == "within") {
-        auto [typeA, typeB] = extractSequencePair(cond.key);
-        if (typeA.empty() || typeB.empty()) return 0.0;
-        int64_t withinMs = 0;
-        try { withinMs = std::stoll(cond.value); } catch (...) { return 0.0; }
-        return eventBuffer_.hasSequence(typeA, typeB, withinMs) ? 1.0 : 0.0;
+        if (sc.windowMs < 0) return 0.0;
+        return eventBuffer_.hasSequence(sc.eventA, sc.eventB, sc.windowMs) ? 1.0 : 0.0;
+    }
+
+    if (cond.op == "countWithin") {
+        if (sc.windowMs < 0) return 0.0;
+        return static_cast<double>(eventBuffer_.countWithin(sc.eventA, sc.windowMs)) >= sc.threshold
+            ? 1.0 : 0.0;
+    }
+
+    if (cond.op == "rateWithin") {
+        if (sc.windowMs < 0) return 0.0;
+        return eventBuffer_.rateWithin(sc.eventA, sc.windowMs) >= sc.threshold ? 1.0 : 0.0;
     }
 
     // All other ops → standard soft match
@@ -211,134 +397,348 @@ void RuleEngine::recordFiring(const Action& action, int64_t now) {
     globalFirings_.push_back(now);
 }
 
-void RuleEngine::evaluateNode(int nodeIdx, const ContextMap& ctx,
-                               std::vector<MatchResult>& results) {
-    if (nodeIdx < 0 || nodeIdx >= static_cast<int>(tree_.size())) return;
-    const auto& node = tree_[nodeIdx];
-
-    if (node.splitKey.empty()) {
-        // Leaf node: evaluate all candidate rules
-        int64_t now = nowMs();
-        for (int rIdx : node.ruleIndices) {
-            const auto& rule = rules_[rIdx];
-            if (!rule.enabled) continue;
+// Relative cost of matching a condition (temporal lookups scan the event buffer)
+static int conditionCost(const Condition& cond) {
+    if (cond.op == "eq" || cond.op == "neq") return 1;
+    if (cond.op == "in") return 2;
+    if (cond.op == "range") return 4;
+    if (cond.op == "recent") return 8;
+    if (cond.op == "within") return 12;
+    if (cond.op == "countWithin" || cond.op == "rateWithin") return 6;  // bucket sum, no scan
+    return 3;  // gt/gte/lt/lte: two numeric parses
+}
 
-            // Check per-rule cooldown
-            auto lastIt = lastFired_.find(rule.id);
-            if (lastIt != lastFired_.end() && rule.cooldownMs > 0) {
-                if (now - lastIt->second < rule.cooldownMs) continue;
-            }
+RulePlan RuleEngine::makePlan(const Rule& rule) {
+    RulePlan plan;
+    plan.order.resize(rule.conditions.size());
+    for (size_t i = 0; i < plan.order.size(); i++) plan.order[i] = static_cast<int>(i);
+    return plan;
+}
 
-            // Check enhanced rate limits
-            if (isRateLimited(rule.action, now)) continue;
+void RuleEngine::compileConditions() {
+    // Caller must hold mu_. Signature = key \x1f op \x1f value
+    auto signature = [](const Condition& c) {
+        return c.key + '\x1f' + c.op + '\x1f' + c.value.str();
+    };
 
-            // Match all conditions (soft match + temporal)
-            double confidence = 1.0;
-            for (const auto& cond : rule.conditions) {
-                double match = matchCondition(cond, ctx);
-                confidence *= match;
-                if (confidence < 0.01) break;  // early exit
+    std::unordered_map<std::string, ConditionStats> oldStats;
+    oldStats.reserve(sharedConds_.size());
+    for (const auto& sc : sharedConds_) oldStats.emplace(signature(sc.cond), sc.stats);
+
+    sharedConds_.clear();
+    std::unordered_map<std::string, int> index;
+    for (size_t r = 0; r < rules_.size(); r++) {
+        const auto& conds = rules_[r].conditions;
+        auto& plan = plans_[r];
+        plan.condIds.resize(conds.size());
+        for (size_t c = 0; c < conds.size(); c++) {
+            auto sig = signature(conds[c]);
+            auto it = index.find(sig);
+            if (it != index.end()) {
+                plan.condIds[c] = it->second;
+                continue;
             }
 
-            if (confidence > 0.1) {
-                results.push_back({rule.id, confidence, rule.action});
+            SharedCondition sc;
+            sc.cond = conds[c];
+            sc.cost = conditionCost(sc.cond);
+            if (sc.cond.op == "recent" || sc.cond.op == "within") {
+                if (sc.cond.op == "recent") {
+                    sc.eventA = extractAfterPrefix(sc.cond.key, "event:");
+                } else {
+                    auto pair = extractSequencePair(sc.cond.key);
+                    sc.eventA = pair.first;
+                    sc.eventB = pair.second;
+                }
+                bool operandsOk = !sc.eventA.empty() && (sc.cond.op == "recent" || !sc.eventB.empty());
+                if (operandsOk) {
+                    try { sc.windowMs = std::stoll(sc.cond.value); } catch (...) { sc.windowMs = -1; }
+                }
+            } else if (sc.cond.op == "countWithin" || sc.cond.op == "rateWithin") {
+                // value = "windowMs,threshold"
+                sc.eventA = extractAfterPrefix(sc.cond.key, "event:");
+                auto comma = sc.cond.value.str().find(',');
+                if (!sc.eventA.empty() && comma != std::string::npos) {
+                    try { sc.windowMs = std::stoll(sc.cond.value.str().substr(0, comma)); } catch (...) { sc.windowMs = -1; }
+                    sc.threshold = safe_stod(sc.cond.value.str().substr(comma + 1), 0.0);
+                }
+                if (sc.windowMs <= 0) sc.windowMs = -1;
             }
+            auto statsIt = oldStats.find(sig);
+            if (statsIt != oldStats.end()) sc.stats = statsIt->second;
+
+            int id = static_cast<int>(sharedConds_.size());
+            index.emplace(std::move(sig), id);
+            sharedConds_.push_back(std::move(sc));
+            plan.condIds[c] = id;
         }
-        return;
     }
 
-    // Internal node: follow matching branch
-    auto ctxIt = ctx.find(node.splitKey);
-    if (ctxIt != ctx.end()) {
-        for (const auto& [value, childIdx] : node.branches) {
-            if (ctxIt->second == value) {
-                evaluateNode(childIdx, ctx, results);
-                return;
-            }
+    memoValue_.assign(sharedConds_.size(), 0.0);
+    memoEpoch_.assign(sharedConds_.size(), 0);
+    evalEpoch_ = 0;
+}
+
+double RuleEngine::matchRule(int ruleIdx, const ContextMap& ctx) {
+    const auto& conds = rules_[ruleIdx].conditions;
+    auto& plan = plans_[ruleIdx];
+    if (matchScratch_.size() < conds.size()) matchScratch_.resize(conds.size());
+
+    evalStats_.rulesEvaluated++;
+    plan.dirty = true;
+
+    double confidence = 1.0;
+    bool rejected = false;
+    int64_t condsUsed = 0;
+    for (int c : plan.order) {
+        int id = plan.condIds[c];
+        double match;
+        if (memoEpoch_[id] == evalEpoch_) {
+            match = memoValue_[id];
+            evalStats_.memoHits++;
+        } else {
+            auto& sc = sharedConds_[id];
+            match = matchCondition(sc, ctx);
+            memoValue_[id] = match;
+            memoEpoch_[id] = evalEpoch_;
+            evalStats_.conditionsEvaluated++;
+            sc.stats.evaluated++;
+            if (match <= MIN_CONFIDENCE) sc.stats.rejected++;
+        }
+        condsUsed++;
+
+        matchScratch_[c] = match;
+        confidence *= match;
+        // Every factor is ≤ 1, so the product can only shrink: the rule can no longer fire
+        if (confidence <= MIN_CONFIDENCE) {
+            rejected = true;
+            break;
         }
     }
 
-    // No match or missing key → follow default branch
-    if (node.defaultChild >= 0) {
-        evaluateNode(node.defaultChild, ctx, results);
+    if (!reordered_) {
+        evalStats_.rulesBeforeReorder++;
+        evalStats_.condsBeforeReorder += condsUsed;
+    } else {
+        evalStats_.rulesAfterReorder++;
+        evalStats_.condsAfterReorder += condsUsed;
     }
-}
 
-std::vector<MatchResult> RuleEngine::evaluate(const ContextMap& ctx, int maxResults) {
-    std::lock_guard<std::mutex> lock(mu_);
+    if (rejected) return confidence;
 
-    // Build priority lookup once: O(n) instead of O(n²) during sort
-    std::unordered_map<std::string, double> priorityMap;
-    priorityMap.reserve(rules_.size());
-    for (const auto& rule : rules_) {
-        priorityMap[rule.id] = rule.priority;
+    // Recombine in authoring order so the confidence is bit-identical to the unordered product
+    confidence = 1.0;
+    for (size_t c = 0; c < conds.size(); c++) confidence *= matchScratch_[c];
+    return confidence;
+}
+
+void RuleEngine::reorderConditions() {
+    // Caller must hold mu_
+    // Halve old counts so the order keeps tracking shifting traffic
+    for (auto& sc : sharedConds_) {
+        if (sc.stats.evaluated > 65536) {
+            sc.stats.evaluated /= 2;
+            sc.stats.rejected /= 2;
+        }
     }
 
-    auto sortByScore = [&](std::vector<MatchResult>& results) {
-        std::sort(results.begin(), results.end(), [&](const MatchResult& a, const MatchResult& b) {
-            double pa = priorityMap.count(a.ruleId) ? priorityMap[a.ruleId] : 1.0;
-            double pb = priorityMap.count(b.ruleId) ? priorityMap[b.ruleId] : 1.0;
-            return a.confidence * pa > b.confidence * pb;
-        });
+    // Rank = cost ÷ P(reject); Laplace-smoothed so unseen conditions keep a finite rank
+    auto rank = [&](int id) {
+        const auto& st = sharedConds_[id].stats;
+        double rejectRate = (st.rejected + 1.0) / (st.evaluated + 2.0);
+        return sharedConds_[id].cost / rejectRate;
     };
 
-    if (tree_.empty()) {
-        // No tree compiled, evaluate all rules linearly
-        std::vector<MatchResult> results;
-        int64_t now = nowMs();
-        for (const auto& rule : rules_) {
-            if (!rule.enabled) continue;
-            auto lastIt = lastFired_.find(rule.id);
-            if (lastIt != lastFired_.end() && rule.cooldownMs > 0) {
-                if (now - lastIt->second < rule.cooldownMs) continue;
-            }
-            if (isRateLimited(rule.action, now)) continue;
-            double confidence = 1.0;
-            for (const auto& cond : rule.conditions) {
-                confidence *= matchCondition(cond, ctx);
-                if (confidence < 0.01) break;
-            }
-            if (confidence > 0.1) {
-                results.push_back({rule.id, confidence, rule.action});
+    bool changed = false;
+    for (auto& plan : plans_) {
+        if (!plan.dirty || plan.order.size() < 2) continue;
+        plan.dirty = false;
+        std::stable_sort(plan.order.begin(), plan.order.end(), [&](int a, int b) {
+            return rank(plan.condIds[a]) < rank(plan.condIds[b]);
+        });
+        changed = true;
+    }
+    if (changed) {
+        evalStats_.reorders++;
+        reordered_ = true;
+    }
+}
+
+double RuleEngine::scoreRule(int ruleIdx, const ContextMap& ctx, int64_t now) {
+    const auto& rule = rules_[ruleIdx];
+    if (!rule.enabled) return 0.0;
+
+    // Check per-rule cooldown
+    auto lastIt = lastFired_.find(rule.id);
+    if (lastIt != lastFired_.end() && rule.cooldownMs > 0) {
+        if (now - lastIt->second < rule.cooldownMs) return 0.0;
+    }
+
+    // Check enhanced rate limits
+    if (isRateLimited(rule.action, now)) return 0.0;
+
+    // Match all conditions (soft match + temporal)
+    double confidence = matchRule(ruleIdx, ctx);
+    return confidence > MIN_CONFIDENCE ? confidence : 0.0;
+}
+
+int RuleEngine::findLeaf(const ContextMap& ctx) const {
+    int nodeIdx = 0;
+    while (nodeIdx >= 0 && nodeIdx < static_cast<int>(tree_.size())) {
+        const auto& node = tree_[nodeIdx];
+        if (node.splitKey.empty()) return nodeIdx;
+
+        // Internal node: follow matching branch; no match or missing key → default branch
+        int next = node.defaultChild;
+        auto ctxIt = ctx.find(node.splitKey);
+        if (ctxIt != ctx.end()) {
+            for (const auto& [value, childIdx] : node.branches) {
+                if (ctxIt->second == value) {
+                    next = childIdx;
+                    break;
+                }
             }
         }
-        sortByScore(results);
-        if (static_cast<int>(results.size()) > maxResults) results.resize(maxResults);
-
-        // Record firing for rate limiting
-        if (!results.empty()) {
-            int64_t fireNow = nowMs();
-            lastFired_[results[0].ruleId] = fireNow;
-            recordFiring(results[0].action, fireNow);
+        nodeIdx = next;
+    }
+    return -1;
+}
+
+namespace {
+
+/** A fired rule in the running top-K */
+struct Scored {
+    double score;       // confidence × priority
+    double priority;
+    int ruleIdx;
+    double confidence;
+};
+
+/** Result order: score, then priority, then earlier rule */
+bool ranksBefore(const Scored& a, const Scored& b) {
+    if (a.score != b.score) return a.score > b.score;
+    if (a.priority != b.priority) return a.priority > b.priority;
+    return a.ruleIdx < b.ruleIdx;
+}
+
+/** Bounded best-K: a heap whose front is the current K-th (worst kept) result */
+class TopK {
+public:
+    explicit TopK(size_t k) : k_(k) { heap_.reserve(k); }
+
+    bool full() const { return heap_.size() >= k_; }
+    const Scored& worst() const { return heap_.front(); }
+
+    void offer(const Scored& s) {
+        if (!full()) {
+            heap_.push_back(s);
+            std::push_heap(heap_.begin(), heap_.end(), ranksBefore);
+        } else if (ranksBefore(s, heap_.front())) {
+            std::pop_heap(heap_.begin(), heap_.end(), ranksBefore);
+            heap_.back() = s;
+            std::push_heap(heap_.begin(), heap_.end(), ranksBefore);
         }
-        return results;
     }
 
-    std::vector<MatchResult> results;
-    evaluateNode(0, ctx, results);
-
-    // Deduplicate results (same rule may appear in multiple branches)
-    std::unordered_map<std::string, size_t> seen;
-    std::vector<MatchResult> deduped;
-    deduped.reserve(results.size());
-    for (auto& r : results) {
-        auto it = seen.find(r.ruleId);
-        if (it == seen.end()) {
-            seen[r.ruleId] = deduped.size();
-            deduped.push_back(std::move(r));
-        } else {
-            // Keep higher confidence
-            if (r.confidence > deduped[it->second].confidence) {
-                deduped[it->second] = std::move(r);
+    /** Best first; consumes the heap */
+    std::vector<Scored>& sorted() {
+        std::sort_heap(heap_.begin(), heap_.end(), ranksBefore);
+        return heap_;
+    }
+
+private:
+    size_t k_;
+    std::vector<Scored> heap_;
+};
+
+}  // namespace
+
+std::vector<MatchResult> RuleEngine::evaluate(const ContextMap& ctx, int maxResults,
+                                              int64_t budgetUs) {
+    std::lock_guard<std::mutex> lock(mu_);
+    evalStats_.evaluations++;
+    profile_.record(ctx);
+    // New memo generation; on wrap-around clear stale slots so none look current
+    if (++evalEpoch_ == 0) {
+        std::fill(memoEpoch_.begin(), memoEpoch_.end(), 0);
+        evalEpoch_ = 1;
+    }
+    if (++evalsSinceReorder_ >= REORDER_INTERVAL) {
+        reorderConditions();
+        evalsSinceReorder_ = 0;
+    }
+    if (maxResults <= 0) return {};
+
+    TopK best(static_cast<size_t>(maxResults));
+    int64_t now = nowMs();
+    auto budgetEnd = std::chrono::steady_clock::now() + std::chrono::microseconds(budgetUs);
+    int sinceBudgetCheck = 0;
+
+    // Score one candidate. Returns false to stop: candidates arrive in descending bound
+    // order (when `ordered`), so once the K-th result ranks before this rule at its
+    // best possible score, no later candidate can enter the top K either.
+    auto visit = [&](int ruleIdx, bool ordered) {
+        const auto& rule = rules_[ruleIdx];
+        if (ordered && best.full() &&
+            ranksBefore(best.worst(), Scored{scoreBound(rule.priority), rule.priority, ruleIdx, 1.0})) {
+            evalStats_.boundStops++;
+            return false;
+        }
+        if (budgetUs > 0 && ++sinceBudgetCheck >= BUDGET_CHECK_INTERVAL) {
+            sinceBudgetCheck = 0;
+            if (std::chrono::steady_clock::now() >= budgetEnd) {
+                evalStats_.budgetStops++;
+                return false;
             }
         }
-    }
-    results = std::move(deduped);
+        double confidence = scoreRule(ruleIdx, ctx, now);
+        if (confidence > 0.0) {
+            best.offer({confidence * rule.priority, rule.priority, ruleIdx, confidence});
+        }
+        return true;
+    };
 
-    sortByScore(results);
+    if (evalMode_ == EvalMode::Bitmap) {
+        // Bitmap index: only rules surviving every eq/in key are soft-matched
+        bitmap_.candidates(ctx, candidateBits_);
+        bool more = true;
+        // Tail (rules added since the last rebuild) is unordered: score it all first
+        for (size_t pos = bitmapSorted_; more && pos < bitmapRules_.size(); pos++) {
+            if ((candidateBits_[pos / 64] >> (pos % 64)) & 1) more = visit(bitmapRules_[pos], false);
+        }
+        size_t sortedWords = (bitmapSorted_ + 63) / 64;
+        for (size_t w = 0; more && w < sortedWords; w++) {
+            uint64_t bits = candidateBits_[w];
+            if (w == sortedWords - 1 && bitmapSorted_ % 64 != 0) {
+                bits &= (uint64_t{1} << (bitmapSorted_ % 64)) - 1;
+            }
+            while (more && bits != 0) {
+                int bit = __builtin_ctzll(bits);
+                bits &= bits - 1;
+                more = visit(bitmapRules_[w * 64 + bit], true);
+            }
+        }
+    } else if (!tree_.empty()) {
+        // One leaf per context, so each rule is scored at most once
+        int leaf = findLeaf(ctx);
+        if (leaf >= 0) {
+            for (int rIdx : tree_[leaf].ruleIndices) {
+                if (!visit(rIdx, true)) break;
+            }
+        }
+    } else {
+        // No tree compiled, evaluate all rules linearly
+        for (int rIdx : boundOrder_) {
+            if (!visit(rIdx, true)) break;
+        }
+    }
 
-    if (static_cast<int>(results.size()) > maxResults) {
-        results.resize(maxResults);
+    std::vector<MatchResult> results;
+    auto& ranked = best.sorted();
+    results.reserve(ranked.size());
+    for (const auto& s : ranked) {
+        const auto& rule = rules_[s.ruleIdx];
+        results.push_back({rule.id, s.confidence, rule.action});
     }
 
     // Record firing for per-rule cooldown + rate limiting
@@ -346,17 +746,41 @@ std::vector<MatchResult> RuleEngine::evaluate(const ContextMap& ctx, int maxResu
         int64_t fireNow = nowMs();
         lastFired_[results[0].ruleId] = fireNow;
         recordFiring(results[0].action, fireNow);
+        StateRecord fired;
+        fired.type = StateRecord::Firing;
+        fired.id = results[0].ruleId;
+        fired.timeMs = fireNow;
+        logState(fired);
     }
 
     return results;
 }
 
+EvalStats RuleEngine::evalStats() const {
+    std::lock_guard<std::mutex> lock(mu_);
+    return evalStats_;
+}
+
+void RuleEngine::resetEvalStats() {
+    std::lock_guard<std::mutex> lock(mu_);
+    evalStats_ = EvalStats{};
+}
+
+size_t RuleEngine::sharedConditionCount() const {
+    std::lock_guard<std::mutex> lock(mu_);
+    return sharedConds_.size();
+}
+
 std::string RuleEngine::exportRulesJson() const {
     std::lock_guard<std::mutex> lock(mu_);
+    return rulesToJson(rules_);
+}
+
+std::string rulesToJson(const std::vector<Rule>& rules) {
     std::ostringstream ss;
     ss << "[";
-    for (size_t i = 0; i < rules_.size(); i++) {
-        const auto& r = rules_[i];
+    for (size_t i = 0; i < rules.size(); i++) {
+        const auto& r = rules[i];
         if (i > 0) ss << ",";
         ss << "{\"id\":\"" << r.id << "\",\"name\":\"" << r.name
            << "\",\"enabled\":" << (r.enabled ? "true" : "false")
@@ -366,7 +790,7 @@ std::string RuleEngine::exportRulesJson() const {
             if (j > 0) ss << ",";
             ss << "{\"key\":\"" << r.conditions[j].key
                << "\",\"op\":\"" << r.conditions[j].op
-               << "\",\"value\":\"" << r.conditions[j].value << "\"}";
+               << "\",\"value\":\"" << r.conditions[j].value.str() << "\"}";
         }
         ss << "],\"action\":{\"id\":\"" << r.action.id
            << "\",\"type\":\"" << r.action.type
@@ -0,0 +1,35 @@
+# rule_packs.cmake — built-in rule packs (内置规则包)
+#
+# gen_rule_packs.py turns rule-pack JSON into constexpr tables, loadable by name
+# via RuleEngine::loadRulePack. When python3 is found the tables are generated
+# into the build directory whenever the pack JSON, the key registry or the
+# generator changes; otherwise the checked-in rule_packs.cpp is compiled.
+# `check_rule_packs` fails if the checked-in copy differs from a fresh one.
+# Sets RULE_PACKS_SOURCE; add it to the target's sources.
+set(RULE_PACKS_DIR ${CMAKE_CURRENT_LIST_DIR})
+set(RULE_PACKS_JSON_DIR ${RULE_PACKS_DIR}/../../resources/rawfile/config)
+set(RULE_PACKS_CHECKED_IN ${RULE_PACKS_DIR}/rule_packs.cpp)
+
+find_program(RULE_PACKS_PYTHON NAMES python3 python)
+if(RULE_PACKS_PYTHON)
+    set(RULE_PACKS_SOURCE ${CMAKE_CURRENT_BINARY_DIR}/rule_packs.cpp)
+    add_custom_command(
+        OUTPUT ${RULE_PACKS_SOURCE}
+        COMMAND ${RULE_PACKS_PYTHON} ${RULE_PACKS_DIR}/gen_rule_packs.py
+                --keys ${RULE_PACKS_DIR}/../data_tray/context_keys.h ${RULE_PACKS_SOURCE}
+                default=${RULE_PACKS_JSON_DIR}/default_rules.json
+        DEPENDS ${RULE_PACKS_DIR}/gen_rule_packs.py ${RULE_PACKS_JSON_DIR}/default_rules.json
+                ${RULE_PACKS_DIR}/../data_tray/context_keys.h
+        COMMENT "Generating built-in rule packs"
+        VERBATIM
+    )
+    add_custom_target(check_rule_packs
+        COMMAND ${CMAKE_COMMAND} -E compare_files ${RULE_PACKS_CHECKED_IN} ${RULE_PACKS_SOURCE}
+        DEPENDS ${RULE_PACKS_SOURCE}
+        COMMENT "Checking the checked-in rule_packs.cpp is up to date (else: copy it from the build dir)"
+        VERBATIM
+    )
+else()
+    message(STATUS "python3 not found: using the checked-in rule_packs.cpp")
+    set(RULE_PACKS_SOURCE ${RULE_PACKS_CHECKED_IN})
+endif()
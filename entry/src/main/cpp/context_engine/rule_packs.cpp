@@ -0,0 +1,628 @@
+// Generated by gen_rule_packs.py from rule-pack JSON — do not edit.
+#include "context_engine.h"
+#include "data_tray/context_keys.h"
+
+namespace context_engine {
+
+// The pre-built trees used these split costs
+static_assert(data_tray::featureCost("timeOfDay") == 0, "context_keys.h costs changed: regenerate rule packs");
+static_assert(data_tray::featureCost("isWeekend") == 0, "context_keys.h costs changed: regenerate rule packs");
+static_assert(data_tray::featureCost("motionState") == 2, "context_keys.h costs changed: regenerate rule packs");
+static_assert(data_tray::featureCost("batteryLevel") == 1, "context_keys.h costs changed: regenerate rule packs");
+static_assert(data_tray::featureCost("isCharging") == 1, "context_keys.h costs changed: regenerate rule packs");
+static_assert(data_tray::featureCost("isSleeping") == 2, "context_keys.h costs changed: regenerate rule packs");
+static_assert(data_tray::featureCost("geofence") == 3, "context_keys.h costs changed: regenerate rule packs");
+static_assert(data_tray::featureCost("activityDuration") == 2, "context_keys.h costs changed: regenerate rule packs");
+static_assert(data_tray::featureCost("wifiGeofence") == 2, "context_keys.h costs changed: regenerate rule packs");
+static_assert(data_tray::featureCost("wifiLostWork") == 2, "context_keys.h costs changed: regenerate rule packs");
+static_assert(data_tray::featureCost("wifiLostCategory") == 2, "context_keys.h costs changed: regenerate rule packs");
+
+namespace {
+
+constexpr const char* kDefaultKeys[] = {
+    "timeOfDay",
+    "isWeekend",
+    "motionState",
+    "batteryLevel",
+    "isCharging",
+    "isSleeping",
+    "geofence",
+    "activityDuration",
+    "wifiGeofence",
+    "wifiLostWork",
+    "wifiLostCategory",
+};
+
+constexpr PackCondition kDefaultConditions[] = {
+    {0, "eq", "morning"},
+    {1, "eq", "false"},
+    {2, "in", "walking,driving"},
+    {3, "lte", "15"},
+    {4, "eq", "false"},
+    {0, "eq", "morning"},
+    {1, "eq", "true"},
+    {2, "eq", "stationary"},
+    {0, "in", "morning,afternoon"},
+    {5, "neq", "true"},
+    {6, "eq", "{{home}}"},
+    {2, "eq", "stationary"},
+    {7, "gte", "3600"},
+    {5, "neq", "true"},
+    {8, "eq", "home"},
+    {2, "eq", "stationary"},
+    {7, "gte", "3600"},
+    {5, "neq", "true"},
+    {2, "in", "driving,transit"},
+    {1, "eq", "false"},
+    {0, "in", "morning,evening"},
+    {0, "eq", "night"},
+    {2, "eq", "stationary"},
+    {0, "eq", "evening"},
+    {6, "eq", "{{home}}"},
+    {2, "eq", "stationary"},
+    {0, "eq", "morning"},
+    {6, "neq", "{{home}}"},
+    {2, "in", "walking,driving"},
+    {6, "eq", "{{work}}"},
+    {1, "eq", "false"},
+    {2, "eq", "stationary"},
+    {6, "neq", "{{work}}"},
+    {0, "in", "evening,night"},
+    {1, "eq", "false"},
+    {9, "eq", "true"},
+    {0, "in", "afternoon,evening,night"},
+    {1, "eq", "false"},
+    {6, "neq", "{{work}}"},
+    {2, "eq", "walking"},
+    {1, "eq", "false"},
+    {9, "eq", "true"},
+    {2, "eq", "walking"},
+    {1, "eq", "false"},
+    {6, "eq", "{{gym}}"},
+    {8, "eq", "home"},
+    {0, "in", "afternoon,evening,night"},
+    {10, "eq", "home"},
+    {0, "in", "dawn,morning"},
+    {8, "eq", "work"},
+    {1, "eq", "false"},
+    {8, "eq", "gym"},
+};
+
+constexpr PackRule kDefaultRules[] = {
+    {"rule_morning_workday", "工作日早出门", "suggest_morning_commute", "suggestion", "早上好！查看通勤路线和天气？", 2.0, 14400000LL, true, 0, 3},
+    {"rule_low_battery", "低电量提醒", "warn_low_battery", "notification", "电量不足 15%，建议省电模式或充电", 3.0, 1800000LL, true, 3, 2},
+    {"rule_weekend_morning", "周末早上", "suggest_weekend", "suggestion", "周末愉快！看看今天有什么好玩的？", 1.0, 28800000LL, true, 5, 2},
+    {"rule_long_stationary", "久坐提醒", "suggest_move", "suggestion", "坐了很久了，起来活动一下吧 🏃", 1.0, 5400000LL, true, 7, 3},
+    {"rule_home_sedentary_alert", "在家久坐提醒（1小时）", "alert_move_home", "alert", "在家坐了超过1小时了！起来活动一下 🏃‍♂️", 3.0, 3600000LL, true, 10, 4},
+    {"rule_home_sedentary_wifi", "在家久坐提醒（WiFi检测）", "alert_move_home_wifi", "alert", "在家坐了超过1小时了！起来活动一下 🏃‍♂️", 2.5, 3600000LL, true, 14, 4},
+    {"rule_commuting", "通勤路上", "suggest_commute_info", "suggestion", "通勤中，要听播客或看新闻摘要吗？", 1.5, 14400000LL, true, 18, 3},
+    {"rule_bedtime", "睡前提醒", "suggest_bedtime", "suggestion", "夜深了，明天的日程已准备好，早点休息 🌙", 1.0, 28800000LL, true, 21, 2},
+    {"rule_evening_home", "到家放松", "suggest_evening_relax", "suggestion", "到家了！听音乐或看新闻摘要？", 1.5, 14400000LL, true, 23, 3},
+    {"rule_leave_home_morning", "早上离家", "suggest_morning_brief", "suggestion", "出门了！今日天气和日程概览？", 2.0, 14400000LL, true, 26, 3},
+    {"rule_arrive_work", "到达公司", "suggest_work_mode", "suggestion", "到公司了，开启工作模式？查看今日待办", 2.0, 28800000LL, true, 29, 3},
+    {"rule_leave_work", "下班离开公司（围栏）", "suggest_leave_work", "suggestion", "下班了！查看回家路线？", 1.5, 28800000LL, true, 32, 3},
+    {"rule_leave_work_wifi", "离开公司（WiFi丢失）", "suggest_leave_work", "suggestion", "检测到离开公司WiFi，下班了？查看回家路线？", 2.0, 28800000LL, true, 35, 3},
+    {"rule_leave_work_music", "离开公司步行听音乐（围栏）", "suggest_music", "suggestion", "走路中 🎵 打开音乐放松一下？", 2.0, 28800000LL, true, 38, 3},
+    {"rule_leave_work_music_wifi", "离开公司步行听音乐（WiFi丢失）", "suggest_music", "suggestion", "走路中 🎵 打开音乐放松一下？", 2.5, 28800000LL, true, 41, 3},
+    {"rule_arrive_gym", "到达健身房", "suggest_workout", "suggestion", "到健身房了💪 开始今天的训练计划？", 1.5, 14400000LL, true, 44, 1},
+    {"rule_arrive_home_wifi", "到家（WiFi连接）", "suggest_arrive_home", "suggestion", "到家了🏠 今天辛苦了，放松一下吧", 1.5, 28800000LL, true, 45, 2},
+    {"rule_leave_home_wifi", "离家（WiFi丢失）", "suggest_leave_home", "suggestion", "检测到离家WiFi断开，出门了？查看今日日程和天气？", 1.5, 28800000LL, true, 47, 2},
+    {"rule_arrive_work_wifi", "到达公司（WiFi连接）", "suggest_arrive_work", "suggestion", "到公司了💼 查看今天的会议和待办？", 1.8, 28800000LL, true, 49, 2},
+    {"rule_arrive_gym_wifi", "到达健身房（WiFi连接）", "suggest_workout", "suggestion", "到健身房了💪 开始今天的训练计划？", 1.2, 14400000LL, true, 51, 1},
+};
+
+constexpr PackTreeNode kDefaultNodes[] = {
+    {0, 0, 3, 201, 0, 0},
+    {1, 3, 2, 64, 0, 0},
+    {2, 5, 2, 35, 0, 0},
+    {8, 7, 3, 19, 0, 0},
+    {6, 10, 3, 8, 0, 0},
+    {-1, 13, 0, -1, 0, 11},
+    {-1, 13, 0, -1, 11, 11},
+    {-1, 13, 0, -1, 22, 11},
+    {-1, 13, 0, -1, 33, 10},
+    {6, 13, 3, 13, 43, 0},
+    {-1, 16, 0, -1, 43, 10},
+    {-1, 16, 0, -1, 53, 10},
+    {-1, 16, 0, -1, 63, 10},
+    {-1, 16, 0, -1, 73, 9},
+    {6, 16, 3, 18, 82, 0},
+    {-1, 19, 0, -1, 82, 10},
+    {-1, 19, 0, -1, 92, 10},
+    {-1, 19, 0, -1, 102, 10},
+    {-1, 19, 0, -1, 112, 9},
+    {6, 19, 3, 23, 121, 0},
+    {-1, 22, 0, -1, 121, 9},
+    {-1, 22, 0, -1, 130, 9},
+    {-1, 22, 0, -1, 139, 9},
+    {-1, 22, 0, -1, 148, 8},
+    {6, 22, 1, 30, 156, 0},
+    {8, 23, 3, 29, 156, 0},
+    {-1, 26, 0, -1, 156, 11},
+    {-1, 26, 0, -1, 167, 11},
+    {-1, 26, 0, -1, 178, 11},
+    {-1, 26, 0, -1, 189, 10},
+    {8, 26, 3, 34, 199, 0},
+    {-1, 29, 0, -1, 199, 10},
+    {-1, 29, 0, -1, 209, 10},
+    {-1, 29, 0, -1, 219, 10},
+    {-1, 29, 0, -1, 229, 9},
+    {8, 29, 3, 45, 238, 0},
+    {6, 32, 1, 38, 238, 0},
+    {-1, 33, 0, -1, 238, 9},
+    {-1, 33, 0, -1, 247, 8},
+    {6, 33, 1, 41, 255, 0},
+    {-1, 34, 0, -1, 255, 9},
+    {-1, 34, 0, -1, 264, 8},
+    {6, 34, 1, 44, 272, 0},
+    {-1, 35, 0, -1, 272, 9},
+    {-1, 35, 0, -1, 281, 8},
+    {6, 35, 1, 47, 289, 0},
+    {-1, 36, 0, -1, 289, 8},
+    {-1, 36, 0, -1, 297, 7},
+    {2, 36, 1, 54, 304, 0},
+    {5, 37, 0, 50, 304, 0},
+    {8, 37, 2, 53, 304, 0},
+    {-1, 39, 0, -1, 304, 9},
+    {-1, 39, 0, -1, 313, 8},
+    {-1, 39, 0, -1, 321, 7},
+    {8, 39, 2, 61, 328, 0},
+    {6, 41, 1, 57, 328, 0},
+    {-1, 42, 0, -1, 328, 6},
+    {-1, 42, 0, -1, 334, 5},
+    {6, 42, 1, 60, 339, 0},
+    {-1, 43, 0, -1, 339, 6},
+    {-1, 43, 0, -1, 345, 5},
+    {6, 43, 1, 63, 350, 0},
+    {-1, 44, 0, -1, 350, 5},
+    {-1, 44, 0, -1, 355, 4},
+    {2, 44, 1, 70, 359, 0},
+    {5, 45, 0, 66, 359, 0},
+    {8, 45, 2, 69, 359, 0},
+    {-1, 47, 0, -1, 359, 8},
+    {-1, 47, 0, -1, 367, 7},
+    {-1, 47, 0, -1, 374, 6},
+    {8, 47, 2, 77, 380, 0},
+    {6, 49, 1, 73, 380, 0},
+    {-1, 50, 0, -1, 380, 5},
+    {-1, 50, 0, -1, 385, 4},
+    {6, 50, 1, 76, 389, 0},
+    {-1, 51, 0, -1, 389, 5},
+    {-1, 51, 0, -1, 394, 4},
+    {6, 51, 1, 79, 398, 0},
+    {-1, 52, 0, -1, 398, 4},
+    {-1, 52, 0, -1, 402, 3},
+    {1, 52, 1, 126, 405, 0},
+    {2, 53, 2, 113, 405, 0},
+    {8, 55, 3, 95, 405, 0},
+    {5, 58, 0, 84, 405, 0},
+    {-1, 58, 0, -1, 405, 12},
+    {6, 58, 3, 89, 417, 0},
+    {-1, 61, 0, -1, 417, 9},
+    {-1, 61, 0, -1, 426, 9},
+    {-1, 61, 0, -1, 435, 9},
+    {-1, 61, 0, -1, 444, 8},
+    {6, 61, 3, 94, 452, 0},
+    {-1, 64, 0, -1, 452, 9},
+    {-1, 64, 0, -1, 461, 9},
+    {-1, 64, 0, -1, 470, 9},
+    {-1, 64, 0, -1, 479, 8},
+    {6, 64, 3, 99, 487, 0},
+    {-1, 67, 0, -1, 487, 8},
+    {-1, 67, 0, -1, 495, 8},
+    {-1, 67, 0, -1, 503, 8},
+    {-1, 67, 0, -1, 511, 7},
+    {8, 67, 3, 110, 518, 0},
+    {6, 70, 1, 103, 518, 0},
+    {-1, 71, 0, -1, 518, 9},
+    {-1, 71, 0, -1, 527, 8},
+    {6, 71, 1, 106, 535, 0},
+    {-1, 72, 0, -1, 535, 9},
+    {-1, 72, 0, -1, 544, 8},
+    {6, 72, 1, 109, 552, 0},
+    {-1, 73, 0, -1, 552, 9},
+    {-1, 73, 0, -1, 561, 8},
+    {6, 73, 1, 112, 569, 0},
+    {-1, 74, 0, -1, 569, 8},
+    {-1, 74, 0, -1, 577, 7},
+    {8, 74, 3, 123, 584, 0},
+    {6, 77, 1, 116, 584, 0},
+    {-1, 78, 0, -1, 584, 7},
+    {-1, 78, 0, -1, 591, 6},
+    {6, 78, 1, 119, 597, 0},
+    {-1, 79, 0, -1, 597, 7},
+    {-1, 79, 0, -1, 604, 6},
+    {6, 79, 1, 122, 610, 0},
+    {-1, 80, 0, -1, 610, 7},
+    {-1, 80, 0, -1, 617, 6},
+    {6, 80, 1, 125, 623, 0},
+    {-1, 81, 0, -1, 623, 6},
+    {-1, 81, 0, -1, 629, 5},
+    {2, 81, 1, 132, 634, 0},
+    {5, 82, 0, 128, 634, 0},
+    {8, 82, 2, 131, 634, 0},
+    {-1, 84, 0, -1, 634, 8},
+    {-1, 84, 0, -1, 642, 7},
+    {-1, 84, 0, -1, 649, 6},
+    {8, 84, 2, 137, 655, 0},
+    {3, 86, 0, 134, 655, 0},
+    {-1, 86, 0, -1, 655, 4},
+    {3, 86, 0, 136, 659, 0},
+    {-1, 86, 0, -1, 659, 4},
+    {3, 86, 0, 138, 663, 0},
+    {-1, 86, 0, -1, 663, 3},
+    {1, 86, 1, 188, 666, 0},
+    {2, 87, 2, 175, 666, 0},
+    {8, 89, 3, 157, 666, 0},
+    {6, 92, 3, 146, 666, 0},
+    {-1, 95, 0, -1, 666, 9},
+    {-1, 95, 0, -1, 675, 10},
+    {-1, 95, 0, -1, 685, 9},
+    {-1, 95, 0, -1, 694, 8},
+    {6, 95, 3, 151, 702, 0},
+    {-1, 98, 0, -1, 702, 8},
+    {-1, 98, 0, -1, 710, 9},
+    {-1, 98, 0, -1, 719, 8},
+    {-1, 98, 0, -1, 727, 7},
+    {6, 98, 3, 156, 734, 0},
+    {-1, 101, 0, -1, 734, 8},
+    {-1, 101, 0, -1, 742, 9},
+    {-1, 101, 0, -1, 751, 8},
+    {-1, 101, 0, -1, 759, 7},
+    {6, 101, 3, 161, 766, 0},
+    {-1, 104, 0, -1, 766, 7},
+    {-1, 104, 0, -1, 773, 8},
+    {-1, 104, 0, -1, 781, 7},
+    {-1, 104, 0, -1, 788, 6},
+    {8, 104, 3, 172, 794, 0},
+    {6, 107, 1, 165, 794, 0},
+    {-1, 108, 0, -1, 794, 9},
+    {-1, 108, 0, -1, 803, 8},
+    {6, 108, 1, 168, 811, 0},
+    {-1, 109, 0, -1, 811, 9},
+    {-1, 109, 0, -1, 820, 8},
+    {6, 109, 1, 171, 828, 0},
+    {-1, 110, 0, -1, 828, 9},
+    {-1, 110, 0, -1, 837, 8},
+    {6, 110, 1, 174, 845, 0},
+    {-1, 111, 0, -1, 845, 8},
+    {-1, 111, 0, -1, 853, 7},
+    {8, 111, 3, 185, 860, 0},
+    {6, 114, 1, 178, 860, 0},
+    {-1, 115, 0, -1, 860, 7},
+    {-1, 115, 0, -1, 867, 6},
+    {6, 115, 1, 181, 873, 0},
+    {-1, 116, 0, -1, 873, 7},
+    {-1, 116, 0, -1, 880, 6},
+    {6, 116, 1, 184, 886, 0},
+    {-1, 117, 0, -1, 886, 7},
+    {-1, 117, 0, -1, 893, 6},
+    {6, 117, 1, 187, 899, 0},
+    {-1, 118, 0, -1, 899, 6},
+    {-1, 118, 0, -1, 905, 5},
+    {2, 118, 1, 194, 910, 0},
+    {5, 119, 0, 190, 910, 0},
+    {8, 119, 2, 193, 910, 0},
+    {-1, 121, 0, -1, 910, 8},
+    {-1, 121, 0, -1, 918, 7},
+    {-1, 121, 0, -1, 925, 6},
+    {8, 121, 2, 199, 931, 0},
+    {3, 123, 0, 196, 931, 0},
+    {-1, 123, 0, -1, 931, 4},
+    {3, 123, 0, 198, 935, 0},
+    {-1, 123, 0, -1, 935, 4},
+    {3, 123, 0, 200, 939, 0},
+    {-1, 123, 0, -1, 939, 3},
+    {1, 123, 1, 247, 942, 0},
+    {2, 124, 2, 234, 942, 0},
+    {8, 126, 3, 216, 942, 0},
+    {5, 129, 0, 205, 942, 0},
+    {-1, 129, 0, -1, 942, 11},
+    {6, 129, 3, 210, 953, 0},
+    {-1, 132, 0, -1, 953, 8},
+    {-1, 132, 0, -1, 961, 8},
+    {-1, 132, 0, -1, 969, 8},
+    {-1, 132, 0, -1, 977, 7},
+    {6, 132, 3, 215, 984, 0},
+    {-1, 135, 0, -1, 984, 8},
+    {-1, 135, 0, -1, 992, 8},
+    {-1, 135, 0, -1, 1000, 8},
+    {-1, 135, 0, -1, 1008, 7},
+    {6, 135, 3, 220, 1015, 0},
+    {-1, 138, 0, -1, 1015, 7},
+    {-1, 138, 0, -1, 1022, 7},
+    {-1, 138, 0, -1, 1029, 7},
+    {-1, 138, 0, -1, 1036, 6},
+    {8, 138, 3, 231, 1042, 0},
+    {6, 141, 1, 224, 1042, 0},
+    {-1, 142, 0, -1, 1042, 9},
+    {-1, 142, 0, -1, 1051, 8},
+    {6, 142, 1, 227, 1059, 0},
+    {-1, 143, 0, -1, 1059, 9},
+    {-1, 143, 0, -1, 1068, 8},
+    {6, 143, 1, 230, 1076, 0},
+    {-1, 144, 0, -1, 1076, 9},
+    {-1, 144, 0, -1, 1085, 8},
+    {6, 144, 1, 233, 1093, 0},
+    {-1, 145, 0, -1, 1093, 8},
+    {-1, 145, 0, -1, 1101, 7},
+    {8, 145, 3, 244, 1108, 0},
+    {6, 148, 1, 237, 1108, 0},
+    {-1, 149, 0, -1, 1108, 7},
+    {-1, 149, 0, -1, 1115, 6},
+    {6, 149, 1, 240, 1121, 0},
+    {-1, 150, 0, -1, 1121, 7},
+    {-1, 150, 0, -1, 1128, 6},
+    {6, 150, 1, 243, 1134, 0},
+    {-1, 151, 0, -1, 1134, 7},
+    {-1, 151, 0, -1, 1141, 6},
+    {6, 151, 1, 246, 1147, 0},
+    {-1, 152, 0, -1, 1147, 6},
+    {-1, 152, 0, -1, 1153, 5},
+    {2, 152, 1, 253, 1158, 0},
+    {5, 153, 0, 249, 1158, 0},
+    {8, 153, 2, 252, 1158, 0},
+    {-1, 155, 0, -1, 1158, 7},
+    {-1, 155, 0, -1, 1165, 6},
+    {-1, 155, 0, -1, 1171, 5},
+    {8, 155, 2, 258, 1176, 0},
+    {3, 157, 0, 255, 1176, 0},
+    {-1, 157, 0, -1, 1176, 4},
+    {3, 157, 0, 257, 1180, 0},
+    {-1, 157, 0, -1, 1180, 4},
+    {3, 157, 0, 259, 1184, 0},
+    {-1, 157, 0, -1, 1184, 3},
+};
+
+constexpr PackBranch kDefaultBranches[] = {
+    {"morning", 1},
+    {"night", 80},
+    {"evening", 139},
+    {"false", 2},
+    {"true", 48},
+    {"stationary", 3},
+    {"walking", 24},
+    {"home", 4},
+    {"work", 9},
+    {"gym", 14},
+    {"{{work}}", 5},
+    {"{{home}}", 6},
+    {"{{gym}}", 7},
+    {"{{work}}", 10},
+    {"{{home}}", 11},
+    {"{{gym}}", 12},
+    {"{{work}}", 15},
+    {"{{home}}", 16},
+    {"{{gym}}", 17},
+    {"{{work}}", 20},
+    {"{{home}}", 21},
+    {"{{gym}}", 22},
+    {"{{gym}}", 25},
+    {"work", 26},
+    {"home", 27},
+    {"gym", 28},
+    {"work", 31},
+    {"home", 32},
+    {"gym", 33},
+    {"work", 36},
+    {"home", 39},
+    {"gym", 42},
+    {"{{gym}}", 37},
+    {"{{gym}}", 40},
+    {"{{gym}}", 43},
+    {"{{gym}}", 46},
+    {"stationary", 49},
+    {"home", 51},
+    {"gym", 52},
+    {"home", 55},
+    {"gym", 58},
+    {"{{gym}}", 56},
+    {"{{gym}}", 59},
+    {"{{gym}}", 62},
+    {"stationary", 65},
+    {"home", 67},
+    {"gym", 68},
+    {"home", 71},
+    {"gym", 74},
+    {"{{gym}}", 72},
+    {"{{gym}}", 75},
+    {"{{gym}}", 78},
+    {"false", 81},
+    {"stationary", 82},
+    {"walking", 100},
+    {"home", 83},
+    {"work", 85},
+    {"gym", 90},
+    {"{{work}}", 86},
+    {"{{home}}", 87},
+    {"{{gym}}", 88},
+    {"{{work}}", 91},
+    {"{{home}}", 92},
+    {"{{gym}}", 93},
+    {"{{work}}", 96},
+    {"{{home}}", 97},
+    {"{{gym}}", 98},
+    {"work", 101},
+    {"home", 104},
+    {"gym", 107},
+    {"{{gym}}", 102},
+    {"{{gym}}", 105},
+    {"{{gym}}", 108},
+    {"{{gym}}", 111},
+    {"work", 114},
+    {"home", 117},
+    {"gym", 120},
+    {"{{gym}}", 115},
+    {"{{gym}}", 118},
+    {"{{gym}}", 121},
+    {"{{gym}}", 124},
+    {"stationary", 127},
+    {"home", 129},
+    {"gym", 130},
+    {"home", 133},
+    {"gym", 135},
+    {"false", 140},
+    {"stationary", 141},
+    {"walking", 162},
+    {"home", 142},
+    {"work", 147},
+    {"gym", 152},
+    {"{{work}}", 143},
+    {"{{home}}", 144},
+    {"{{gym}}", 145},
+    {"{{work}}", 148},
+    {"{{home}}", 149},
+    {"{{gym}}", 150},
+    {"{{work}}", 153},
+    {"{{home}}", 154},
+    {"{{gym}}", 155},
+    {"{{work}}", 158},
+    {"{{home}}", 159},
+    {"{{gym}}", 160},
+    {"work", 163},
+    {"home", 166},
+    {"gym", 169},
+    {"{{gym}}", 164},
+    {"{{gym}}", 167},
+    {"{{gym}}", 170},
+    {"{{gym}}", 173},
+    {"work", 176},
+    {"home", 179},
+    {"gym", 182},
+    {"{{gym}}", 177},
+    {"{{gym}}", 180},
+    {"{{gym}}", 183},
+    {"{{gym}}", 186},
+    {"stationary", 189},
+    {"home", 191},
+    {"gym", 192},
+    {"home", 195},
+    {"gym", 197},
+    {"false", 202},
+    {"stationary", 203},
+    {"walking", 221},
+    {"home", 204},
+    {"work", 206},
+    {"gym", 211},
+    {"{{work}}", 207},
+    {"{{home}}", 208},
+    {"{{gym}}", 209},
+    {"{{work}}", 212},
+    {"{{home}}", 213},
+    {"{{gym}}", 214},
+    {"{{work}}", 217},
+    {"{{home}}", 218},
+    {"{{gym}}", 219},
+    {"work", 222},
+    {"home", 225},
+    {"gym", 228},
+    {"{{gym}}", 223},
+    {"{{gym}}", 226},
+    {"{{gym}}", 229},
+    {"{{gym}}", 232},
+    {"work", 235},
+    {"home", 238},
+    {"gym", 241},
+    {"{{gym}}", 236},
+    {"{{gym}}", 239},
+    {"{{gym}}", 242},
+    {"{{gym}}", 245},
+    {"stationary", 248},
+    {"home", 250},
+    {"gym", 251},
+    {"home", 254},
+    {"gym", 256},
+};
+
+constexpr uint32_t kDefaultLeafRules[] = {
+    10, 5, 16, 3, 0, 6, 11, 12, 9, 1, 17, 4, 5, 16, 3, 0,
+    6, 11, 12, 9, 1, 17, 15, 5, 16, 3, 0, 6, 11, 12, 9, 1,
+    17, 5, 16, 3, 0, 6, 11, 12, 9, 1, 17, 10, 18, 3, 0, 6,
+    11, 12, 9, 1, 17, 4, 18, 3, 0, 6, 11, 12, 9, 1, 17, 15,
+    18, 3, 0, 6, 11, 12, 9, 1, 17, 18, 3, 0, 6, 11, 12, 9,
+    1, 17, 10, 19, 3, 0, 6, 11, 12, 9, 1, 17, 4, 19, 3, 0,
+    6, 11, 12, 9, 1, 17, 15, 19, 3, 0, 6, 11, 12, 9, 1, 17,
+    19, 3, 0, 6, 11, 12, 9, 1, 17, 10, 3, 0, 6, 11, 12, 9,
+    1, 17, 4, 3, 0, 6, 11, 12, 9, 1, 17, 15, 3, 0, 6, 11,
+    12, 9, 1, 17, 3, 0, 6, 11, 12, 9, 1, 17, 18, 15, 13, 14,
+    0, 6, 11, 12, 9, 1, 17, 16, 15, 13, 14, 0, 6, 11, 12, 9,
+    1, 17, 19, 15, 13, 14, 0, 6, 11, 12, 9, 1, 17, 15, 13, 14,
+    0, 6, 11, 12, 9, 1, 17, 18, 13, 14, 0, 6, 11, 12, 9, 1,
+    17, 16, 13, 14, 0, 6, 11, 12, 9, 1, 17, 19, 13, 14, 0, 6,
+    11, 12, 9, 1, 17, 13, 14, 0, 6, 11, 12, 9, 1, 17, 15, 18,
+    0, 6, 11, 12, 9, 1, 17, 18, 0, 6, 11, 12, 9, 1, 17, 15,
+    16, 0, 6, 11, 12, 9, 1, 17, 16, 0, 6, 11, 12, 9, 1, 17,
+    15, 19, 0, 6, 11, 12, 9, 1, 17, 19, 0, 6, 11, 12, 9, 1,
+    17, 15, 0, 6, 11, 12, 9, 1, 17, 0, 6, 11, 12, 9, 1, 17,
+    5, 16, 3, 4, 2, 9, 1, 15, 17, 19, 3, 4, 2, 9, 1, 15,
+    17, 3, 4, 2, 9, 1, 15, 17, 15, 16, 2, 9, 1, 17, 16, 2,
+    9, 1, 17, 15, 19, 2, 9, 1, 17, 19, 2, 9, 1, 17, 15, 2,
+    9, 1, 17, 2, 9, 1, 17, 5, 16, 3, 4, 9, 1, 15, 17, 19,
+    3, 4, 9, 1, 15, 17, 3, 4, 9, 1, 15, 17, 15, 16, 9, 1,
+    17, 16, 9, 1, 17, 15, 19, 9, 1, 17, 19, 9, 1, 17, 15, 9,
+    1, 17, 9, 1, 17, 5, 16, 10, 7, 3, 4, 6, 11, 12, 1, 15,
+    17, 10, 18, 7, 3, 6, 11, 12, 1, 17, 4, 18, 7, 3, 6, 11,
+    12, 1, 17, 15, 18, 7, 3, 6, 11, 12, 1, 17, 18, 7, 3, 6,
+    11, 12, 1, 17, 10, 19, 7, 3, 6, 11, 12, 1, 17, 4, 19, 7,
+    3, 6, 11, 12, 1, 17, 15, 19, 7, 3, 6, 11, 12, 1, 17, 19,
+    7, 3, 6, 11, 12, 1, 17, 10, 7, 3, 6, 11, 12, 1, 17, 4,
+    7, 3, 6, 11, 12, 1, 17, 15, 7, 3, 6, 11, 12, 1, 17, 7,
+    3, 6, 11, 12, 1, 17, 15, 18, 13, 14, 6, 11, 12, 1, 17, 18,
+    13, 14, 6, 11, 12, 1, 17, 15, 16, 13, 14, 6, 11, 12, 1, 17,
+    16, 13, 14, 6, 11, 12, 1, 17, 15, 19, 13, 14, 6, 11, 12, 1,
+    17, 19, 13, 14, 6, 11, 12, 1, 17, 15, 13, 14, 6, 11, 12, 1,
+    17, 13, 14, 6, 11, 12, 1, 17, 15, 18, 6, 11, 12, 1, 17, 18,
+    6, 11, 12, 1, 17, 15, 16, 6, 11, 12, 1, 17, 16, 6, 11, 12,
+    1, 17, 15, 19, 6, 11, 12, 1, 17, 19, 6, 11, 12, 1, 17, 15,
+    6, 11, 12, 1, 17, 6, 11, 12, 1, 17, 5, 16, 7, 3, 4, 1,
+    15, 17, 19, 7, 3, 4, 1, 15, 17, 7, 3, 4, 1, 15, 17, 16,
+    1, 15, 17, 19, 1, 15, 17, 1, 15, 17, 10, 5, 16, 3, 6, 11,
+    12, 1, 17, 8, 4, 5, 16, 3, 6, 11, 12, 1, 17, 15, 5, 16,
+    3, 6, 11, 12, 1, 17, 5, 16, 3, 6, 11, 12, 1, 17, 10, 18,
+    3, 6, 11, 12, 1, 17, 8, 4, 18, 3, 6, 11, 12, 1, 17, 15,
+    18, 3, 6, 11, 12, 1, 17, 18, 3, 6, 11, 12, 1, 17, 10, 19,
+    3, 6, 11, 12, 1, 17, 8, 4, 19, 3, 6, 11, 12, 1, 17, 15,
+    19, 3, 6, 11, 12, 1, 17, 19, 3, 6, 11, 12, 1, 17, 10, 3,
+    6, 11, 12, 1, 17, 8, 4, 3, 6, 11, 12, 1, 17, 15, 3, 6,
+    11, 12, 1, 17, 3, 6, 11, 12, 1, 17, 15, 18, 13, 14, 6, 11,
+    12, 1, 17, 18, 13, 14, 6, 11, 12, 1, 17, 15, 16, 13, 14, 6,
+    11, 12, 1, 17, 16, 13, 14, 6, 11, 12, 1, 17, 15, 19, 13, 14,
+    6, 11, 12, 1, 17, 19, 13, 14, 6, 11, 12, 1, 17, 15, 13, 14,
+    6, 11, 12, 1, 17, 13, 14, 6, 11, 12, 1, 17, 15, 18, 6, 11,
+    12, 1, 17, 18, 6, 11, 12, 1, 17, 15, 16, 6, 11, 12, 1, 17,
+    16, 6, 11, 12, 1, 17, 15, 19, 6, 11, 12, 1, 17, 19, 6, 11,
+    12, 1, 17, 15, 6, 11, 12, 1, 17, 6, 11, 12, 1, 17, 5, 16,
+    8, 3, 4, 1, 15, 17, 19, 8, 3, 4, 1, 15, 17, 8, 3, 4,
+    1, 15, 17, 16, 1, 15, 17, 19, 1, 15, 17, 1, 15, 17, 5, 16,
+    10, 3, 4, 6, 11, 12, 1, 15, 17, 10, 18, 3, 6, 11, 12, 1,
+    17, 4, 18, 3, 6, 11, 12, 1, 17, 15, 18, 3, 6, 11, 12, 1,
+    17, 18, 3, 6, 11, 12, 1, 17, 10, 19, 3, 6, 11, 12, 1, 17,
+    4, 19, 3, 6, 11, 12, 1, 17, 15, 19, 3, 6, 11, 12, 1, 17,
+    19, 3, 6, 11, 12, 1, 17, 10, 3, 6, 11, 12, 1, 17, 4, 3,
+    6, 11, 12, 1, 17, 15, 3, 6, 11, 12, 1, 17, 3, 6, 11, 12,
+    1, 17, 15, 18, 13, 14, 6, 11, 12, 1, 17, 18, 13, 14, 6, 11,
+    12, 1, 17, 15, 16, 13, 14, 6, 11, 12, 1, 17, 16, 13, 14, 6,
+    11, 12, 1, 17, 15, 19, 13, 14, 6, 11, 12, 1, 17, 19, 13, 14,
+    6, 11, 12, 1, 17, 15, 13, 14, 6, 11, 12, 1, 17, 13, 14, 6,
+    11, 12, 1, 17, 15, 18, 6, 11, 12, 1, 17, 18, 6, 11, 12, 1,
+    17, 15, 16, 6, 11, 12, 1, 17, 16, 6, 11, 12, 1, 17, 15, 19,
+    6, 11, 12, 1, 17, 19, 6, 11, 12, 1, 17, 15, 6, 11, 12, 1,
+    17, 6, 11, 12, 1, 17, 5, 16, 3, 4, 1, 15, 17, 19, 3, 4,
+    1, 15, 17, 3, 4, 1, 15, 17, 16, 1, 15, 17, 19, 1, 15, 17,
+    1, 15, 17,
+};
+
+constexpr RulePack kPacks[] = {
+    {"default", kDefaultKeys, 11, kDefaultConditions, 52, kDefaultRules, 20, kDefaultNodes, 260, kDefaultBranches, kDefaultLeafRules},
+};
+
+}  // namespace
+
+const RulePack* findRulePack(const std::string& name) {
+    for (const auto& pack : kPacks) {
+        if (name == pack.name) return &pack;
+    }
+    return nullptr;
+}
+
+}  // namespace context_engine
@@ -7,6 +7,8 @@
  *   - gt/lt/gte/lte: 数值比较，超出范围时线性衰减
  *   - in:    值在集合中=1.0
  *   - range: 值在范围内=1.0, 范围外线性衰减
+ *
+ * 值的 quality < 1 时 (托盘数据过期衰减)，高于 0.5 的匹配度按 quality 向 0.5 收缩。
  */
 #include "context_engine.h"
 #include <cmath>
@@ -17,20 +19,6 @@
 
 namespace context_engine {
 
-static bool tryParseDouble(const std::string& s, double& out) {
-    if (s.empty()) return false;
-    const char* start = s.c_str();
-    char* end = nullptr;
-    errno = 0;
-    double val = strtod(start, &end);
-    if (end == start || errno == ERANGE) return false;
-    // Check that entire string was consumed (like stod with pos check)
-    while (*end == ' ' || *end == '\t') end++;
-    if (*end != '\0') return false;
-    out = val;
-    return true;
-}
-
 static std::vector<std::string> splitCsv(const std::string& s) {
     std::vector<std::string> parts;
     std::istringstream ss(s);
@@ -46,15 +34,7 @@ static std::vector<std::string> splitCsv(const std::string& s) {
     return parts;
 }
 
-double softMatch(const Condition& cond, const ContextMap& ctx) {
-    auto it = ctx.find(cond.key);
-    if (it == ctx.end()) {
-        // Missing data → 0.5 (uncertain, not penalized)
-        return 0.5;
-    }
-
-    const std::string& actual = it->second;
-
+static double matchValue(const Condition& cond, const ContextValue& actual) {
     if (cond.op == "eq") {
         return actual == cond.value ? 1.0 : 0.0;
     }
@@ -71,9 +51,9 @@ double softMatch(const Condition& cond, const ContextMap& ctx) {
         return 0.0;
     }
 
-    // Numeric comparisons
+    // Numeric comparisons (both sides decoded when the values were set)
     double actualNum, valueNum;
-    if (!tryParseDouble(actual, actualNum) || !tryParseDouble(cond.value, valueNum)) {
+    if (!actual.number(actualNum) || !cond.value.number(valueNum)) {
         // Can't parse as number → hard fail
         return actual == cond.value ? 1.0 : 0.0;
     }
@@ -106,7 +86,7 @@ double softMatch(const Condition& cond, const ContextMap& ctx) {
         auto parts = splitCsv(cond.value);
         if (parts.size() != 2) return 0.0;
         double lo, hi;
-        if (!tryParseDouble(parts[0], lo) || !tryParseDouble(parts[1], hi)) return 0.0;
+        if (!parseNumber(parts[0], lo) || !parseNumber(parts[1], hi)) return 0.0;
 
         if (actualNum >= lo && actualNum <= hi) return 1.0;
         double dist = actualNum < lo ? (lo - actualNum) : (actualNum - hi);
@@ -117,4 +97,19 @@ double softMatch(const Condition& cond, const ContextMap& ctx) {
     return 0.0;
 }
 
+double softMatch(const Condition& cond, const ContextMap& ctx) {
+    auto it = ctx.find(cond.key);
+    if (it == ctx.end()) {
+        // Missing data → 0.5 (uncertain, not penalized)
+        return 0.5;
+    }
+
+    double match = matchValue(cond, it->second);
+    double quality = it->second.quality();
+    if (quality < 1.0 && match > 0.5) {
+        match = 0.5 + (match - 0.5) * quality;
+    }
+    return match;
+}
+
 }  // namespace context_engine
@@ -0,0 +1,342 @@
+/**
+ * state_log.cpp — 学习状态预写日志 (MAB / LinUCB / cooldown)
+ *
+ * 每次 reward 或规则触发只追加一条记录 (O(1) I/O)，启动时先读快照再重放日志。
+ * 记录格式: [u32 payload 长度][u32 FNV-1a 校验][payload]，尾部不完整则截断。
+ * 日志满 COMPACT_RECORDS 条后由 RuleEngine 压缩为快照 (写临时文件 + rename)。
+ * 两个文件都以 generation 头开始；日志代数与快照不符说明已并入快照，不再重放。
+ * 打开期间对日志加 flock，同一组文件只能被一个实例 (含其他进程) 使用。
+ *
+ * 触发时间在内存中是 steady clock，落盘时换算成 wall clock，重启后再换回。
+ */
+#include "context_engine.h"
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/file.h>
+#include <unistd.h>
+
+namespace context_engine {
+
+namespace {
+
+constexpr uint32_t MAX_PAYLOAD = 1 << 16;
+
+int64_t steadyNowMs() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+int64_t wallNowMs() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+uint32_t fnv1a(const char* data, size_t size) {
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < size; i++) {
+        hash ^= static_cast<uint8_t>(data[i]);
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+template <typename T>
+void put(std::string& out, const T& value) {
+    out.append(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+void putString(std::string& out, const std::string& s) {
+    put(out, static_cast<uint16_t>(s.size()));
+    out.append(s);
+}
+
+/** Sequential reader over one payload; ok() turns false on overrun */
+class Reader {
+public:
+    Reader(const char* data, size_t size) : data_(data), size_(size) {}
+
+    template <typename T>
+    T get() {
+        T value{};
+        if (pos_ + sizeof(T) > size_) {
+            ok_ = false;
+            return value;
+        }
+        std::memcpy(&value, data_ + pos_, sizeof(T));
+        pos_ += sizeof(T);
+        return value;
+    }
+
+    std::string getString() {
+        auto len = get<uint16_t>();
+        if (!ok_ || pos_ + len > size_) {
+            ok_ = false;
+            return "";
+        }
+        std::string s(data_ + pos_, len);
+        pos_ += len;
+        return s;
+    }
+
+    bool ok() const { return ok_; }
+
+private:
+    const char* data_;
+    size_t size_;
+    size_t pos_ = 0;
+    bool ok_ = true;
+};
+
+/** Framed bytes of one record; steady times are converted to wall clock */
+std::string encode(const StateRecord& rec) {
+    std::string payload;
+    put(payload, static_cast<uint8_t>(rec.type));
+    switch (rec.type) {
+        case StateRecord::MabUpdate:
+            putString(payload, rec.id);
+            put(payload, rec.reward);
+            break;
+        case StateRecord::LinUCBUpdate:
+            putString(payload, rec.id);
+            put(payload, rec.reward);
+            put(payload, rec.x);
+            break;
+        case StateRecord::Firing:
+            putString(payload, rec.id);
+            put(payload, wallNowMs() - (steadyNowMs() - rec.timeMs));
+            break;
+        case StateRecord::ClearFirings:
+            break;
+        case StateRecord::MabArm:
+            putString(payload, rec.id);
+            put(payload, static_cast<int32_t>(rec.stats.pulls));
+            put(payload, rec.stats.totalReward);
+            break;
+        case StateRecord::LinUCBArmState:
+            putString(payload, rec.id);
+            put(payload, rec.arm.A);
+            put(payload, rec.arm.b);
+            break;
+        case StateRecord::Header:
+            put(payload, rec.generation);
+            break;
+    }
+    std::string framed;
+    framed.reserve(payload.size() + 8);
+    put(framed, static_cast<uint32_t>(payload.size()));
+    put(framed, fnv1a(payload.data(), payload.size()));
+    framed.append(payload);
+    return framed;
+}
+
+bool decode(const char* data, size_t size, StateRecord& rec) {
+    Reader in(data, size);
+    rec.type = static_cast<StateRecord::Type>(in.get<uint8_t>());
+    switch (rec.type) {
+        case StateRecord::MabUpdate:
+            rec.id = in.getString();
+            rec.reward = in.get<double>();
+            break;
+        case StateRecord::LinUCBUpdate:
+            rec.id = in.getString();
+            rec.reward = in.get<double>();
+            rec.x = in.get<std::array<double, LINUCB_DIM>>();
+            break;
+        case StateRecord::Firing:
+            rec.id = in.getString();
+            rec.timeMs = steadyNowMs() - (wallNowMs() - in.get<int64_t>());
+            break;
+        case StateRecord::ClearFirings:
+            break;
+        case StateRecord::MabArm:
+            rec.id = in.getString();
+            rec.stats.pulls = in.get<int32_t>();
+            rec.stats.totalReward = in.get<double>();
+            break;
+        case StateRecord::LinUCBArmState:
+            rec.id = in.getString();
+            rec.arm.A = in.get<decltype(rec.arm.A)>();
+            rec.arm.b = in.get<decltype(rec.arm.b)>();
+            break;
+        case StateRecord::Header:
+            rec.generation = in.get<uint32_t>();
+            break;
+        default:
+            return false;
+    }
+    return in.ok();
+}
+
+bool readFile(const std::string& path, std::string& out) {
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return false;
+    char buf[16384];
+    ssize_t n;
+    while ((n = ::read(fd, buf, sizeof(buf))) > 0) out.append(buf, static_cast<size_t>(n));
+    ::close(fd);
+    return n == 0;
+}
+
+bool writeAll(int fd, const std::string& bytes) {
+    size_t done = 0;
+    while (done < bytes.size()) {
+        ssize_t n = ::write(fd, bytes.data() + done, bytes.size() - done);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        done += static_cast<size_t>(n);
+    }
+    return true;
+}
+
+StateRecord headerRecord(uint32_t generation) {
+    StateRecord rec;
+    rec.type = StateRecord::Header;
+    rec.generation = generation;
+    return rec;
+}
+
+/**
+ * Replay framed records after the file's generation header. Stops at the first
+ * torn or corrupt record, or right after a header that is not `expected`
+ * (expected < 0 accepts any). Returns the byte length of the valid prefix.
+ */
+size_t replay(const std::string& bytes, int64_t expected,
+              const std::function<void(const StateRecord&)>& fn,
+              int64_t& count, int64_t& generation) {
+    size_t pos = 0;
+    generation = -1;
+    while (pos + 8 <= bytes.size()) {
+        uint32_t len, sum;
+        std::memcpy(&len, bytes.data() + pos, 4);
+        std::memcpy(&sum, bytes.data() + pos + 4, 4);
+        if (len == 0 || len > MAX_PAYLOAD || pos + 8 + len > bytes.size()) break;
+        const char* payload = bytes.data() + pos + 8;
+        StateRecord rec;
+        if (fnv1a(payload, len) != sum || !decode(payload, len, rec)) break;
+        pos += 8 + len;
+        if (rec.type == StateRecord::Header) {
+            generation = rec.generation;
+            if (expected >= 0 && generation != expected) break;
+            continue;
+        }
+        if (generation < 0) break;  // no header: not ours
+        fn(rec);
+        count++;
+    }
+    return pos;
+}
+
+}  // namespace
+
+StateLog::~StateLog() {
+    close();
+}
+
+int64_t StateLog::open(const std::string& dir, const std::string& name,
+                       const std::function<void(const StateRecord&)>& fn) {
+    std::lock_guard<std::mutex> lock(mu_);
+    if (fd_ >= 0) ::close(fd_);
+    fd_ = -1;
+    pending_ = 0;
+    if (name.empty() || name.find('/') != std::string::npos || name == "." || name == "..") return -1;
+    base_ = dir + "/" + name;
+
+    // Lock before reading: another writer would interleave records and race compaction
+    fd_ = ::open(walPath().c_str(), O_WRONLY | O_CREAT | O_CLOEXEC, 0600);
+    if (fd_ < 0) return -1;
+    if (::flock(fd_, LOCK_EX | LOCK_NB) != 0) {
+        ::close(fd_);
+        fd_ = -1;
+        return -1;
+    }
+
+    int64_t count = 0;
+    int64_t generation = -1;
+    std::string bytes;
+    if (readFile(snapPath(), bytes)) replay(bytes, -1, fn, count, generation);
+    generation_ = generation >= 0 ? static_cast<uint32_t>(generation) : 0;
+
+    bytes.clear();
+    int64_t logGeneration = -1;
+    size_t valid = 0;
+    if (readFile(walPath(), bytes)) {
+        int64_t before = count;
+        valid = replay(bytes, generation_, fn, count, logGeneration);
+        pending_ = static_cast<size_t>(count - before);
+    }
+
+    if (logGeneration != generation_) {
+        // New, headerless or already folded into the snapshot
+        if (!resetLog()) {
+            ::close(fd_);
+            fd_ = -1;
+            return -1;
+        }
+    } else if (valid < bytes.size() && ::ftruncate(fd_, static_cast<off_t>(valid)) != 0) {
+        // Could not drop the torn tail; appending after it would lose new records
+        ::close(fd_);
+        fd_ = -1;
+        return -1;
+    }
+    ::lseek(fd_, 0, SEEK_END);
+    return count;
+}
+
+bool StateLog::resetLog() {
+    // Caller must hold mu_
+    pending_ = 0;
+    if (::ftruncate(fd_, 0) != 0) return false;
+    ::lseek(fd_, 0, SEEK_SET);
+    return writeAll(fd_, encode(headerRecord(generation_)));
+}
+
+bool StateLog::isOpen() const {
+    std::lock_guard<std::mutex> lock(mu_);
+    return fd_ >= 0;
+}
+
+void StateLog::close() {
+    std::lock_guard<std::mutex> lock(mu_);
+    if (fd_ >= 0) ::close(fd_);
+    fd_ = -1;
+}
+
+void StateLog::append(const StateRecord& record) {
+    std::lock_guard<std::mutex> lock(mu_);
+    if (fd_ < 0) return;
+    // One write() per record: survives a process crash; a torn tail is dropped on open
+    if (writeAll(fd_, encode(record))) pending_++;
+}
+
+size_t StateLog::pendingRecords() const {
+    std::lock_guard<std::mutex> lock(mu_);
+    return pending_;
+}
+
+bool StateLog::compact(const std::vector<StateRecord>& records) {
+    std::lock_guard<std::mutex> lock(mu_);
+    if (fd_ < 0) return false;
+
+    std::string bytes = encode(headerRecord(generation_ + 1));
+    for (const auto& rec : records) bytes += encode(rec);
+
+    std::string tmpPath = snapPath() + ".tmp";
+    int tmp = ::open(tmpPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+    if (tmp < 0) return false;
+    bool ok = writeAll(tmp, bytes) && ::fsync(tmp) == 0;
+    ::close(tmp);
+    if (!ok || ::rename(tmpPath.c_str(), snapPath().c_str()) != 0) {
+        ::unlink(tmpPath.c_str());
+        return false;
+    }
+    // The snapshot now covers every logged delta; a log left at the old
+    // generation by a crash here is skipped on the next open
+    generation_++;
+    return resetLog();
+}
+
+}  // namespace context_engine
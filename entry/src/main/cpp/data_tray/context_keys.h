@@ -0,0 +1,140 @@
+/**
+ * context_keys.h — 上下文 key 注册表 (编译期)
+ *
+ * 每个已知 key 只在 KEYS 中定义一次：值类型、默认 TTL、决策树特征代价、快照默认值。
+ * data_tray (槽位 / TTL / 快照默认值)、context_engine (决策树 featureCost、LinUCB 特征默认值)
+ * 与 gen_rule_packs.py (内置规则包的分裂代价，构建时读取本文件) 共用这张表。
+ *
+ * 字符串 → id 用编译期找到的完美哈希：只取长度和首 / 中 / 尾三个字符，
+ * 查一次表再比较一次字符串，未知 key 返回 -1。
+ * KEYS 前 REGISTERED_KEY_COUNT 项是托盘的 seqlock 槽位，顺序即持久化布局，只能在末尾追加。
+ */
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <string_view>
+
+namespace data_tray {
+
+/** 槽位值类型 */
+enum class TrayValueType : uint8_t {
+    String = 0,
+    Double = 1,
+    Int = 2,
+    Bool = 3,
+    Enum = 4,     // interned categorical string (motionState, networkType, ...)
+};
+
+/** 已知 key 的静态属性 */
+struct KeyInfo {
+    const char* name;
+    TrayValueType type;         // type the producers write
+    int64_t ttlMs;              // default TTL
+    int cost;                   // decision tree split cost: 0 time < 1 device < 2 motion < 3 location
+    const char* defaultValue;   // snapshot fallback, nullptr: optional field
+};
+
+constexpr int64_t FOREVER_TTL_MS = 0x7FFFFFFF;   // time features: computed, never stale
+constexpr int64_t FALLBACK_TTL_MS = 2 * 60 * 1000;
+constexpr int FALLBACK_FEATURE_COST = 2;         // unknown keys: medium cost
+
+constexpr KeyInfo KEYS[] = {
+    // Registered slots (getSnapshot fields first)
+    {"timeOfDay",    TrayValueType::Enum,   FOREVER_TTL_MS,  0, "unknown"},
+    {"hour",         TrayValueType::Int,    FOREVER_TTL_MS,  0, "0"},
+    {"dayOfWeek",    TrayValueType::Int,    FOREVER_TTL_MS,  0, "0"},
+    {"isWeekend",    TrayValueType::Bool,   FOREVER_TTL_MS,  0, "false"},
+    {"motionState",  TrayValueType::Enum,   30 * 1000,       2, "unknown"},
+    {"batteryLevel", TrayValueType::Int,    5 * 60 * 1000,   1, "100"},
+    {"isCharging",   TrayValueType::Bool,   5 * 60 * 1000,   1, "false"},
+    {"networkType",  TrayValueType::Enum,   2 * 60 * 1000,   1, "none"},
+    {"geofence",     TrayValueType::String, 5 * 60 * 1000,   3, nullptr},
+    {"wifiSsid",     TrayValueType::String, 2 * 60 * 1000,   2, nullptr},
+    {"wifiLostWork", TrayValueType::String, FALLBACK_TTL_MS, 2, nullptr},
+    {"cellId",       TrayValueType::String, 10 * 60 * 1000,  2, nullptr},  // 基站变化较慢
+    {"latitude",     TrayValueType::Double, 2 * 60 * 1000,   3, nullptr},
+    {"longitude",    TrayValueType::Double, 2 * 60 * 1000,   3, nullptr},
+    {"stepCount",    TrayValueType::Int,    30 * 1000,       2, nullptr},
+    {"heartRate",    TrayValueType::Int,    60 * 1000,       2, nullptr},
+    {"ambientLight", TrayValueType::Double, 30 * 1000,       2, nullptr},
+    {"noiseLevel",   TrayValueType::Double, 30 * 1000,       2, nullptr},
+    // Tray-only inputs (overflow): per-category WiFi loss, feeds derived wifiLostWork
+    {"wifiLost_work", TrayValueType::String, 10 * 60 * 1000, 2, nullptr},
+    // Engine-only keys (overflow in the tray)
+    {"minute",       TrayValueType::Int,    FALLBACK_TTL_MS, 0, nullptr},
+    {"location",     TrayValueType::String, FALLBACK_TTL_MS, 3, nullptr},
+};
+constexpr int KEY_COUNT = sizeof(KEYS) / sizeof(KEYS[0]);
+constexpr int REGISTERED_KEY_COUNT = 18;
+static_assert(REGISTERED_KEY_COUNT <= KEY_COUNT, "registered slots are a prefix of KEYS");
+
+namespace detail {
+
+constexpr int HASH_BITS = 6;
+constexpr int HASH_SIZE = 1 << HASH_BITS;
+static_assert(KEY_COUNT < HASH_SIZE / 2, "grow HASH_BITS: a seed gets hard to find");
+
+/** Length plus first / middle / last byte, multiply-mixed; top HASH_BITS bits */
+constexpr uint32_t keyHash(std::string_view key, uint32_t seed) {
+    uint32_t h = seed ^ static_cast<uint32_t>(key.size());
+    h = (h ^ static_cast<uint8_t>(key[0])) * 0x9E3779B1u;
+    h = (h ^ static_cast<uint8_t>(key[key.size() / 2])) * 0x85EBCA77u;
+    h = (h ^ static_cast<uint8_t>(key[key.size() - 1])) * 0xC2B2AE3Du;
+    return h >> (32 - HASH_BITS);
+}
+
+constexpr bool collisionFree(uint32_t seed) {
+    bool used[HASH_SIZE] = {};
+    for (const KeyInfo& info : KEYS) {
+        uint32_t h = keyHash(info.name, seed);
+        if (used[h]) return false;
+        used[h] = true;
+    }
+    return true;
+}
+
+constexpr uint32_t findSeed() {
+    for (uint32_t seed = 1; seed < 100000; seed++) {
+        if (collisionFree(seed)) return seed;
+    }
+    return 0;
+}
+
+constexpr uint32_t SEED = findSeed();
+static_assert(SEED != 0, "no perfect hash seed for KEYS");
+
+constexpr std::array<int8_t, HASH_SIZE> buildTable() {
+    std::array<int8_t, HASH_SIZE> table{};
+    for (auto& id : table) id = -1;
+    for (int i = 0; i < KEY_COUNT; i++) table[keyHash(KEYS[i].name, SEED)] = static_cast<int8_t>(i);
+    return table;
+}
+
+constexpr std::array<int8_t, HASH_SIZE> TABLE = buildTable();
+
+}  // namespace detail
+
+/** Index of key in KEYS, -1 if unknown */
+constexpr int keyId(std::string_view key) {
+    if (key.empty()) return -1;
+    int id = detail::TABLE[detail::keyHash(key, detail::SEED)];
+    return id >= 0 && key == KEYS[id].name ? id : -1;
+}
+
+/** 默认 TTL（毫秒），未知 key 为 2 分钟 */
+constexpr int64_t defaultTTL(std::string_view key) {
+    int id = keyId(key);
+    return id >= 0 ? KEYS[id].ttlMs : FALLBACK_TTL_MS;
+}
+
+/** 决策树特征代价：越小越先用来分裂 */
+constexpr int featureCost(std::string_view key) {
+    int id = keyId(key);
+    return id >= 0 ? KEYS[id].cost : FALLBACK_FEATURE_COST;
+}
+
+static_assert(keyId("latitude") == 12 && keyId("location") == KEY_COUNT - 1, "lookup is exact");
+static_assert(keyId("latitudes") == -1 && keyId("") == -1, "unknown keys miss");
+
+}  // namespace data_tray
@@ -4,6 +4,29 @@
  * 感知层和决策层之间的缓存中间层。
  * 传感器异步写入 (put)，引擎同步读取 (get/getSnapshot)。
  * 每个槽位携带 TTL，过期数据 quality 线性衰减。
+ *
+ * 并发: REGISTERED_KEYS 中的 key 各占一个固定的 seqlock 槽位 (连续数组)，
+ * 写者之间按槽位串行，读者从不加锁也不阻塞写者 (版本号变化则重读)；
+ * 其他 key 以及放不进槽位的超长值走带 mutex 的 overflow map。
+ *
+ * 槽位值是带类型标签的 TrayValue (string / double / int / bool / 枚举)，
+ * 数值类型直接以二进制存放，读取方无需再 strtod；字符串形式在写入时格式化一次。
+ *
+ * 变化订阅: 只有值真正改变 (或 quality 跨过阈值) 的 key 才标脏，
+ * 每个订阅按自己的防抖窗口合并后在通知线程上回调一次。
+ *
+ * 历史: enableHistory(key) 后数值写入同时进入该 key 的有界环形缓冲 (tray_history.h)，
+ * 可直接查询窗口内的 min / max / mean / slope。
+ *
+ * 持久化: openBacking(path) 后注册槽位的每次写入同时落到 mmap 文件 (tray_backing.h)，
+ * 重启后按 wall clock 恢复年龄，托盘立即可用。
+ *
+ * 到期: enableExpiry() 后每个 key 在时间轮 (tray_timer_wheel.h) 上挂一个定时器，
+ * 年龄到 TTL 时发 Stale 事件，到 2×TTL (quality 衰减为 0) 时移除并发 Evicted 事件。
+ *
+ * 派生: registerDerived(key, inputs, clockMs, fn) 后 key 的值由原生函数从时钟和其他槽位算出，
+ * 读取时才计算，输入槽位的版本与时钟桶都没变就沿用上次结果 (registerStandardDerived:
+ * hour / timeOfDay / dayOfWeek / isWeekend / wifiLostWork)。
  */
 #pragma once
 
@@ -11,8 +34,27 @@
 #include <unordered_map>
 #include <chrono>
 #include <mutex>
+#include <atomic>
+#include <cstring>
+#include <cstdio>
+#include <thread>
 #include <optional>
 #include <cstdint>
+#include <vector>
+#include <algorithm>
+#include <memory>
+#include <type_traits>
+#include <functional>
+#include <condition_variable>
+#include <climits>
+#include <cstdlib>
+#include <cstddef>
+#include <array>
+#include <ctime>
+#include "context_keys.h"
+#include "tray_history.h"
+#include "tray_backing.h"
+#include "tray_timer_wheel.h"
 
 namespace data_tray {
 
@@ -20,14 +62,100 @@ namespace data_tray {
 // Data types
 // ============================================================
 
+/** Tagged slot value */
+struct TrayValue {
+    TrayValueType type = TrayValueType::String;
+    double number = 0.0;      // Double
+    int64_t integer = 0;      // Int; Bool as 0/1
+    std::string text;         // String / Enum
+
+    static TrayValue ofString(std::string s) {
+        TrayValue v;
+        v.text = std::move(s);
+        return v;
+    }
+    static TrayValue ofDouble(double d) {
+        TrayValue v;
+        v.type = TrayValueType::Double;
+        v.number = d;
+        return v;
+    }
+    static TrayValue ofInt(int64_t i) {
+        TrayValue v;
+        v.type = TrayValueType::Int;
+        v.integer = i;
+        return v;
+    }
+    static TrayValue ofBool(bool b) {
+        TrayValue v;
+        v.type = TrayValueType::Bool;
+        v.integer = b ? 1 : 0;
+        return v;
+    }
+    static TrayValue ofEnum(std::string s) {
+        TrayValue v = ofString(std::move(s));
+        v.type = TrayValueType::Enum;
+        return v;
+    }
+
+    /** String form, as put(key, string) would have stored it */
+    std::string toString() const {
+        char buf[32];
+        switch (type) {
+            case TrayValueType::Double:
+                std::snprintf(buf, sizeof(buf), "%.15g", number);
+                return buf;
+            case TrayValueType::Int:
+                return std::to_string(integer);
+            case TrayValueType::Bool:
+                return integer ? "true" : "false";
+            default:
+                return text;
+        }
+    }
+
+    /** Numeric view for history: numbers, bools and numeric strings */
+    bool numeric(double& out) const {
+        switch (type) {
+            case TrayValueType::Double:
+                out = number;
+                return true;
+            case TrayValueType::Int:
+            case TrayValueType::Bool:
+                out = static_cast<double>(integer);
+                return true;
+            case TrayValueType::String: {
+                if (text.empty()) return false;
+                char* end = nullptr;
+                out = std::strtod(text.c_str(), &end);
+                return end == text.c_str() + text.size();
+            }
+            default:
+                return false;
+        }
+    }
+
+    bool operator==(const TrayValue& other) const {
+        return type == other.type && number == other.number && integer == other.integer &&
+               text == other.text;
+    }
+
+    const char* typeName() const {
+        static const char* names[] = {"string", "double", "int", "bool", "enum"};
+        return names[static_cast<int>(type)];
+    }
+};
+
 /** 托盘槽位 */
 struct TraySlot {
     std::string key;
-    std::string value;
+    TrayValue value;
     int64_t updatedAt;    // steady_clock ms
     int64_t ttlMs;
     double quality;       // 0~1
     std::string source;
+    bool armed = false;   // overflow key has an expiry timer (guarded by mu_)
+    uint64_t version = 0; // overflow write counter, memo stamp for derived slots
 };
 
 /** 读取结果（含 TTL 衰减后的有效 quality） */
@@ -36,12 +164,29 @@ struct TrayReadResult {
     double quality;       // effective quality after TTL decay
     bool fresh;           // age < ttl
     int64_t ageMs;        // how old the data is
+    TrayValue typed;      // same value with its type (empty string if absent)
+};
+
+/** 批量写入的一项 (putMany) */
+struct TrayPut {
+    std::string key;
+    TrayValue value;
+    double quality = 1.0;
+    std::string source;   // empty: same as key
+};
+
+/** 类型化读取的一项 (readAll) */
+struct TrayEntry {
+    std::string key;
+    TrayValue value;
+    double quality;       // effective quality after TTL decay
 };
 
 /** 调试用状态信息 */
 struct TrayStatus {
     std::string key;
     std::string value;
+    std::string type;     // TrayValue::typeName()
     int64_t ageMs;
     int64_t ttlMs;
     bool fresh;
@@ -66,50 +211,245 @@ struct ContextSnapshot {
     std::optional<std::string> latitude;
     std::optional<std::string> longitude;
     std::optional<std::string> stepCount;
+    uint64_t generation = 0;  // tray generation the fields were read at
 };
 
 // ============================================================
 // 默认 TTL 配置
 // ============================================================
 
-/** 默认 TTL 配置（毫秒） */
+/** 默认 TTL 配置（毫秒），见 context_keys.h */
 inline int64_t getDefaultTTL(const std::string& key) {
-    static const std::unordered_map<std::string, int64_t> defaultTTL = {
-        // 时间类 — 实时计算，永远新鲜
-        {"hour", 0x7FFFFFFF},
-        {"timeOfDay", 0x7FFFFFFF},
-        {"dayOfWeek", 0x7FFFFFFF},
-        {"isWeekend", 0x7FFFFFFF},
-
-        // 设备状态
-        {"batteryLevel", 5 * 60 * 1000},    // 5 min
-        {"isCharging", 5 * 60 * 1000},      // 5 min
-
-        // 网络
-        {"networkType", 2 * 60 * 1000},     // 2 min
-        {"wifiSsid", 2 * 60 * 1000},        // 2 min
-
-        // 运动
-        {"motionState", 30 * 1000},         // 30 sec
-        {"stepCount", 30 * 1000},           // 30 sec
-
-        // 位置
-        {"latitude", 2 * 60 * 1000},        // 2 min
-        {"longitude", 2 * 60 * 1000},       // 2 min
-        {"geofence", 5 * 60 * 1000},        // 5 min
-        {"cellId", 10 * 60 * 1000},         // 10 min - 基站变化较慢
-
-        // 环境
-        {"heartRate", 60 * 1000},           // 1 min
-        {"ambientLight", 30 * 1000},        // 30 sec
-        {"noiseLevel", 30 * 1000},          // 30 sec
-    };
+    return defaultTTL(key);
+}
+
+// ============================================================
+// 注册槽位
+// ============================================================
+
+/** Keys with a fixed seqlock slot, in slot order: the first REGISTERED_KEY_COUNT of KEYS */
+constexpr std::array<const char*, REGISTERED_KEY_COUNT> REGISTERED_KEYS = [] {
+    std::array<const char*, REGISTERED_KEY_COUNT> names{};
+    for (int i = 0; i < REGISTERED_KEY_COUNT; i++) names[i] = KEYS[i].name;
+    return names;
+}();
+
+/** Slot index of each registered key (matches REGISTERED_KEYS order) */
+enum SlotIndex : int {
+    SLOT_TIME_OF_DAY, SLOT_HOUR, SLOT_DAY_OF_WEEK, SLOT_IS_WEEKEND, SLOT_MOTION_STATE,
+    SLOT_BATTERY_LEVEL, SLOT_IS_CHARGING, SLOT_NETWORK_TYPE, SLOT_GEOFENCE, SLOT_WIFI_SSID,
+    SLOT_WIFI_LOST_WORK, SLOT_CELL_ID, SLOT_LATITUDE, SLOT_LONGITUDE, SLOT_STEP_COUNT,
+};
+static_assert(keyId("networkType") == SLOT_NETWORK_TYPE && keyId("geofence") == SLOT_GEOFENCE &&
+              keyId("stepCount") == SLOT_STEP_COUNT, "SlotIndex follows KEYS");
+
+/** Fallbacks for the required snapshot fields (slots before SLOT_GEOFENCE) */
+constexpr std::array<const char*, SLOT_GEOFENCE> SNAPSHOT_DEFAULTS = [] {
+    std::array<const char*, SLOT_GEOFENCE> defaults{};
+    for (int i = 0; i < SLOT_GEOFENCE; i++) defaults[i] = KEYS[i].defaultValue;
+    return defaults;
+}();
 
-    auto it = defaultTTL.find(key);
-    if (it != defaultTTL.end()) {
-        return it->second;
+/** Slot index for a registered key, -1 for overflow keys */
+inline int registeredSlot(const std::string& key) {
+    int id = keyId(key);
+    return id < REGISTERED_KEY_COUNT ? id : -1;
+}
+
+/** 有效 quality: 新鲜期内不变，过期后在 [ttl, 2*ttl) 内线性衰减到 0 */
+inline double decayedQuality(double quality, int64_t age, int64_t ttl) {
+    if (age < ttl) return quality;
+    double decay = 1.0 - static_cast<double>(age - ttl) / static_cast<double>(ttl);
+    return decay > 0 ? quality * decay : 0.0;
+}
+
+inline TrayReadResult decayedRead(TrayValue value, double quality,
+                                  int64_t updatedAt, int64_t ttl, int64_t now) {
+    int64_t age = now - updatedAt;
+    std::string text = value.toString();
+    return {std::move(text), decayedQuality(quality, age, ttl), age < ttl, age, std::move(value)};
+}
+
+/**
+ * Append-only intern table for Enum values: a slot stores the id, so any
+ * category name fits in a seqlock slot. Names are published with a release
+ * store of the count, so name() reads without a lock.
+ */
+class EnumRegistry {
+public:
+    static constexpr int CAPACITY = 256;
+
+    /** Id for name, interning it if new; -1 when the table is full */
+    int intern(const std::string& name) {
+        int n = count_.load(std::memory_order_acquire);
+        for (int i = 0; i < n; i++) {
+            if (names_[i] == name) return i;
+        }
+        std::lock_guard<std::mutex> lock(mu_);
+        n = count_.load(std::memory_order_relaxed);
+        for (int i = 0; i < n; i++) {
+            if (names_[i] == name) return i;
+        }
+        if (n >= CAPACITY) return -1;
+        names_[n] = name;
+        count_.store(n + 1, std::memory_order_release);
+        return n;
+    }
+
+    const std::string& name(int id) const {
+        static const std::string empty;
+        return id >= 0 && id < count_.load(std::memory_order_acquire) ? names_[id] : empty;
+    }
+
+private:
+    std::string names_[CAPACITY];
+    std::atomic<int> count_{0};
+    std::mutex mu_;
+};
+
+/** Inline copy of one registered slot; trivially copyable so a seqlock can copy it */
+struct SlotData {
+    static constexpr size_t VALUE_CAPACITY = 56;
+    static constexpr size_t SOURCE_CAPACITY = 42;
+
+    int64_t updatedAt;
+    double quality;
+    int64_t bits;         // Double (bit pattern), Int, Bool, Enum id
+    uint8_t present;      // 0 = never written / cleared
+    uint8_t spilled;      // value or source too long: full slot is in the spill map
+    uint8_t type;         // TrayValueType
+    uint8_t hasText;      // value[] holds the string form (formatted once by the writer)
+    uint8_t valueLen;
+    uint8_t sourceLen;
+    char value[VALUE_CAPACITY];
+    char source[SOURCE_CAPACITY];
+
+    std::string valueString() const { return std::string(value, valueLen); }
+    std::string sourceString() const { return std::string(source, sourceLen); }
+
+    /** Same stored value (source / time / quality ignored); spilled values never compare equal */
+    bool sameValue(const SlotData& other) const {
+        return present && other.present && !spilled && !other.spilled && type == other.type &&
+               bits == other.bits && hasText == other.hasText && valueLen == other.valueLen &&
+               std::memcmp(value, other.value, valueLen) == 0;
+    }
+};
+static_assert(sizeof(SlotData) % sizeof(uint64_t) == 0, "SlotData is copied as whole words");
+static_assert(REGISTERED_KEY_COUNT <= 64, "dirty bitmap is one uint64_t");
+static_assert(std::is_trivially_copyable<SlotData>::value, "SlotData is persisted as raw bytes");
+
+/**
+ * Single-slot seqlock. The sequence is odd while a write is in progress;
+ * readers copy the payload word by word (relaxed atomics, so no data race)
+ * and retry if the sequence moved. Writers to the same slot serialize on the
+ * sequence itself; readers never block them.
+ */
+struct alignas(64) SeqSlot {
+    static constexpr size_t WORDS = sizeof(SlotData) / sizeof(uint64_t);
+
+    std::atomic<uint32_t> seq{0};
+    std::atomic<int64_t> ttlMs{0};
+    std::atomic<bool> armed{false};  // an expiry timer is pending for this slot
+    std::atomic<uint64_t> words[WORDS] = {};
+
+    void write(const SlotData& data) {
+        uint32_t s = lock();
+        uint64_t buf[WORDS];
+        std::memcpy(buf, &data, sizeof(data));
+        for (size_t i = 0; i < WORDS; i++) words[i].store(buf[i], std::memory_order_relaxed);
+        seq.store(s + 2, std::memory_order_release);
+    }
+
+    /**
+     * Clear the slot and its armed flag if it still holds the write stamped
+     * updatedAt; false if rewritten since. Both happen inside the write section,
+     * so a writer that comes after is ordered after it and sees armed == false.
+     */
+    bool expireIf(int64_t updatedAt) {
+        uint32_t s = lock();
+        int64_t current;
+        uint64_t first = words[0].load(std::memory_order_relaxed);
+        static_assert(offsetof(SlotData, updatedAt) == 0, "updatedAt is the first word");
+        std::memcpy(&current, &first, sizeof(current));
+        bool match = current == updatedAt;
+        if (match) {
+            for (size_t i = 0; i < WORDS; i++) words[i].store(0, std::memory_order_relaxed);
+            armed.store(false, std::memory_order_relaxed);
+        }
+        seq.store(s + 2, std::memory_order_release);
+        return match;
+    }
+
+    void read(SlotData& out) const {
+        uint64_t buf[WORDS];
+        for (int spins = 0;; spins++) {
+            uint32_t s = seq.load(std::memory_order_acquire);
+            if (s & 1) {
+                // Writer mid-update (16 stores); only yield if it was preempted
+                if (spins > 64) std::this_thread::yield();
+                continue;
+            }
+            for (size_t i = 0; i < WORDS; i++) buf[i] = words[i].load(std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (seq.load(std::memory_order_relaxed) == s) break;
+        }
+        std::memcpy(&out, buf, sizeof(out));
+    }
+
+private:
+    /** Take the write side (sequence made odd); returns the even sequence it started from */
+    uint32_t lock() {
+        uint32_t s = seq.load(std::memory_order_relaxed);
+        while ((s & 1) || !seq.compare_exchange_weak(s, s + 1, std::memory_order_acquire,
+                                                     std::memory_order_relaxed)) {
+            if (s & 1) {
+                std::this_thread::yield();
+                s = seq.load(std::memory_order_relaxed);
+            }
+        }
+        std::atomic_thread_fence(std::memory_order_release);
+        return s;
     }
-    return 2 * 60 * 1000;  // FALLBACK: 2 min
+};
+
+/** 变化回调：防抖窗口内真正变化过的 key (注册 key 按槽位顺序，其后是其他 key) */
+using TrayChangeCallback = std::function<void(const std::vector<std::string>& keys)>;
+
+/** TTL 到期事件 */
+enum class TrayExpiry : uint8_t {
+    Stale,     // age reached TTL: quality starts to decay
+    Evicted,   // age reached 2×TTL: quality is 0, the key was removed
+};
+
+/** 到期回调：一次到期处理中的所有事件，按发生顺序 */
+using TrayExpiryCallback = std::function<void(const std::vector<std::pair<std::string, TrayExpiry>>& events)>;
+
+/** 派生槽位的计算结果 */
+struct TrayDerivedValue {
+    std::optional<TrayValue> value;   // nullopt: key absent
+    double quality = 1.0;
+};
+
+/**
+ * 派生函数：wallMs 为当前 wall clock，inputs 与注册时的输入 key 一一对应。
+ * 在托盘内部锁下调用，不能再访问托盘。
+ */
+using TrayDeriveFn = std::function<TrayDerivedValue(int64_t wallMs, const std::vector<TrayReadResult>& inputs)>;
+
+/** Local calendar time for a wall clock ms */
+inline std::tm localTime(int64_t wallMs) {
+    time_t t = static_cast<time_t>(wallMs / 1000);
+    std::tm tm{};
+    localtime_r(&t, &tm);
+    return tm;
+}
+
+/** 时段划分 (与 ArkTS 侧一致) */
+inline const char* timeOfDayName(int hour) {
+    if (hour >= 5 && hour < 12) return "morning";
+    if (hour >= 12 && hour < 17) return "afternoon";
+    if (hour >= 17 && hour < 21) return "evening";
+    return "night";
 }
 
 // ============================================================
@@ -132,136 +472,482 @@ public:
      */
     void put(const std::string& key, const std::string& value,
              double quality = 1.0, const std::string& source = "") {
-        std::lock_guard<std::mutex> lock(mu_);
-        
-        int64_t ttl = getTTL(key);
-        TraySlot slot{
-            key,
-            value,
-            nowMs(),
-            ttl,
-            quality,
-            source.empty() ? key : source
-        };
-        slots_[key] = slot;
+        putValue(key, TrayValue::ofString(value), quality, source);
+    }
+
+    /** 写入数值 (double)，读取方直接拿到二进制值 */
+    void putNumber(const std::string& key, double value,
+                   double quality = 1.0, const std::string& source = "") {
+        putValue(key, TrayValue::ofDouble(value), quality, source);
+    }
+
+    /** 写入整数 (hour, batteryLevel, stepCount, ...) */
+    void putInt(const std::string& key, int64_t value,
+                double quality = 1.0, const std::string& source = "") {
+        putValue(key, TrayValue::ofInt(value), quality, source);
+    }
+
+    /** 写入布尔值，字符串形式为 "true"/"false" */
+    void putBool(const std::string& key, bool value,
+                 double quality = 1.0, const std::string& source = "") {
+        putValue(key, TrayValue::ofBool(value), quality, source);
+    }
+
+    /** 写入枚举值 (motionState, networkType, ...)，名称被驻留为 id */
+    void putEnum(const std::string& key, const std::string& value,
+                 double quality = 1.0, const std::string& source = "") {
+        putValue(key, TrayValue::ofEnum(value), quality, source);
+    }
+
+    /** 写入任意类型的值 */
+    void putValue(const std::string& key, const TrayValue& value,
+                  double quality = 1.0, const std::string& source = "") {
+        int64_t now = nowMs();
+        int idx = registeredSlot(key);
+        bool changed;
+        if (idx < 0) {
+            std::lock_guard<std::mutex> lock(mu_);
+            changed = writeOverflow(key, value, quality, source, now);
+        } else {
+            changed = writeSlot(idx, key, value, quality, source, now, wallNowMs());
+        }
+        bumpGeneration();
+        if (changed) markChanged({{idx, key}});
+        recordHistory(key, value);
+    }
+
+    /**
+     * 批量写入 (一次 NAPI 调用的一整批传感器值)。注册槽位逐个写 seqlock，
+     * 其余 key 共用一次加锁；代数只递增一次，变化通知和历史也各加一次锁。
+     * 同一批内同一 key 出现多次时后者生效。
+     */
+    void putMany(const std::vector<TrayPut>& items) {
+        if (items.empty()) return;
+        int64_t now = nowMs();
+        int64_t wall = wallNowMs();
+        std::vector<int> slots(items.size());
+        std::vector<std::pair<int, std::string>> changes;
+        bool anyOverflow = false;
+        for (size_t i = 0; i < items.size(); i++) {
+            const TrayPut& item = items[i];
+            slots[i] = registeredSlot(item.key);
+            if (slots[i] < 0) {
+                anyOverflow = true;
+            } else if (writeSlot(slots[i], item.key, item.value, item.quality, item.source, now, wall)) {
+                changes.emplace_back(slots[i], item.key);
+            }
+        }
+        if (anyOverflow) {
+            std::lock_guard<std::mutex> lock(mu_);
+            for (size_t i = 0; i < items.size(); i++) {
+                const TrayPut& item = items[i];
+                if (slots[i] < 0 && writeOverflow(item.key, item.value, item.quality, item.source, now)) {
+                    changes.emplace_back(-1, item.key);
+                }
+            }
+        }
+        bumpGeneration();
+        if (!changes.empty()) markChanged(changes);
+
+        if (historyCount_.load(std::memory_order_relaxed) == 0) return;
+        std::lock_guard<std::mutex> lock(historyMu_);
+        for (const TrayPut& item : items) {
+            double x;
+            auto it = histories_.find(item.key);
+            if (it != histories_.end() && item.value.numeric(x)) it->second->add(now, x);
+        }
     }
 
     /**
      * 引擎读取数据（含 TTL 衰减）
      */
     TrayReadResult get(const std::string& key) {
+        int idx = registeredSlot(key);
+        if (isDerived(idx)) refreshDerived();
+        if (idx >= 0) return readSlot(idx, nowMs());
+
         std::lock_guard<std::mutex> lock(mu_);
-        
-        auto it = slots_.find(key);
-        if (it == slots_.end()) {
-            return {std::nullopt, 0.5, false, 0};
+        return readOverflow(key, nowMs());
+    }
+
+    /**
+     * 批量读取，结果与 keys 一一对应；非注册 key 共用一次加锁
+     */
+    std::vector<TrayReadResult> getMany(const std::vector<std::string>& keys) {
+        std::vector<TrayReadResult> results(keys.size());
+        std::vector<int> slots(keys.size());
+        bool anyDerived = false;
+        for (size_t i = 0; i < keys.size(); i++) {
+            slots[i] = registeredSlot(keys[i]);
+            anyDerived |= isDerived(slots[i]);
         }
+        if (anyDerived) refreshDerived();
+        int64_t now = nowMs();
+        bool anyOverflow = false;
+        for (size_t i = 0; i < keys.size(); i++) {
+            if (slots[i] >= 0) {
+                results[i] = readSlot(slots[i], now);
+            } else {
+                anyOverflow = true;
+            }
+        }
+        if (anyOverflow) {
+            std::lock_guard<std::mutex> lock(mu_);
+            for (size_t i = 0; i < keys.size(); i++) {
+                if (slots[i] < 0) results[i] = readOverflow(keys[i], now);
+            }
+        }
+        return results;
+    }
 
-        const TraySlot& slot = it->second;
-        int64_t age = nowMs() - slot.updatedAt;
-        int64_t ttl = slot.ttlMs;
+    /**
+     * 所有有值 key 的类型化值与有效 quality (注册槽位在前，overflow 在后)。
+     * getSnapshot 的必填字段缺失时补同样的默认值 (quality 0.5，同缺失读取)。
+     * 给同进程的原生消费者 (规则引擎 evaluateFromTray) 用，不经过字符串快照。
+     */
+    std::vector<TrayEntry> readAll() {
+        refreshDerived();
+        int64_t now = nowMs();
+        std::vector<TrayEntry> entries;
+        entries.reserve(REGISTERED_KEY_COUNT);
+        for (int i = 0; i < REGISTERED_KEY_COUNT; i++) {
+            SlotData data;
+            slots_[i].read(data);
+            if (data.present) {
+                int64_t ttl = slots_[i].ttlMs.load(std::memory_order_relaxed);
+                entries.push_back({REGISTERED_KEYS[i], slotTyped(i, data),
+                                   decayedQuality(data.quality, now - data.updatedAt, ttl)});
+            } else if (i < SLOT_GEOFENCE) {
+                entries.push_back({REGISTERED_KEYS[i], TrayValue::ofString(SNAPSHOT_DEFAULTS[i]), 0.5});
+            }
+        }
 
-        // 新鲜
-        if (age < ttl) {
-            return {slot.value, slot.quality, true, age};
+        std::lock_guard<std::mutex> lock(mu_);
+        for (const auto& [key, slot] : overflow_) {
+            entries.push_back({slot.key, slot.value,
+                               decayedQuality(slot.quality, now - slot.updatedAt, slot.ttlMs)});
         }
+        return entries;
+    }
 
-        // 过期但未超过 2x TTL — quality 线性衰减
-        double decay = 1.0 - static_cast<double>(age - ttl) / static_cast<double>(ttl);
-        if (decay < 0) decay = 0;
-        double effectiveQuality = slot.quality * decay;
+    /**
+     * 写入代数：每次 put / setTTL / clear 之后递增。
+     * 轮询方记下上次的值，未变化时可直接跳过。
+     */
+    uint64_t generation() const {
+        return generation_.load(std::memory_order_acquire);
+    }
 
-        return {slot.value, effectiveQuality, false, age};
+    /**
+     * 不可变快照 (引用计数共享)。代数未变时返回同一份缓存，
+     * 有写入后才在下一次调用时重建。
+     */
+    std::shared_ptr<const ContextSnapshot> snapshot() {
+        refreshDerived();
+        std::lock_guard<std::mutex> lock(snapshotMu_);
+        // Generation before slots: a put racing the rebuild bumps past gen, so the next call rebuilds
+        uint64_t gen = generation();
+        if (!snapshot_ || snapshot_->generation != gen) {
+            auto snap = std::make_shared<ContextSnapshot>(buildSnapshot());
+            snap->generation = gen;
+            snapshot_ = std::move(snap);
+        }
+        return snapshot_;
     }
 
     /**
-     * 从所有槽位构建 ContextSnapshot
+     * 上下文快照的拷贝 (见 snapshot())
      */
     ContextSnapshot getSnapshot() {
+        return *snapshot();
+    }
+
+    /**
+     * 配置单个 key 的 TTL
+     */
+    void setTTL(const std::string& key, int64_t ttlMs) {
+        int idx = registeredSlot(key);
+        if (idx >= 0) {
+            slots_[idx].ttlMs.store(ttlMs, std::memory_order_relaxed);
+            // Pending timer was set for the old TTL: re-check now
+            if (slots_[idx].armed.load(std::memory_order_relaxed)) rescheduleExpiry(idx, nowMs());
+            bumpGeneration();
+            return;
+        }
+
         std::lock_guard<std::mutex> lock(mu_);
-        
-        ContextSnapshot snap;
-        snap.timeOfDay = getValueOrDefault("timeOfDay", "unknown");
-        snap.hour = getValueOrDefault("hour", "0");
-        snap.dayOfWeek = getValueOrDefault("dayOfWeek", "0");
-        snap.isWeekend = getValueOrDefault("isWeekend", "false");
-        snap.motionState = getValueOrDefault("motionState", "unknown");
-        snap.batteryLevel = getValueOrDefault("batteryLevel", "100");
-        snap.isCharging = getValueOrDefault("isCharging", "false");
-        snap.networkType = getValueOrDefault("networkType", "none");
+        ttlOverrides_[key] = ttlMs;
+        // 更新已有槽位
+        auto it = overflow_.find(key);
+        if (it != overflow_.end()) {
+            it->second.ttlMs = ttlMs;
+            if (it->second.armed) {
+                std::lock_guard<std::mutex> timerLock(expiryMu_);
+                scheduleExpiry(overflowTimers_[key], nowMs());
+            }
+        }
+        bumpGeneration();
+    }
 
-        // Optional fields
-        auto geofence = getUnlocked("geofence");
-        if (geofence.value.has_value()) {
-            snap.geofence = geofence.value;
+    /**
+     * 订阅 key 变化。值改变或 quality 跨过阈值才算变化 (同值重复 put 不算)；
+     * 第一次变化后等待 debounceMs，窗口内所有变化合并为一次回调。
+     * 回调在托盘的通知线程上执行。返回订阅 id。
+     */
+    int subscribe(TrayChangeCallback callback, int64_t debounceMs = 200) {
+        std::lock_guard<std::mutex> lock(subMu_);
+        if (!notifier_.joinable()) notifier_ = std::thread([this] { notifyLoop(); });
+        Subscription sub;
+        sub.id = nextSubId_++;
+        sub.debounceMs = std::max<int64_t>(0, debounceMs);
+        sub.callback = std::move(callback);
+        subs_.push_back(std::move(sub));
+        countSubscribers();
+        return subs_.back().id;
+    }
+
+    /**
+     * 订阅 TTL 到期事件 (需先 enableExpiry)。事件不防抖，在通知线程上回调；
+     * 用 unsubscribe(id) 取消。
+     */
+    int subscribeExpiry(TrayExpiryCallback callback) {
+        std::lock_guard<std::mutex> lock(subMu_);
+        if (!notifier_.joinable()) notifier_ = std::thread([this] { notifyLoop(); });
+        Subscription sub;
+        sub.id = nextSubId_++;
+        sub.onExpiry = std::move(callback);
+        subs_.push_back(std::move(sub));
+        return subs_.back().id;
+    }
+
+    /**
+     * 取消订阅。返回后该订阅不会再被回调 (在它自己的回调里取消时除外)
+     */
+    void unsubscribe(int id) {
+        std::unique_lock<std::mutex> lock(subMu_);
+        subs_.erase(std::remove_if(subs_.begin(), subs_.end(),
+                                   [id](const Subscription& s) { return s.id == id; }),
+                    subs_.end());
+        countSubscribers();
+        // Wait out a delivery already in progress
+        if (std::this_thread::get_id() != notifier_.get_id()) {
+            idleCv_.wait(lock, [this] { return !delivering_; });
         }
-        auto wifiSsid = getUnlocked("wifiSsid");
-        if (wifiSsid.value.has_value()) {
-            snap.wifiSsid = wifiSsid.value;
+    }
+
+    /**
+     * quality 变化阈值：新旧 quality 分处阈值两侧时即使值未变也通知
+     */
+    void setChangeQualityThreshold(double threshold) {
+        qualityThreshold_.store(threshold, std::memory_order_relaxed);
+    }
+
+    /**
+     * 开启 TTL 到期处理 (时间轮粒度 tickMs)。每个 key 只挂一个定时器：写入只在
+     * 未挂时加锁登记，到期线程只处理到期的桶，不扫描槽位；刷新过的 key 到点后顺延。
+     * 年龄到 TTL 发 Stale，到 2×TTL 移除 (算一次变化) 并发 Evicted。
+     * @return false 表示已经开启
+     */
+    bool enableExpiry(int64_t tickMs = 1000) {
+        tickMs = std::max<int64_t>(tickMs, 1);
+        {
+            std::lock_guard<std::mutex> lock(expiryMu_);
+            if (expiryTickMs_.load(std::memory_order_relaxed) > 0) return false;
+            wheel_ = TimerWheel(nowMs() / tickMs);
+            expiryTickMs_.store(tickMs, std::memory_order_relaxed);
+            expirer_ = std::thread([this] { expiryLoop(); });
         }
-        auto wifiLostWork = getUnlocked("wifiLostWork");
-        if (wifiLostWork.value.has_value()) {
-            snap.wifiLostWork = wifiLostWork.value;
+        // Arm what was written (or restored) before
+        SlotData data;
+        for (int i = 0; i < REGISTERED_KEY_COUNT; i++) {
+            slots_[i].read(data);
+            if (data.present) armSlot(i, data.updatedAt);
         }
-        auto cellId = getUnlocked("cellId");
-        if (cellId.value.has_value()) {
-            snap.cellId = cellId.value;
+        std::lock_guard<std::mutex> lock(mu_);
+        for (auto& entry : overflow_) armOverflow(entry.second);
+        return true;
+    }
+
+    /**
+     * 注册派生槽位：key 的值由 fn 从 inputs 和时钟算出，读取时 (get / getMany /
+     * snapshot / readAll / getStatus) 才计算。只有某个输入被写过、或 wall clock
+     * 跨过 clockMs 的整数倍 (0 表示与时钟无关) 时才重算，否则沿用上次结果；值不变不写槽位。
+     * 新鲜度由 fn 决定 (可据输入的 fresh 返回缺失)，所以 TTL 设为永久。
+     * 同一 key 重复注册则替换；外部 put 到派生 key 会在下次重算时被覆盖。
+     * 派生 key 也可以作为后注册的派生槽位的输入。
+     */
+    void registerDerived(const std::string& key, const std::vector<std::string>& inputs,
+                         int64_t clockMs, TrayDeriveFn fn) {
+        DerivedSlot d;
+        d.key = key;
+        d.idx = registeredSlot(key);
+        d.inputs = inputs;
+        for (const auto& input : inputs) d.inputSlots.push_back(registeredSlot(input));
+        d.clockMs = std::max<int64_t>(clockMs, 0);
+        d.fn = std::move(fn);
+        setTTL(key, FOREVER_TTL_MS);
+        {
+            std::lock_guard<std::mutex> lock(derivedMu_);
+            if (d.idx >= 0) {
+                derivedSlots_.fetch_or(uint64_t{1} << d.idx, std::memory_order_relaxed);
+            } else {
+                derivedOverflow_.store(true, std::memory_order_relaxed);
+            }
+            auto it = std::find_if(derived_.begin(), derived_.end(),
+                                   [&key](const DerivedSlot& other) { return other.key == key; });
+            if (it != derived_.end()) {
+                *it = std::move(d);
+            } else {
+                derived_.push_back(std::move(d));
+            }
+            derivedCount_.store(static_cast<int>(derived_.size()), std::memory_order_release);
         }
-        auto lat = getUnlocked("latitude");
-        if (lat.value.has_value()) {
-            snap.latitude = lat.value;
+    }
+
+    /**
+     * 注册内置派生槽位，取代 ArkTS 侧的定时写入：
+     * hour / timeOfDay / dayOfWeek / isWeekend 取本地时间 (按分钟重算)；
+     * wifiLostWork 在按类别的 wifiLost_work 新鲜且为 "true" 时为 "true"，否则缺失
+     * (不看 wifiLostCategory：它只保留最后丢失的类别)。
+     */
+    void registerStandardDerived() {
+        constexpr int64_t MINUTE_MS = 60 * 1000;
+        auto clockOnly = [](TrayValue (*compute)(const std::tm&)) {
+            return [compute](int64_t wallMs, const std::vector<TrayReadResult>&) {
+                return TrayDerivedValue{compute(localTime(wallMs)), 1.0};
+            };
+        };
+        registerDerived("hour", {}, MINUTE_MS, clockOnly([](const std::tm& tm) {
+            return TrayValue::ofInt(tm.tm_hour);
+        }));
+        registerDerived("timeOfDay", {}, MINUTE_MS, clockOnly([](const std::tm& tm) {
+            return TrayValue::ofEnum(timeOfDayName(tm.tm_hour));
+        }));
+        registerDerived("dayOfWeek", {}, MINUTE_MS, clockOnly([](const std::tm& tm) {
+            return TrayValue::ofInt(tm.tm_wday);
+        }));
+        registerDerived("isWeekend", {}, MINUTE_MS, clockOnly([](const std::tm& tm) {
+            return TrayValue::ofBool(tm.tm_wday == 0 || tm.tm_wday == 6);
+        }));
+        // Re-checked every second so it disappears once wifiLost_work goes stale
+        registerDerived("wifiLostWork", {"wifiLost_work"}, 1000,
+                        [](int64_t, const std::vector<TrayReadResult>& in) {
+            const TrayReadResult& lost = in[0];
+            if (!lost.fresh || lost.value != "true") return TrayDerivedValue{};
+            return TrayDerivedValue{TrayValue::ofString("true"), lost.quality};
+        });
+    }
+
+    /**
+     * 打开 mmap 持久化文件并恢复其中的注册槽位 (每个进程只能打开一次)。
+     * 恢复的槽位按写入时的 wall clock 计算年龄，TTL 衰减与重启前一致；
+     * 本次启动后已写入的槽位以内存为准。超长 (spill) 值与非注册 key 不持久化。
+     * @return 恢复的槽位数，失败或已打开返回 -1
+     */
+    int openBacking(const std::string& path) {
+        std::lock_guard<std::mutex> lock(backingMu_);
+        if (backing_.isOpen() || !backing_.open(path, REGISTERED_KEY_COUNT, sizeof(SlotData), layoutHash())) {
+            return -1;
         }
-        auto lon = getUnlocked("longitude");
-        if (lon.value.has_value()) {
-            snap.longitude = lon.value;
+
+        int64_t steadyNow = nowMs();
+        int64_t wallNow = wallNowMs();
+        int restored = 0;
+        for (int i = 0; i < REGISTERED_KEY_COUNT; i++) {
+            SlotData data;
+            SlotData current;
+            int64_t wallAt = 0;
+            if (!backing_.load(i, &data, wallAt) || !data.present || data.spilled) continue;
+            slots_[i].read(current);
+            if (current.present) continue;
+            if (data.type == static_cast<uint8_t>(TrayValueType::Enum)) {
+                // Ids are per process: re-intern by name
+                if (!data.hasText) continue;
+                data.bits = enums_.intern(data.valueString());
+                if (data.bits < 0) data.type = static_cast<uint8_t>(TrayValueType::String);
+            }
+            data.updatedAt = steadyNow - std::max<int64_t>(0, wallNow - wallAt);
+            slots_[i].write(data);
+            armSlot(i, data.updatedAt);
+            restored++;
         }
-        auto steps = getUnlocked("stepCount");
-        if (steps.value.has_value()) {
-            snap.stepCount = steps.value;
+
+        backing_.publish();
+        // Slots put before the file was opened
+        for (int i = 0; i < REGISTERED_KEY_COUNT; i++) {
+            SlotData data;
+            slots_[i].read(data);
+            if (data.present) backing_.store(i, &data, wallNow - (steadyNow - data.updatedAt));
         }
+        bumpGeneration();
+        return restored;
+    }
 
-        return snap;
+    /**
+     * 为 key 启用数值历史 (已启用则按新参数重建)。
+     * @param capacity       环形缓冲容量 (样本/桶数)，内存按 key 有界
+     * @param minIntervalMs  降采样间隔：间隔内的写入并入同一个桶 (均值)，0 表示不降采样
+     */
+    void enableHistory(const std::string& key, size_t capacity, int64_t minIntervalMs = 0) {
+        std::lock_guard<std::mutex> lock(historyMu_);
+        histories_[key] = std::make_unique<SlotHistory>(capacity, minIntervalMs);
+        historyCount_.store(static_cast<int>(histories_.size()), std::memory_order_relaxed);
+    }
+
+    void disableHistory(const std::string& key) {
+        std::lock_guard<std::mutex> lock(historyMu_);
+        histories_.erase(key);
+        historyCount_.store(static_cast<int>(histories_.size()), std::memory_order_relaxed);
     }
 
     /**
-     * 配置单个 key 的 TTL
+     * 最近 windowMs 内的聚合；未启用历史时返回 nullopt (count 为 0 表示窗口内无样本)
      */
-    void setTTL(const std::string& key, int64_t ttlMs) {
-        std::lock_guard<std::mutex> lock(mu_);
-        
-        ttlOverrides_[key] = ttlMs;
-        // 更新已有槽位
-        auto it = slots_.find(key);
-        if (it != slots_.end()) {
-            it->second.ttlMs = ttlMs;
-        }
+    std::optional<TrayAggregate> aggregate(const std::string& key, int64_t windowMs) {
+        int64_t from = nowMs() - windowMs;
+        std::lock_guard<std::mutex> lock(historyMu_);
+        auto it = histories_.find(key);
+        if (it == histories_.end()) return std::nullopt;
+        return it->second->aggregate(from);
+    }
+
+    /**
+     * 最近 windowMs 内的样本 (旧 → 新)
+     */
+    std::vector<TraySample> history(const std::string& key, int64_t windowMs) {
+        int64_t from = nowMs() - windowMs;
+        std::lock_guard<std::mutex> lock(historyMu_);
+        auto it = histories_.find(key);
+        if (it == histories_.end()) return {};
+        return it->second->samples(from);
     }
 
     /**
      * 获取所有槽位的调试状态
      */
     std::vector<TrayStatus> getStatus() {
-        std::lock_guard<std::mutex> lock(mu_);
-        
+        refreshDerived();
         int64_t now = nowMs();
         std::vector<TrayStatus> result;
-        result.reserve(slots_.size());
-        
-        for (const auto& [key, slot] : slots_) {
-            int64_t age = now - slot.updatedAt;
-            bool fresh = age < slot.ttlMs;
-            double decay = fresh ? 1.0 : std::max(0.0, 1.0 - static_cast<double>(age - slot.ttlMs) / static_cast<double>(slot.ttlMs));
-            double eq = slot.quality * decay;
-            
-            result.push_back({
-                slot.key,
-                slot.value,
-                age,
-                slot.ttlMs,
-                fresh,
-                eq,
-                slot.source
-            });
+
+        for (int i = 0; i < REGISTERED_KEY_COUNT; i++) {
+            SlotData data;
+            slots_[i].read(data);
+            if (!data.present) continue;
+            int64_t ttl = slots_[i].ttlMs.load(std::memory_order_relaxed);
+            std::string source = data.sourceString();
+            if (data.spilled) {
+                std::lock_guard<std::mutex> lock(mu_);
+                source = spilled_[i].source;
+            }
+            result.push_back(status(REGISTERED_KEYS[i], slotTyped(i, data), data.updatedAt, ttl,
+                                    data.quality, source, now));
+        }
+
+        std::lock_guard<std::mutex> lock(mu_);
+        for (const auto& [key, slot] : overflow_) {
+            result.push_back(status(slot.key, slot.value, slot.updatedAt, slot.ttlMs,
+                                    slot.quality, slot.source, now));
         }
         return result;
     }
@@ -270,54 +956,650 @@ public:
      * 清除所有数据（测试用）
      */
     void clear() {
-        std::lock_guard<std::mutex> lock(mu_);
-        slots_.clear();
+        {
+            // Cleared derived slots are recomputed on the next read
+            std::lock_guard<std::mutex> lock(derivedMu_);
+            for (auto& d : derived_) d.stamp.clear();
+        }
+        SlotData empty{};
+        SlotData prev;
+        std::vector<int> cleared;
+        for (int i = 0; i < REGISTERED_KEY_COUNT; i++) {
+            slots_[i].read(prev);
+            if (prev.present) cleared.push_back(i);
+            slots_[i].write(empty);
+            backing_.store(i, &empty, 0);
+        }
+        std::vector<std::string> clearedKeys;
+        {
+            std::lock_guard<std::mutex> lock(mu_);
+            for (const auto& entry : overflow_) clearedKeys.push_back(entry.first);
+            overflow_.clear();
+            spilled_.clear();
+        }
+        bumpGeneration();
+        std::vector<std::pair<int, std::string>> changes;
+        for (int idx : cleared) changes.emplace_back(idx, REGISTERED_KEYS[idx]);
+        for (const auto& key : clearedKeys) changes.emplace_back(-1, key);
+        if (!changes.empty()) markChanged(changes);
     }
 
     /**
      * 获取槽位数量
      */
     size_t size() const {
+        size_t count = 0;
+        SlotData data;
+        for (const auto& slot : slots_) {
+            slot.read(data);
+            count += data.present;
+        }
         std::lock_guard<std::mutex> lock(mu_);
-        return slots_.size();
+        return count + overflow_.size();
     }
 
 private:
-    SensorDataTray() = default;
+    SensorDataTray() {
+        for (int i = 0; i < REGISTERED_KEY_COUNT; i++) {
+            slots_[i].ttlMs.store(getDefaultTTL(REGISTERED_KEYS[i]), std::memory_order_relaxed);
+        }
+    }
+    ~SensorDataTray() {
+        {
+            std::lock_guard<std::mutex> lock(expiryMu_);
+            stopExpiry_ = true;
+        }
+        expiryCv_.notify_one();
+        if (expirer_.joinable()) expirer_.join();
+        {
+            std::lock_guard<std::mutex> lock(subMu_);
+            stopNotifier_ = true;
+        }
+        subCv_.notify_one();
+        if (notifier_.joinable()) notifier_.join();
+    }
     SensorDataTray(const SensorDataTray&) = delete;
     SensorDataTray& operator=(const SensorDataTray&) = delete;
 
-    int64_t nowMs() const {
-        auto now = std::chrono::steady_clock::now();
-        return std::chrono::duration_cast<std::chrono::milliseconds>(
-            now.time_since_epoch()).count();
+    struct Subscription {
+        int id = 0;
+        int64_t debounceMs = 0;
+        TrayChangeCallback callback;         // change subscription
+        TrayExpiryCallback onExpiry;         // or expiry subscription
+        std::vector<std::pair<std::string, TrayExpiry>> expired;  // undelivered expiry events
+        uint64_t dirtyMask = 0;              // registered slots, bit = slot index
+        std::vector<std::string> dirtyKeys;  // other keys
+        int64_t deadline = 0;                // 0: nothing pending
+    };
+
+    struct DerivedSlot {
+        std::string key;
+        int idx = -1;                        // registered slot, -1 for an overflow key
+        std::vector<std::string> inputs;
+        std::vector<int> inputSlots;         // registeredSlot() of each input
+        int64_t clockMs = 0;
+        TrayDeriveFn fn;
+        std::vector<uint64_t> stamp;         // clock bucket + input versions at the last compute
+    };
+
+    static constexpr const char* DERIVED_SOURCE = "derived";
+
+    /** Write one registered slot; true if it changed (only computed while someone listens) */
+    bool writeSlot(int idx, const std::string& key, const TrayValue& value, double quality,
+                   const std::string& source, int64_t now, int64_t wall) {
+        const std::string& src = source.empty() ? key : source;
+        SlotData data{};
+        data.updatedAt = now;
+        data.quality = quality;
+        data.present = 1;
+        data.type = static_cast<uint8_t>(value.type);
+        bool fits = src.size() <= SlotData::SOURCE_CAPACITY;
+        switch (value.type) {
+            case TrayValueType::Double:
+                std::memcpy(&data.bits, &value.number, sizeof(data.bits));
+                break;
+            case TrayValueType::Int:
+            case TrayValueType::Bool:
+                data.bits = value.integer;
+                break;
+            case TrayValueType::Enum:
+                data.bits = enums_.intern(value.text);
+                // Table full: keep it as a plain string
+                if (data.bits < 0) data.type = static_cast<uint8_t>(TrayValueType::String);
+                break;
+            default:
+                break;
+        }
+        // String form too, so string readers (getSnapshot) never format per read
+        bool isString = data.type == static_cast<uint8_t>(TrayValueType::String);
+        std::string formatted = value.type == TrayValueType::Double || value.type == TrayValueType::Int ||
+                                value.type == TrayValueType::Bool ? value.toString() : std::string();
+        const std::string& text = formatted.empty() ? value.text : formatted;
+        if (text.size() <= SlotData::VALUE_CAPACITY) {
+            data.hasText = 1;
+            data.valueLen = static_cast<uint8_t>(text.size());
+            std::memcpy(data.value, text.data(), text.size());
+        } else if (isString) {
+            fits = false;
+        }
+        if (fits) {
+            data.sourceLen = static_cast<uint8_t>(src.size());
+            std::memcpy(data.source, src.data(), src.size());
+        } else {
+            // Rare: keep the full strings under the lock, the slot only flags it
+            data.spilled = 1;
+            std::lock_guard<std::mutex> lock(mu_);
+            spilled_[idx] = TraySlot{key, value, data.updatedAt, 0, quality, src};
+        }
+        // Only compare against the previous value when someone listens
+        bool changed = false;
+        if (subscriberCount_.load(std::memory_order_relaxed) > 0) {
+            SlotData prev;
+            slots_[idx].read(prev);
+            changed = !prev.sameValue(data) || crossesThreshold(prev.quality, quality);
+        }
+        slots_[idx].write(data);
+        backing_.store(idx, &data, wall);
+        armSlot(idx, now);
+        return changed;
     }
 
-    std::string getValueOrDefault(const std::string& key, const std::string& defaultValue) {
-        auto result = getUnlocked(key);
-        return result.value.has_value() ? result.value.value() : defaultValue;
+    /** Write one dynamic key; true if its value changed or quality crossed the threshold */
+    bool writeOverflow(const std::string& key, const TrayValue& value, double quality,
+                       const std::string& source, int64_t now) {
+        // Caller must hold mu_
+        auto it = overflow_.find(key);
+        bool changed = it == overflow_.end() || !(it->second.value == value) ||
+                       crossesThreshold(it->second.quality, quality);
+        bool armed = it != overflow_.end() && it->second.armed;
+        TraySlot& slot = overflow_[key];
+        slot = TraySlot{key, value, now, getTTL(key), quality, source.empty() ? key : source, armed,
+                        ++overflowVersion_};
+        armOverflow(slot);
+        return changed;
     }
 
-    // 不加锁版本，内部使用
-    TrayReadResult getUnlocked(const std::string& key) {
-        auto it = slots_.find(key);
-        if (it == slots_.end()) {
-            return {std::nullopt, 0.5, false, 0};
+    TrayReadResult readSlot(int idx, int64_t now) {
+        SlotData data;
+        slots_[idx].read(data);
+        if (!data.present) {
+            return {std::nullopt, 0.5, false, 0, {}};
         }
+        return decayedRead(slotTyped(idx, data), data.quality, data.updatedAt,
+                           slots_[idx].ttlMs.load(std::memory_order_relaxed), now);
+    }
 
+    TrayReadResult readOverflow(const std::string& key, int64_t now) {
+        // Caller must hold mu_
+        auto it = overflow_.find(key);
+        if (it == overflow_.end()) {
+            return {std::nullopt, 0.5, false, 0, {}};
+        }
         const TraySlot& slot = it->second;
-        int64_t age = nowMs() - slot.updatedAt;
-        int64_t ttl = slot.ttlMs;
+        return decayedRead(slot.value, slot.quality, slot.updatedAt, slot.ttlMs, now);
+    }
+
+    void recordHistory(const std::string& key, const TrayValue& value) {
+        if (historyCount_.load(std::memory_order_relaxed) == 0) return;
+        double x;
+        if (!value.numeric(x)) return;
+        std::lock_guard<std::mutex> lock(historyMu_);
+        auto it = histories_.find(key);
+        if (it != histories_.end()) it->second->add(nowMs(), x);
+    }
+
+    static int64_t wallNowMs() {
+        return std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+    }
+
+    /** Persisted slot layout: key order and SlotData size (FNV-1a) */
+    static uint64_t layoutHash() {
+        uint64_t hash = 14695981039346656037ull;
+        auto mix = [&hash](const char* p, size_t n) {
+            for (size_t i = 0; i < n; i++) {
+                hash ^= static_cast<uint8_t>(p[i]);
+                hash *= 1099511628211ull;
+            }
+        };
+        for (const char* key : REGISTERED_KEYS) mix(key, std::strlen(key) + 1);
+        size_t size = sizeof(SlotData);
+        mix(reinterpret_cast<const char*>(&size), sizeof(size));
+        return hash;
+    }
+
+    bool crossesThreshold(double before, double after) const {
+        double threshold = qualityThreshold_.load(std::memory_order_relaxed);
+        return (before >= threshold) != (after >= threshold);
+    }
+
+    /** Flag keys dirty in every subscription; the first change opens the debounce window */
+    void markChanged(const std::vector<std::pair<int, std::string>>& changes) {
+        if (subscriberCount_.load(std::memory_order_relaxed) == 0) return;
+        bool wake = false;
+        {
+            std::lock_guard<std::mutex> lock(subMu_);
+            int64_t now = nowMs();
+            for (auto& sub : subs_) {
+                if (!sub.callback) continue;
+                for (const auto& [idx, key] : changes) {
+                    if (idx >= 0) {
+                        sub.dirtyMask |= uint64_t{1} << idx;
+                    } else if (std::find(sub.dirtyKeys.begin(), sub.dirtyKeys.end(), key) == sub.dirtyKeys.end()) {
+                        sub.dirtyKeys.push_back(key);
+                    }
+                }
+                if (sub.deadline == 0) {
+                    sub.deadline = now + sub.debounceMs;
+                    wake = true;
+                }
+            }
+        }
+        if (wake) subCv_.notify_one();
+    }
+
+    /** Notifier thread: deliver each subscription's dirty keys once its window closes */
+    void notifyLoop() {
+        std::unique_lock<std::mutex> lock(subMu_);
+        while (!stopNotifier_) {
+            int64_t now = nowMs();
+            int64_t next = INT64_MAX;
+            std::vector<std::function<void()>> due;
+            for (auto& sub : subs_) {
+                if (sub.deadline == 0) continue;
+                if (sub.deadline > now) {
+                    next = std::min(next, sub.deadline);
+                    continue;
+                }
+                sub.deadline = 0;
+                if (sub.onExpiry) {
+                    due.emplace_back([callback = sub.onExpiry, events = std::move(sub.expired)] { callback(events); });
+                    sub.expired.clear();
+                    continue;
+                }
+                std::vector<std::string> keys;
+                for (int i = 0; i < REGISTERED_KEY_COUNT; i++) {
+                    if (sub.dirtyMask & (uint64_t{1} << i)) keys.push_back(REGISTERED_KEYS[i]);
+                }
+                keys.insert(keys.end(), sub.dirtyKeys.begin(), sub.dirtyKeys.end());
+                due.emplace_back([callback = sub.callback, keys = std::move(keys)] { callback(keys); });
+                sub.dirtyMask = 0;
+                sub.dirtyKeys.clear();
+            }
+            if (!due.empty()) {
+                // Callbacks run unlocked; unsubscribe() waits on delivering_
+                delivering_ = true;
+                lock.unlock();
+                for (auto& deliver : due) deliver();
+                lock.lock();
+                delivering_ = false;
+                idleCv_.notify_all();
+                continue;
+            }
+            if (next == INT64_MAX) {
+                subCv_.wait(lock);
+            } else {
+                subCv_.wait_for(lock, std::chrono::milliseconds(next - now));
+            }
+        }
+    }
+
+    /** Change subscriptions only (expiry subscriptions don't need writers to diff) */
+    void countSubscribers() {
+        // Caller must hold subMu_
+        int n = static_cast<int>(std::count_if(subs_.begin(), subs_.end(),
+                                               [](const Subscription& s) { return static_cast<bool>(s.callback); }));
+        subscriberCount_.store(n, std::memory_order_relaxed);
+    }
+
+    /** Hand expiry events to every expiry subscription (delivered without debounce) */
+    void queueExpiry(const std::vector<std::pair<std::string, TrayExpiry>>& events) {
+        bool wake = false;
+        {
+            std::lock_guard<std::mutex> lock(subMu_);
+            int64_t now = nowMs();
+            for (auto& sub : subs_) {
+                if (!sub.onExpiry) continue;
+                sub.expired.insert(sub.expired.end(), events.begin(), events.end());
+                if (sub.deadline == 0) sub.deadline = now;
+                wake = true;
+            }
+        }
+        if (wake) subCv_.notify_one();
+    }
+
+    // ---- TTL expiry: timer id = slot index, or REGISTERED_KEY_COUNT + n for overflow keys ----
+
+    /** Give slot idx a timer unless it has one; a no-op while expiry is off */
+    void armSlot(int idx, int64_t updatedAt) {
+        // Checked after the slot write: a concurrent expireIf() is ordered before it
+        if (expiryTickMs_.load(std::memory_order_relaxed) == 0 ||
+            slots_[idx].armed.load(std::memory_order_relaxed)) {
+            return;
+        }
+        std::lock_guard<std::mutex> lock(expiryMu_);
+        if (slots_[idx].armed.exchange(true, std::memory_order_relaxed)) return;
+        scheduleExpiry(idx, updatedAt + slots_[idx].ttlMs.load(std::memory_order_relaxed));
+    }
+
+    void armOverflow(TraySlot& slot) {
+        // Caller must hold mu_
+        if (slot.armed || expiryTickMs_.load(std::memory_order_relaxed) == 0) return;
+        slot.armed = true;
+        std::lock_guard<std::mutex> lock(expiryMu_);
+        auto it = overflowTimers_.find(slot.key);
+        int id;
+        if (it != overflowTimers_.end()) {
+            id = it->second;
+        } else {
+            if (freeTimers_.empty()) {
+                freeTimers_.push_back(REGISTERED_KEY_COUNT + static_cast<int>(timerKeys_.size()));
+                timerKeys_.emplace_back();
+            }
+            id = freeTimers_.back();
+            freeTimers_.pop_back();
+            overflowTimers_[slot.key] = id;
+            timerKeys_[id - REGISTERED_KEY_COUNT] = slot.key;
+        }
+        scheduleExpiry(id, slot.updatedAt + slot.ttlMs);
+    }
+
+    void scheduleExpiry(int id, int64_t atMs) {
+        // Caller must hold expiryMu_
+        int64_t tick = expiryTickMs_.load(std::memory_order_relaxed);
+        wheel_.schedule(id, (atMs + tick - 1) / tick);  // round up: never fire early
+        expiryCv_.notify_one();
+    }
+
+    void rescheduleExpiry(int id, int64_t atMs) {
+        std::lock_guard<std::mutex> lock(expiryMu_);
+        scheduleExpiry(id, atMs);
+    }
 
-        if (age < ttl) {
-            return {slot.value, slot.quality, true, age};
+    /** Expiry thread: fire due timers, sleep until the wheel's next occupied tick */
+    void expiryLoop() {
+        std::unique_lock<std::mutex> lock(expiryMu_);
+        while (!stopExpiry_) {
+            int64_t tick = expiryTickMs_.load(std::memory_order_relaxed);
+            std::vector<int> due;
+            wheel_.advance(nowMs() / tick, [&due](int id) { due.push_back(id); });
+            if (!due.empty()) {
+                // Checks take mu_ / expiryMu_ themselves (lock order mu_ → expiryMu_)
+                lock.unlock();
+                std::vector<std::pair<std::string, TrayExpiry>> events;
+                for (int id : due) {
+                    if (id < REGISTERED_KEY_COUNT) {
+                        checkSlotExpiry(id, events);
+                    } else {
+                        checkOverflowExpiry(id, events);
+                    }
+                }
+                if (!events.empty()) queueExpiry(events);
+                lock.lock();
+                continue;
+            }
+            int64_t next = wheel_.nextTick();
+            if (next < 0) {
+                expiryCv_.wait(lock);
+            } else {
+                expiryCv_.wait_for(lock, std::chrono::milliseconds(next * tick - nowMs()));
+            }
         }
+    }
 
-        double decay = 1.0 - static_cast<double>(age - ttl) / static_cast<double>(ttl);
-        if (decay < 0) decay = 0;
-        double effectiveQuality = slot.quality * decay;
+    /** True the first time timer id sees this write go stale (expiry thread only) */
+    bool noteStale(int id, int64_t updatedAt) {
+        if (static_cast<size_t>(id) >= staleFor_.size()) staleFor_.resize(id + 1, 0);
+        if (staleFor_[id] == updatedAt) return false;
+        staleFor_[id] = updatedAt;
+        return true;
+    }
 
-        return {slot.value, effectiveQuality, false, age};
+    void checkSlotExpiry(int idx, std::vector<std::pair<std::string, TrayExpiry>>& events) {
+        SlotData data;
+        slots_[idx].read(data);
+        int64_t ttl = slots_[idx].ttlMs.load(std::memory_order_relaxed);
+        int64_t age = nowMs() - data.updatedAt;
+        if (data.present && age < 2 * ttl) {
+            if (age >= ttl && noteStale(idx, data.updatedAt)) {
+                events.emplace_back(REGISTERED_KEYS[idx], TrayExpiry::Stale);
+            }
+            rescheduleExpiry(idx, data.updatedAt + (age < ttl ? ttl : 2 * ttl));
+            return;
+        }
+        // Fully decayed (or cleared): drop value and timer unless rewritten meanwhile
+        if (slots_[idx].expireIf(data.updatedAt)) {
+            if (data.present) {
+                SlotData empty{};
+                backing_.store(idx, &empty, 0);
+                bumpGeneration();
+                markChanged({{idx, REGISTERED_KEYS[idx]}});
+                events.emplace_back(REGISTERED_KEYS[idx], TrayExpiry::Evicted);
+            }
+            return;
+        }
+        slots_[idx].read(data);
+        rescheduleExpiry(idx, data.updatedAt + ttl);
+    }
+
+    void checkOverflowExpiry(int id, std::vector<std::pair<std::string, TrayExpiry>>& events) {
+        std::string key;
+        bool evicted = false;
+        {
+            std::lock_guard<std::mutex> lock(mu_);
+            // Timer tables are written under both mu_ and expiryMu_, so either suffices to read
+            key = timerKeys_[id - REGISTERED_KEY_COUNT];
+            auto it = overflow_.find(key);
+            if (it != overflow_.end()) {
+                const TraySlot& slot = it->second;
+                int64_t age = nowMs() - slot.updatedAt;
+                if (age < 2 * slot.ttlMs) {
+                    if (age >= slot.ttlMs && noteStale(id, slot.updatedAt)) {
+                        events.emplace_back(key, TrayExpiry::Stale);
+                    }
+                    rescheduleExpiry(id, slot.updatedAt + (age < slot.ttlMs ? slot.ttlMs : 2 * slot.ttlMs));
+                    return;
+                }
+                overflow_.erase(it);
+                evicted = true;
+            }
+            // Key gone (evicted, or dropped by clear()): release its timer id
+            std::lock_guard<std::mutex> timerLock(expiryMu_);
+            overflowTimers_.erase(key);
+            timerKeys_[id - REGISTERED_KEY_COUNT].clear();
+            freeTimers_.push_back(id);
+        }
+        if (evicted) {
+            bumpGeneration();
+            markChanged({{-1, key}});
+            events.emplace_back(key, TrayExpiry::Evicted);
+        }
+    }
+
+    // ---- Derived slots ----
+
+    /** Recompute derived slots whose clock bucket or inputs moved since their last compute */
+    void refreshDerived() {
+        if (derivedCount_.load(std::memory_order_acquire) == 0) return;
+        std::vector<std::pair<int, std::string>> changes;
+        bool wrote = false;
+        {
+            std::lock_guard<std::mutex> lock(derivedMu_);
+            int64_t now = nowMs();
+            int64_t wall = wallNowMs();
+            std::vector<TrayReadResult> inputs;
+            for (DerivedSlot& d : derived_) {
+                // Stamp before reading: a write in between only causes one extra recompute
+                derivedStamp(d, wall, stampScratch_);
+                if (stampScratch_ == d.stamp) continue;
+                d.stamp.swap(stampScratch_);
+
+                inputs.clear();
+                for (size_t i = 0; i < d.inputs.size(); i++) {
+                    if (d.inputSlots[i] >= 0) {
+                        inputs.push_back(readSlot(d.inputSlots[i], now));
+                    } else {
+                        std::lock_guard<std::mutex> overflowLock(mu_);
+                        inputs.push_back(readOverflow(d.inputs[i], now));
+                    }
+                }
+                TrayDerivedValue result = d.fn(wall, inputs);
+                bool changed = false;
+                if (writeDerived(d, result, now, wall, changed)) wrote = true;
+                if (changed) changes.emplace_back(d.idx, d.key);
+            }
+        }
+        if (wrote) bumpGeneration();
+        if (!changes.empty()) markChanged(changes);
+    }
+
+    /** Whether reading slot idx (-1: an overflow key) may need a derived refresh first */
+    bool isDerived(int idx) const {
+        if (idx < 0) return derivedOverflow_.load(std::memory_order_relaxed);
+        return (derivedSlots_.load(std::memory_order_relaxed) >> idx) & 1;
+    }
+
+    /** Clock bucket, then one version per input (seqlock sequence / overflow write counter) */
+    void derivedStamp(const DerivedSlot& d, int64_t wall, std::vector<uint64_t>& out) {
+        // Caller must hold derivedMu_
+        out.clear();
+        out.push_back(d.clockMs > 0 ? static_cast<uint64_t>(wall / d.clockMs) : 0);
+        bool anyOverflow = false;
+        for (int idx : d.inputSlots) {
+            out.push_back(idx >= 0 ? slots_[idx].seq.load(std::memory_order_acquire) : 0);
+            anyOverflow |= idx < 0;
+        }
+        if (!anyOverflow) return;
+        std::lock_guard<std::mutex> lock(mu_);
+        for (size_t i = 0; i < d.inputs.size(); i++) {
+            if (d.inputSlots[i] >= 0) continue;
+            auto it = overflow_.find(d.inputs[i]);
+            out[i + 1] = it != overflow_.end() ? it->second.version : 0;
+        }
+    }
+
+    /** Store a derived result unless the key already holds it; true if the tray was written */
+    bool writeDerived(const DerivedSlot& d, const TrayDerivedValue& result, int64_t now, int64_t wall,
+                      bool& changed) {
+        // Caller must hold derivedMu_
+        TrayReadResult current;
+        if (d.idx >= 0) {
+            current = readSlot(d.idx, now);
+        } else {
+            std::lock_guard<std::mutex> lock(mu_);
+            current = readOverflow(d.key, now);
+        }
+        if (!result.value) {
+            if (!current.value) return false;
+            if (d.idx >= 0) {
+                // Timer (if armed) finds the slot empty and just disarms
+                SlotData empty{};
+                slots_[d.idx].write(empty);
+                backing_.store(d.idx, &empty, 0);
+            } else {
+                std::lock_guard<std::mutex> lock(mu_);
+                overflow_.erase(d.key);
+            }
+            changed = true;
+            return true;
+        }
+        if (current.value && current.typed == *result.value && current.quality == result.quality) {
+            return false;
+        }
+        if (d.idx >= 0) {
+            changed = writeSlot(d.idx, d.key, *result.value, result.quality, DERIVED_SOURCE, now, wall);
+        } else {
+            std::lock_guard<std::mutex> lock(mu_);
+            changed = writeOverflow(d.key, *result.value, result.quality, DERIVED_SOURCE, now);
+        }
+        return true;
+    }
+
+    void bumpGeneration() {
+        // Release: a reader that sees the new generation also sees the write
+        generation_.fetch_add(1, std::memory_order_release);
+    }
+
+    /** 从所有槽位构建 ContextSnapshot (只读注册槽位，不加锁) */
+    ContextSnapshot buildSnapshot() {
+        ContextSnapshot snap;
+        snap.timeOfDay = valueOr(SLOT_TIME_OF_DAY);
+        snap.hour = valueOr(SLOT_HOUR);
+        snap.dayOfWeek = valueOr(SLOT_DAY_OF_WEEK);
+        snap.isWeekend = valueOr(SLOT_IS_WEEKEND);
+        snap.motionState = valueOr(SLOT_MOTION_STATE);
+        snap.batteryLevel = valueOr(SLOT_BATTERY_LEVEL);
+        snap.isCharging = valueOr(SLOT_IS_CHARGING);
+        snap.networkType = valueOr(SLOT_NETWORK_TYPE);
+
+        // Optional fields
+        snap.geofence = optionalValue(SLOT_GEOFENCE);
+        snap.wifiSsid = optionalValue(SLOT_WIFI_SSID);
+        snap.wifiLostWork = optionalValue(SLOT_WIFI_LOST_WORK);
+        snap.cellId = optionalValue(SLOT_CELL_ID);
+        snap.latitude = optionalValue(SLOT_LATITUDE);
+        snap.longitude = optionalValue(SLOT_LONGITUDE);
+        snap.stepCount = optionalValue(SLOT_STEP_COUNT);
+
+        return snap;
+    }
+
+    int64_t nowMs() const {
+        auto now = std::chrono::steady_clock::now();
+        return std::chrono::duration_cast<std::chrono::milliseconds>(
+            now.time_since_epoch()).count();
+    }
+
+    /** Typed value of a read slot; spilled strings come from the locked spill map */
+    TrayValue slotTyped(int idx, const SlotData& data) {
+        TrayValue v;
+        v.type = static_cast<TrayValueType>(data.type);
+        switch (v.type) {
+            case TrayValueType::Double:
+                std::memcpy(&v.number, &data.bits, sizeof(v.number));
+                break;
+            case TrayValueType::Int:
+            case TrayValueType::Bool:
+                v.integer = data.bits;
+                break;
+            case TrayValueType::Enum:
+                v.text = enums_.name(static_cast<int>(data.bits));
+                break;
+            default:
+                if (data.hasText) {
+                    v.text = data.valueString();
+                } else {
+                    std::lock_guard<std::mutex> lock(mu_);
+                    v.text = spilled_[idx].value.text;
+                }
+                break;
+        }
+        return v;
+    }
+
+    std::string slotValue(int idx, const SlotData& data) {
+        if (data.hasText) return data.valueString();
+        return slotTyped(idx, data).toString();
+    }
+
+    std::string valueOr(int idx) {
+        SlotData data;
+        slots_[idx].read(data);
+        return data.present ? slotValue(idx, data) : std::string(SNAPSHOT_DEFAULTS[idx]);
+    }
+
+    std::optional<std::string> optionalValue(int idx) {
+        SlotData data;
+        slots_[idx].read(data);
+        if (!data.present) return std::nullopt;
+        return slotValue(idx, data);
+    }
+
+    static TrayStatus status(const std::string& key, const TrayValue& value, int64_t updatedAt,
+                             int64_t ttl, double quality, const std::string& source, int64_t now) {
+        int64_t age = now - updatedAt;
+        return {key, value.toString(), value.typeName(), age, ttl, age < ttl,
+                decayedQuality(quality, age, ttl), source};
     }
 
     int64_t getTTL(const std::string& key) {
@@ -329,9 +1611,68 @@ private:
         return getDefaultTTL(key);
     }
 
-    std::unordered_map<std::string, TraySlot> slots_;
+    SeqSlot slots_[REGISTERED_KEY_COUNT];
+    EnumRegistry enums_;
+
+    // Guarded by mu_: dynamic keys, and registered values too long for a slot
+    std::unordered_map<std::string, TraySlot> overflow_;
+    std::unordered_map<int, TraySlot> spilled_;
     std::unordered_map<std::string, int64_t> ttlOverrides_;
+    uint64_t overflowVersion_ = 0;
     mutable std::mutex mu_;
+
+    std::atomic<uint64_t> generation_{0};
+    std::shared_ptr<const ContextSnapshot> snapshot_;  // guarded by snapshotMu_
+    std::mutex snapshotMu_;
+
+    MappedRecordFile backing_;  // no-op until openBacking()
+    std::mutex backingMu_;
+
+    // Per-key numeric history, guarded by historyMu_
+    std::unordered_map<std::string, std::unique_ptr<SlotHistory>> histories_;
+    std::atomic<int> historyCount_{0};
+    std::mutex historyMu_;
+
+    // Change subscriptions, guarded by subMu_
+    std::vector<Subscription> subs_;
+    std::atomic<int> subscriberCount_{0};
+    std::atomic<double> qualityThreshold_{0.5};
+    int nextSubId_ = 1;
+    bool stopNotifier_ = false;
+    bool delivering_ = false;
+    std::thread notifier_;
+    std::mutex subMu_;
+    std::condition_variable subCv_;   // notifier: new dirty key or stop
+    std::condition_variable idleCv_;  // unsubscribe: delivery finished
+
+    // TTL expiry (enableExpiry)
+    TimerWheel wheel_;                                      // guarded by expiryMu_
+    std::unordered_map<std::string, int> overflowTimers_;   // key → timer id; written under mu_ + expiryMu_
+    std::vector<std::string> timerKeys_;                    // timer id - REGISTERED_KEY_COUNT → key (same)
+    std::vector<int> freeTimers_;                           // (same)
+    std::vector<int64_t> staleFor_;   // expiry thread only: write a Stale event was sent for
+    std::atomic<int64_t> expiryTickMs_{0};                  // 0: expiry off
+    bool stopExpiry_ = false;
+    std::thread expirer_;
+    std::mutex expiryMu_;
+    std::condition_variable expiryCv_;
+
+    // Derived slots, guarded by derivedMu_ (lock order derivedMu_ → mu_ → expiryMu_)
+    std::vector<DerivedSlot> derived_;
+    std::vector<uint64_t> stampScratch_;
+    std::atomic<int> derivedCount_{0};
+    std::atomic<uint64_t> derivedSlots_{0};   // registered slots that are derived
+    std::atomic<bool> derivedOverflow_{false}; // some overflow key is derived
+    std::mutex derivedMu_;
 };
 
+/**
+ * libdata_tray.so exports the process-wide tray under this C symbol, so other
+ * native modules (context_engine) read the same instance instead of the
+ * getInstance() copy they would get by including this header. The accessor
+ * returns nullptr when the caller was built against another SensorDataTray layout.
+ */
+constexpr const char* SHARED_TRAY_SYMBOL = "DataTraySharedInstance";
+using SharedTrayAccessor = SensorDataTray* (*)(size_t traySize);
+
 }  // namespace data_tray
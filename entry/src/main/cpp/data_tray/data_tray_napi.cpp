@@ -5,6 +5,9 @@
 #include "data_tray.h"
 #include <vector>
 #include <string>
+#include <memory>
+#include <unordered_map>
+#include <chrono>
 
 using namespace data_tray;
 
@@ -116,25 +119,98 @@ static napi_value Put(napi_env env, napi_callback_info info) {
 }
 
 /**
- * dataTray.get(key) → { value, quality, fresh, ageMs }
+ * Shared body of the typed setters: args are (key, value, quality?, source?)
+ * and `read` converts args[1] into a TrayValue.
  */
-static napi_value Get(napi_env env, napi_callback_info info) {
-    size_t argc = 1;
-    napi_value args[1];
+template <typename Read>
+static napi_value PutTyped(napi_env env, napi_callback_info info, const char* name, Read read) {
+    size_t argc = 4;
+    napi_value args[4];
     napi_get_cb_info(env, info, &argc, args, nullptr, nullptr);
 
-    if (argc < 1) {
-        napi_throw_error(env, nullptr, "Expected 1 argument: key");
+    if (argc < 2) {
+        napi_throw_error(env, nullptr, (std::string(name) + ": expected at least 2 arguments: key, value").c_str());
         return nullptr;
     }
 
-    size_t keyLen;
-    napi_get_value_string_utf8(env, args[0], nullptr, 0, &keyLen);
-    std::string key(keyLen, '\0');
-    napi_get_value_string_utf8(env, args[0], &key[0], keyLen + 1, &keyLen);
-    
-    TrayReadResult result = SensorDataTray::getInstance().get(key);
+    size_t len;
+    std::string key, source;
+    napi_get_value_string_utf8(env, args[0], nullptr, 0, &len);
+    key.resize(len);
+    napi_get_value_string_utf8(env, args[0], &key[0], len + 1, &len);
+
+    double quality = 1.0;
+    if (argc >= 3) {
+        napi_get_value_double(env, args[2], &quality);
+    }
+    if (argc >= 4) {
+        napi_get_value_string_utf8(env, args[3], nullptr, 0, &len);
+        source.resize(len);
+        napi_get_value_string_utf8(env, args[3], &source[0], len + 1, &len);
+    }
+
+    SensorDataTray::getInstance().putValue(key, read(args[1]), quality, source);
+    return nullptr;
+}
+
+/**
+ * dataTray.putNumber(key, value: number, quality?, source?)
+ */
+static napi_value PutNumber(napi_env env, napi_callback_info info) {
+    return PutTyped(env, info, "putNumber", [env](napi_value v) {
+        double d = 0.0;
+        napi_get_value_double(env, v, &d);
+        return TrayValue::ofDouble(d);
+    });
+}
+
+/**
+ * dataTray.putInt(key, value: number, quality?, source?)
+ */
+static napi_value PutInt(napi_env env, napi_callback_info info) {
+    return PutTyped(env, info, "putInt", [env](napi_value v) {
+        int64_t i = 0;
+        napi_get_value_int64(env, v, &i);
+        return TrayValue::ofInt(i);
+    });
+}
+
+/**
+ * dataTray.putBool(key, value: boolean, quality?, source?)
+ */
+static napi_value PutBool(napi_env env, napi_callback_info info) {
+    return PutTyped(env, info, "putBool", [env](napi_value v) {
+        bool b = false;
+        napi_get_value_bool(env, v, &b);
+        return TrayValue::ofBool(b);
+    });
+}
 
+/**
+ * dataTray.putEnum(key, value: string, quality?, source?)
+ */
+static napi_value PutEnum(napi_env env, napi_callback_info info) {
+    return PutTyped(env, info, "putEnum", [env](napi_value v) {
+        size_t len;
+        napi_get_value_string_utf8(env, v, nullptr, 0, &len);
+        std::string s(len, '\0');
+        napi_get_value_string_utf8(env, v, &s[0], len + 1, &len);
+        return TrayValue::ofEnum(std::move(s));
+    });
+}
+
+/** Typed JS value: number for double/int, boolean for bool, string otherwise */
+static napi_value CreateTyped(napi_env env, const TrayValue& v) {
+    switch (v.type) {
+        case TrayValueType::Double: return CreateDouble(env, v.number);
+        case TrayValueType::Int: return CreateInt64(env, v.integer);
+        case TrayValueType::Bool: return CreateBool(env, v.integer != 0);
+        default: return CreateString(env, v.text);
+    }
+}
+
+/** { value, quality, fresh, ageMs, type?, typedValue? } */
+static napi_value CreateReadResult(napi_env env, const TrayReadResult& result) {
     napi_value obj;
     napi_create_object(env, &obj);
 
@@ -150,7 +226,142 @@ static napi_value Get(napi_env env, napi_callback_info info) {
     napi_set_named_property(env, obj, "quality", CreateDouble(env, result.quality));
     napi_set_named_property(env, obj, "fresh", CreateBool(env, result.fresh));
     napi_set_named_property(env, obj, "ageMs", CreateInt64(env, result.ageMs));
+    if (result.value.has_value()) {
+        napi_set_named_property(env, obj, "type", CreateString(env, result.typed.typeName()));
+        napi_set_named_property(env, obj, "typedValue", CreateTyped(env, result.typed));
+    }
+
+    return obj;
+}
+
+/**
+ * dataTray.get(key) → { value, quality, fresh, ageMs, type, typedValue }
+ */
+static napi_value Get(napi_env env, napi_callback_info info) {
+    size_t argc = 1;
+    napi_value args[1];
+    napi_get_cb_info(env, info, &argc, args, nullptr, nullptr);
+
+    if (argc < 1) {
+        napi_throw_error(env, nullptr, "Expected 1 argument: key");
+        return nullptr;
+    }
 
+    size_t keyLen;
+    napi_get_value_string_utf8(env, args[0], nullptr, 0, &keyLen);
+    std::string key(keyLen, '\0');
+    napi_get_value_string_utf8(env, args[0], &key[0], keyLen + 1, &keyLen);
+    
+    return CreateReadResult(env, SensorDataTray::getInstance().get(key));
+}
+
+
+/**
+ * One putMany entry's value: string / boolean / number, or an explicit
+ * type ('string' | 'double' | 'int' | 'bool' | 'enum'). Numbers default to double.
+ */
+static bool ReadEntryValue(napi_env env, napi_value entry, TrayValue& out) {
+    napi_value value;
+    napi_valuetype valueType = napi_undefined;
+    if (napi_get_named_property(env, entry, "value", &value) != napi_ok) return false;
+    napi_typeof(env, value, &valueType);
+    std::string type = GetStringProp(env, entry, "type");
+
+    if (valueType == napi_number) {
+        if (type == "int") {
+            int64_t i = 0;
+            napi_get_value_int64(env, value, &i);
+            out = TrayValue::ofInt(i);
+        } else {
+            double d = 0.0;
+            napi_get_value_double(env, value, &d);
+            out = TrayValue::ofDouble(d);
+        }
+        return true;
+    }
+    if (valueType == napi_boolean) {
+        bool b = false;
+        napi_get_value_bool(env, value, &b);
+        out = TrayValue::ofBool(b);
+        return true;
+    }
+    if (valueType == napi_string) {
+        std::string text = GetStringProp(env, entry, "value");
+        out = type == "enum" ? TrayValue::ofEnum(std::move(text)) : TrayValue::ofString(std::move(text));
+        return true;
+    }
+    return false;
+}
+
+/**
+ * dataTray.putMany(entries: Array<{ key, value, type?, quality?, source? }>) → number written
+ *
+ * 一次 NAPI 调用写入一整批传感器值 (见 SensorDataTray::putMany)。
+ */
+static napi_value PutMany(napi_env env, napi_callback_info info) {
+    size_t argc = 1;
+    napi_value args[1];
+    napi_get_cb_info(env, info, &argc, args, nullptr, nullptr);
+
+    bool isArray = false;
+    if (argc >= 1) napi_is_array(env, args[0], &isArray);
+    if (!isArray) {
+        napi_throw_error(env, nullptr, "Expected an array of { key, value, type?, quality?, source? }");
+        return nullptr;
+    }
+
+    uint32_t length = 0;
+    napi_get_array_length(env, args[0], &length);
+    std::vector<TrayPut> items;
+    items.reserve(length);
+    for (uint32_t i = 0; i < length; i++) {
+        napi_value entry;
+        napi_get_element(env, args[0], i, &entry);
+        TrayPut item;
+        item.key = GetStringProp(env, entry, "key");
+        if (item.key.empty() || !ReadEntryValue(env, entry, item.value)) continue;
+        item.quality = GetDoubleProp(env, entry, "quality", 1.0);
+        item.source = GetStringProp(env, entry, "source");
+        items.push_back(std::move(item));
+    }
+
+    SensorDataTray::getInstance().putMany(items);
+    return CreateInt64(env, static_cast<int64_t>(items.size()));
+}
+
+/**
+ * dataTray.getMany(keys: string[]) → { [key]: { value, quality, fresh, ageMs, type?, typedValue? } }
+ */
+static napi_value GetMany(napi_env env, napi_callback_info info) {
+    size_t argc = 1;
+    napi_value args[1];
+    napi_get_cb_info(env, info, &argc, args, nullptr, nullptr);
+
+    bool isArray = false;
+    if (argc >= 1) napi_is_array(env, args[0], &isArray);
+    if (!isArray) {
+        napi_throw_error(env, nullptr, "Expected an array of keys");
+        return nullptr;
+    }
+
+    uint32_t length = 0;
+    napi_get_array_length(env, args[0], &length);
+    std::vector<std::string> keys(length);
+    for (uint32_t i = 0; i < length; i++) {
+        napi_value key;
+        napi_get_element(env, args[0], i, &key);
+        size_t len = 0;
+        napi_get_value_string_utf8(env, key, nullptr, 0, &len);
+        keys[i].resize(len);
+        napi_get_value_string_utf8(env, key, &keys[i][0], len + 1, &len);
+    }
+
+    std::vector<TrayReadResult> results = SensorDataTray::getInstance().getMany(keys);
+    napi_value obj;
+    napi_create_object(env, &obj);
+    for (size_t i = 0; i < keys.size(); i++) {
+        napi_set_named_property(env, obj, keys[i].c_str(), CreateReadResult(env, results[i]));
+    }
     return obj;
 }
 
@@ -158,7 +369,9 @@ static napi_value Get(napi_env env, napi_callback_info info) {
  * dataTray.getSnapshot() → ContextSnapshot object
  */
 static napi_value GetSnapshot(napi_env env, napi_callback_info info) {
-    ContextSnapshot snap = SensorDataTray::getInstance().getSnapshot();
+    // Shared cached snapshot: no C++ string copies when nothing changed
+    std::shared_ptr<const ContextSnapshot> shared = SensorDataTray::getInstance().snapshot();
+    const ContextSnapshot& snap = *shared;
 
     napi_value obj;
     napi_create_object(env, &obj);
@@ -195,6 +408,15 @@ static napi_value GetSnapshot(napi_env env, napi_callback_info info) {
     return obj;
 }
 
+/**
+ * dataTray.getGeneration() → number (changes after every put / setTTL / clear)
+ */
+static napi_value GetGeneration(napi_env env, napi_callback_info info) {
+    napi_value result;
+    napi_create_int64(env, static_cast<int64_t>(SensorDataTray::getInstance().generation()), &result);
+    return result;
+}
+
 /**
  * dataTray.setTTL(key, ttlMs)
  */
@@ -221,6 +443,316 @@ static napi_value SetTTL(napi_env env, napi_callback_info info) {
     return nullptr;
 }
 
+// ============================================================
+// Change subscription (threadsafe function → JS thread)
+// ============================================================
+
+// Subscription id → its threadsafe function; only touched on the JS thread
+static std::unordered_map<int, napi_threadsafe_function> g_changeListeners;
+
+/** Runs on the JS thread: data is the heap vector of changed keys */
+static void CallChangeListener(napi_env env, napi_value jsCallback, void* context, void* data) {
+    std::unique_ptr<std::vector<std::string>> keys(static_cast<std::vector<std::string>*>(data));
+    if (env == nullptr || jsCallback == nullptr) return;  // listener torn down
+
+    napi_value array;
+    napi_create_array_with_length(env, keys->size(), &array);
+    for (size_t i = 0; i < keys->size(); i++) {
+        napi_set_element(env, array, static_cast<uint32_t>(i), CreateString(env, (*keys)[i]));
+    }
+    napi_value undefined;
+    napi_get_undefined(env, &undefined);
+    napi_call_function(env, undefined, jsCallback, 1, &array, nullptr);
+}
+
+/**
+ * dataTray.subscribe(callback: (keys: string[]) => void, debounceMs?) → id
+ */
+static napi_value Subscribe(napi_env env, napi_callback_info info) {
+    size_t argc = 2;
+    napi_value args[2];
+    napi_get_cb_info(env, info, &argc, args, nullptr, nullptr);
+
+    napi_valuetype type = napi_undefined;
+    if (argc >= 1) napi_typeof(env, args[0], &type);
+    if (type != napi_function) {
+        napi_throw_error(env, nullptr, "Expected a callback function");
+        return nullptr;
+    }
+    int64_t debounceMs = 200;
+    if (argc >= 2) napi_get_value_int64(env, args[1], &debounceMs);
+
+    napi_value name;
+    napi_create_string_utf8(env, "dataTrayChange", NAPI_AUTO_LENGTH, &name);
+    napi_threadsafe_function tsfn;
+    if (napi_create_threadsafe_function(env, args[0], nullptr, name, 0, 1, nullptr, nullptr,
+                                        nullptr, CallChangeListener, &tsfn) != napi_ok) {
+        napi_throw_error(env, nullptr, "Failed to create change listener");
+        return nullptr;
+    }
+    // A listener alone must not keep the event loop alive
+    napi_unref_threadsafe_function(env, tsfn);
+
+    int id = SensorDataTray::getInstance().subscribe([tsfn](const std::vector<std::string>& keys) {
+        auto* data = new std::vector<std::string>(keys);
+        if (napi_call_threadsafe_function(tsfn, data, napi_tsfn_nonblocking) != napi_ok) delete data;
+    }, debounceMs);
+    g_changeListeners[id] = tsfn;
+    return CreateInt64(env, id);
+}
+
+/**
+ * dataTray.unsubscribe(id)
+ */
+static napi_value Unsubscribe(napi_env env, napi_callback_info info) {
+    size_t argc = 1;
+    napi_value args[1];
+    napi_get_cb_info(env, info, &argc, args, nullptr, nullptr);
+
+    int32_t id = 0;
+    if (argc < 1 || napi_get_value_int32(env, args[0], &id) != napi_ok) return nullptr;
+
+    // No native callback can reach the tsfn once unsubscribe() returns
+    SensorDataTray::getInstance().unsubscribe(id);
+    auto it = g_changeListeners.find(id);
+    if (it != g_changeListeners.end()) {
+        napi_release_threadsafe_function(it->second, napi_tsfn_release);
+        g_changeListeners.erase(it);
+    }
+    return nullptr;
+}
+
+/**
+ * dataTray.setChangeQualityThreshold(threshold)
+ */
+static napi_value SetChangeQualityThreshold(napi_env env, napi_callback_info info) {
+    size_t argc = 1;
+    napi_value args[1];
+    napi_get_cb_info(env, info, &argc, args, nullptr, nullptr);
+
+    double threshold;
+    if (argc < 1 || napi_get_value_double(env, args[0], &threshold) != napi_ok) {
+        napi_throw_error(env, nullptr, "Expected 1 argument: threshold");
+        return nullptr;
+    }
+    SensorDataTray::getInstance().setChangeQualityThreshold(threshold);
+    return nullptr;
+}
+
+// ============================================================
+// TTL expiry (timer wheel → notifier thread → JS thread)
+// ============================================================
+
+using ExpiryEvents = std::vector<std::pair<std::string, TrayExpiry>>;
+
+/** Runs on the JS thread: data is the heap vector of expiry events */
+static void CallExpiryListener(napi_env env, napi_value jsCallback, void* context, void* data) {
+    std::unique_ptr<ExpiryEvents> events(static_cast<ExpiryEvents*>(data));
+    if (env == nullptr || jsCallback == nullptr) return;  // listener torn down
+
+    napi_value array;
+    napi_create_array_with_length(env, events->size(), &array);
+    for (size_t i = 0; i < events->size(); i++) {
+        const auto& ev = (*events)[i];
+        napi_value obj;
+        napi_create_object(env, &obj);
+        napi_set_named_property(env, obj, "key", CreateString(env, ev.first));
+        napi_set_named_property(env, obj, "kind",
+                                CreateString(env, ev.second == TrayExpiry::Stale ? "stale" : "evicted"));
+        napi_set_element(env, array, static_cast<uint32_t>(i), obj);
+    }
+    napi_value undefined;
+    napi_get_undefined(env, &undefined);
+    napi_call_function(env, undefined, jsCallback, 1, &array, nullptr);
+}
+
+/**
+ * dataTray.enableExpiry(tickMs?) → false if already enabled
+ */
+static napi_value EnableExpiry(napi_env env, napi_callback_info info) {
+    size_t argc = 1;
+    napi_value args[1];
+    napi_get_cb_info(env, info, &argc, args, nullptr, nullptr);
+
+    int64_t tickMs = 1000;
+    if (argc >= 1) napi_get_value_int64(env, args[0], &tickMs);
+    return CreateBool(env, SensorDataTray::getInstance().enableExpiry(tickMs));
+}
+
+/**
+ * dataTray.subscribeExpiry(callback: (events: {key, kind}[]) => void) → id
+ * 取消订阅同样用 unsubscribe(id)。
+ */
+static napi_value SubscribeExpiry(napi_env env, napi_callback_info info) {
+    size_t argc = 1;
+    napi_value args[1];
+    napi_get_cb_info(env, info, &argc, args, nullptr, nullptr);
+
+    napi_valuetype type = napi_undefined;
+    if (argc >= 1) napi_typeof(env, args[0], &type);
+    if (type != napi_function) {
+        napi_throw_error(env, nullptr, "Expected a callback function");
+        return nullptr;
+    }
+
+    napi_value name;
+    napi_create_string_utf8(env, "dataTrayExpiry", NAPI_AUTO_LENGTH, &name);
+    napi_threadsafe_function tsfn;
+    if (napi_create_threadsafe_function(env, args[0], nullptr, name, 0, 1, nullptr, nullptr,
+                                        nullptr, CallExpiryListener, &tsfn) != napi_ok) {
+        napi_throw_error(env, nullptr, "Failed to create expiry listener");
+        return nullptr;
+    }
+    napi_unref_threadsafe_function(env, tsfn);
+
+    int id = SensorDataTray::getInstance().subscribeExpiry([tsfn](const ExpiryEvents& events) {
+        auto* data = new ExpiryEvents(events);
+        if (napi_call_threadsafe_function(tsfn, data, napi_tsfn_nonblocking) != napi_ok) delete data;
+    });
+    // Shares the id space with change listeners, so unsubscribe() releases it too
+    g_changeListeners[id] = tsfn;
+    return CreateInt64(env, id);
+}
+
+// ============================================================
+// Derived slots
+// ============================================================
+
+/**
+ * dataTray.registerStandardDerived()
+ * 时间特征与 wifiLostWork 改由托盘在读取时计算，ArkTS 不再定时写入
+ */
+static napi_value RegisterStandardDerived(napi_env env, napi_callback_info info) {
+    SensorDataTray::getInstance().registerStandardDerived();
+    return nullptr;
+}
+
+// ============================================================
+// History
+// ============================================================
+
+static std::string GetStringArg(napi_env env, napi_value value) {
+    size_t len = 0;
+    napi_get_value_string_utf8(env, value, nullptr, 0, &len);
+    std::string result(len, '\0');
+    napi_get_value_string_utf8(env, value, &result[0], len + 1, &len);
+    return result;
+}
+
+static int64_t SteadyNowMs() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/**
+ * dataTray.enableHistory(key, capacity, minIntervalMs?)
+ */
+static napi_value EnableHistory(napi_env env, napi_callback_info info) {
+    size_t argc = 3;
+    napi_value args[3];
+    napi_get_cb_info(env, info, &argc, args, nullptr, nullptr);
+
+    if (argc < 2) {
+        napi_throw_error(env, nullptr, "Expected at least 2 arguments: key, capacity");
+        return nullptr;
+    }
+    int64_t capacity = 0;
+    int64_t minIntervalMs = 0;
+    napi_get_value_int64(env, args[1], &capacity);
+    if (argc >= 3) napi_get_value_int64(env, args[2], &minIntervalMs);
+    if (capacity <= 0 || capacity > 100000) {
+        napi_throw_error(env, nullptr, "capacity must be in [1, 100000]");
+        return nullptr;
+    }
+
+    SensorDataTray::getInstance().enableHistory(GetStringArg(env, args[0]),
+                                                static_cast<size_t>(capacity), minIntervalMs);
+    return nullptr;
+}
+
+/**
+ * dataTray.disableHistory(key)
+ */
+static napi_value DisableHistory(napi_env env, napi_callback_info info) {
+    size_t argc = 1;
+    napi_value args[1];
+    napi_get_cb_info(env, info, &argc, args, nullptr, nullptr);
+    if (argc < 1) return nullptr;
+    SensorDataTray::getInstance().disableHistory(GetStringArg(env, args[0]));
+    return nullptr;
+}
+
+/**
+ * dataTray.getAggregate(key, windowMs) → { count, min, max, mean, slopePerSec, spanMs, ageMs } | null
+ */
+static napi_value GetAggregate(napi_env env, napi_callback_info info) {
+    size_t argc = 2;
+    napi_value args[2];
+    napi_get_cb_info(env, info, &argc, args, nullptr, nullptr);
+
+    napi_value result;
+    napi_get_null(env, &result);
+    if (argc < 2) return result;
+    int64_t windowMs = 0;
+    napi_get_value_int64(env, args[1], &windowMs);
+
+    auto agg = SensorDataTray::getInstance().aggregate(GetStringArg(env, args[0]), windowMs);
+    if (!agg || agg->count == 0) return result;
+
+    napi_create_object(env, &result);
+    napi_set_named_property(env, result, "count", CreateInt64(env, static_cast<int64_t>(agg->count)));
+    napi_set_named_property(env, result, "min", CreateDouble(env, agg->min));
+    napi_set_named_property(env, result, "max", CreateDouble(env, agg->max));
+    napi_set_named_property(env, result, "mean", CreateDouble(env, agg->mean));
+    napi_set_named_property(env, result, "slopePerSec", CreateDouble(env, agg->slopePerSec));
+    napi_set_named_property(env, result, "spanMs", CreateInt64(env, agg->lastAt - agg->firstAt));
+    napi_set_named_property(env, result, "ageMs", CreateInt64(env, SteadyNowMs() - agg->lastAt));
+    return result;
+}
+
+/**
+ * dataTray.getHistory(key, windowMs) → Array<{ ageMs, value }> (oldest first)
+ */
+static napi_value GetHistory(napi_env env, napi_callback_info info) {
+    size_t argc = 2;
+    napi_value args[2];
+    napi_get_cb_info(env, info, &argc, args, nullptr, nullptr);
+
+    std::vector<TraySample> samples;
+    if (argc >= 2) {
+        int64_t windowMs = 0;
+        napi_get_value_int64(env, args[1], &windowMs);
+        samples = SensorDataTray::getInstance().history(GetStringArg(env, args[0]), windowMs);
+    }
+
+    int64_t now = SteadyNowMs();
+    napi_value arr;
+    napi_create_array_with_length(env, samples.size(), &arr);
+    for (size_t i = 0; i < samples.size(); i++) {
+        napi_value obj;
+        napi_create_object(env, &obj);
+        napi_set_named_property(env, obj, "ageMs", CreateInt64(env, now - samples[i].at));
+        napi_set_named_property(env, obj, "value", CreateDouble(env, samples[i].value));
+        napi_set_element(env, arr, static_cast<uint32_t>(i), obj);
+    }
+    return arr;
+}
+
+/**
+ * dataTray.openBacking(path) → restored slot count, -1 on failure / already open
+ */
+static napi_value OpenBacking(napi_env env, napi_callback_info info) {
+    size_t argc = 1;
+    napi_value args[1];
+    napi_get_cb_info(env, info, &argc, args, nullptr, nullptr);
+
+    if (argc < 1) {
+        napi_throw_error(env, nullptr, "Expected 1 argument: path");
+        return nullptr;
+    }
+    return CreateInt64(env, SensorDataTray::getInstance().openBacking(GetStringArg(env, args[0])));
+}
+
 /**
  * dataTray.getStatus() → TrayStatus[]
  */
@@ -238,6 +770,7 @@ static napi_value GetStatus(napi_env env, napi_callback_info info) {
 
         napi_set_named_property(env, obj, "key", CreateString(env, s.key));
         napi_set_named_property(env, obj, "value", CreateString(env, s.value));
+        napi_set_named_property(env, obj, "type", CreateString(env, s.type));
         napi_set_named_property(env, obj, "ageMs", CreateInt64(env, s.ageMs));
         napi_set_named_property(env, obj, "ttlMs", CreateInt64(env, s.ttlMs));
         napi_set_named_property(env, obj, "fresh", CreateBool(env, s.fresh));
@@ -277,8 +810,26 @@ EXTERN_C_START
 static napi_value Init(napi_env env, napi_value exports) {
     napi_property_descriptor desc[] = {
         {"put", nullptr, Put, nullptr, nullptr, nullptr, napi_default, nullptr},
+        {"putNumber", nullptr, PutNumber, nullptr, nullptr, nullptr, napi_default, nullptr},
+        {"putInt", nullptr, PutInt, nullptr, nullptr, nullptr, napi_default, nullptr},
+        {"putBool", nullptr, PutBool, nullptr, nullptr, nullptr, napi_default, nullptr},
+        {"putEnum", nullptr, PutEnum, nullptr, nullptr, nullptr, napi_default, nullptr},
         {"get", nullptr, Get, nullptr, nullptr, nullptr, napi_default, nullptr},
+        {"putMany", nullptr, PutMany, nullptr, nullptr, nullptr, napi_default, nullptr},
+        {"getMany", nullptr, GetMany, nullptr, nullptr, nullptr, napi_default, nullptr},
         {"getSnapshot", nullptr, GetSnapshot, nullptr, nullptr, nullptr, napi_default, nullptr},
+        {"getGeneration", nullptr, GetGeneration, nullptr, nullptr, nullptr, napi_default, nullptr},
+        {"subscribe", nullptr, Subscribe, nullptr, nullptr, nullptr, napi_default, nullptr},
+        {"unsubscribe", nullptr, Unsubscribe, nullptr, nullptr, nullptr, napi_default, nullptr},
+        {"enableExpiry", nullptr, EnableExpiry, nullptr, nullptr, nullptr, napi_default, nullptr},
+        {"subscribeExpiry", nullptr, SubscribeExpiry, nullptr, nullptr, nullptr, napi_default, nullptr},
+        {"registerStandardDerived", nullptr, RegisterStandardDerived, nullptr, nullptr, nullptr, napi_default, nullptr},
+        {"setChangeQualityThreshold", nullptr, SetChangeQualityThreshold, nullptr, nullptr, nullptr, napi_default, nullptr},
+        {"openBacking", nullptr, OpenBacking, nullptr, nullptr, nullptr, napi_default, nullptr},
+        {"enableHistory", nullptr, EnableHistory, nullptr, nullptr, nullptr, napi_default, nullptr},
+        {"disableHistory", nullptr, DisableHistory, nullptr, nullptr, nullptr, napi_default, nullptr},
+        {"getAggregate", nullptr, GetAggregate, nullptr, nullptr, nullptr, napi_default, nullptr},
+        {"getHistory", nullptr, GetHistory, nullptr, nullptr, nullptr, napi_default, nullptr},
         {"setTTL", nullptr, SetTTL, nullptr, nullptr, nullptr, napi_default, nullptr},
         {"getStatus", nullptr, GetStatus, nullptr, nullptr, nullptr, napi_default, nullptr},
         {"clear", nullptr, Clear, nullptr, nullptr, nullptr, napi_default, nullptr},
@@ -305,3 +856,8 @@ EXTERN_C_END
 extern "C" __attribute__((constructor)) void RegisterDataTrayModule(void) {
     napi_module_register(&data_tray_module);
 }
+
+// Native access for other modules (see SHARED_TRAY_SYMBOL)
+extern "C" __attribute__((visibility("default"))) SensorDataTray* DataTraySharedInstance(size_t traySize) {
+    return traySize == sizeof(SensorDataTray) ? &SensorDataTray::getInstance() : nullptr;
+}
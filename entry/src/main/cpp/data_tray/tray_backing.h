@@ -0,0 +1,151 @@
+/**
+ * tray_backing.h — 托盘槽位的 mmap 持久化文件
+ *
+ * 文件 = 头部 + 每个注册槽位一条定长记录。写入只是对共享映射做一次
+ * 带序号的 memcpy (序号为奇数表示写入中)，不 fsync：进程崩溃后页缓存仍在，
+ * 重启时读回；序号停在奇数的记录视为写了一半，丢弃。
+ * 记录里的时间是 wall clock，恢复时换算回 steady clock，TTL 衰减照常。
+ */
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace data_tray {
+
+/**
+ * Fixed-size record file shared with the kernel page cache. Payloads are
+ * opaque trivially copyable bytes; layout changes are detected via layoutHash.
+ */
+class MappedRecordFile {
+public:
+    ~MappedRecordFile() {
+        if (base_ != nullptr) {
+            ::msync(base_, size_, MS_ASYNC);
+            ::munmap(base_, size_);
+        }
+        if (fd_ >= 0) ::close(fd_);
+    }
+
+    /**
+     * Map path with `count` records of `payloadSize` bytes. A file written
+     * with a different layout is reset. Records are not published to
+     * writers until publish(), so the caller can restore first.
+     */
+    bool open(const std::string& path, int count, size_t payloadSize, uint64_t layoutHash) {
+        if (base_ != nullptr) return false;
+        count_ = count;
+        stride_ = (sizeof(RecordHeader) + payloadSize + 7) & ~size_t{7};
+        payloadSize_ = payloadSize;
+        size_ = sizeof(FileHeader) + stride_ * static_cast<size_t>(count);
+
+        fd_ = ::open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0600);
+        if (fd_ < 0) return false;
+        struct stat st;
+        if (::fstat(fd_, &st) != 0) return fail();
+
+        FileHeader expected{};
+        std::memcpy(expected.magic, MAGIC, sizeof(expected.magic));
+        expected.layoutHash = layoutHash;
+        expected.count = static_cast<uint32_t>(count);
+        expected.stride = static_cast<uint32_t>(stride_);
+
+        bool fresh = static_cast<size_t>(st.st_size) != size_;
+        if (fresh && (::ftruncate(fd_, 0) != 0 || ::ftruncate(fd_, static_cast<off_t>(size_)) != 0)) {
+            return fail();
+        }
+        void* map = ::mmap(nullptr, size_, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+        if (map == MAP_FAILED) return fail();
+        base_ = static_cast<char*>(map);
+
+        if (fresh || std::memcmp(base_, &expected, sizeof(expected)) != 0) {
+            // New file or another layout: start empty
+            std::memset(base_, 0, size_);
+            std::memcpy(base_, &expected, sizeof(expected));
+        }
+        return true;
+    }
+
+    /** Copy record idx out; false if never written or torn by a crash mid-write */
+    bool load(int idx, void* payload, int64_t& wallAt) {
+        if (base_ == nullptr || idx < 0 || idx >= count_) return false;
+        RecordHeader* rec = record(idx);
+        uint32_t s = rec->seq.load(std::memory_order_acquire);
+        if (s & 1) {
+            rec->seq.store(0, std::memory_order_relaxed);
+            return false;
+        }
+        if (s == 0) return false;
+        wallAt = rec->wallAt;
+        std::memcpy(payload, reinterpret_cast<char*>(rec) + sizeof(RecordHeader), payloadSize_);
+        return true;
+    }
+
+    /** Let store() write through; call once restore is done */
+    void publish() { published_.store(base_ != nullptr, std::memory_order_release); }
+
+    bool isOpen() const { return published_.load(std::memory_order_acquire); }
+
+    /** Fenced write of one record; concurrent writers to a record serialize on its sequence */
+    void store(int idx, const void* payload, int64_t wallAt) {
+        if (!isOpen() || idx < 0 || idx >= count_) return;
+        RecordHeader* rec = record(idx);
+        uint32_t s = rec->seq.load(std::memory_order_relaxed);
+        while ((s & 1) || !rec->seq.compare_exchange_weak(s, s + 1, std::memory_order_acquire,
+                                                          std::memory_order_relaxed)) {
+            if (s & 1) {
+                std::this_thread::yield();
+                s = rec->seq.load(std::memory_order_relaxed);
+            }
+        }
+        rec->wallAt = wallAt;
+        std::memcpy(reinterpret_cast<char*>(rec) + sizeof(RecordHeader), payload, payloadSize_);
+        // Skip 0 on wrap: it means "never written"
+        uint32_t next = s + 2 == 0 ? 2 : s + 2;
+        rec->seq.store(next, std::memory_order_release);
+    }
+
+private:
+    static constexpr char MAGIC[8] = {'D', 'T', 'R', 'A', 'Y', 'v', '1', '\0'};
+
+    struct FileHeader {
+        char magic[8];
+        uint64_t layoutHash;
+        uint32_t count;
+        uint32_t stride;
+    };
+
+    struct RecordHeader {
+        std::atomic<uint32_t> seq;   // 0 = empty, odd = write in progress
+        uint32_t reserved;
+        int64_t wallAt;              // system_clock ms of the slot's updatedAt
+    };
+    static_assert(std::atomic<uint32_t>::is_always_lock_free, "seq lives in a shared mapping");
+
+    RecordHeader* record(int idx) {
+        return reinterpret_cast<RecordHeader*>(base_ + sizeof(FileHeader) + stride_ * static_cast<size_t>(idx));
+    }
+
+    bool fail() {
+        ::close(fd_);
+        fd_ = -1;
+        return false;
+    }
+
+    int fd_ = -1;
+    char* base_ = nullptr;
+    size_t size_ = 0;
+    size_t stride_ = 0;
+    size_t payloadSize_ = 0;
+    int count_ = 0;
+    std::atomic<bool> published_{false};
+};
+
+}  // namespace data_tray
@@ -0,0 +1,219 @@
+/**
+ * tray_history.h — 托盘槽位的有界时间序列历史
+ *
+ * 每个启用历史的 key 一个固定容量的环形缓冲 (时间戳, 数值)。
+ * 窗口聚合 (count / min / max / mean / slope) 总是到最新样本为止：
+ * 二分找窗口起点 O(log n)，和式用前缀和 O(1)，min/max 用环上的线段树 O(log n)。
+ * minIntervalMs > 0 时做降采样：间隔内的样本并入当前桶 (取均值)。
+ */
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+namespace data_tray {
+
+/** 一个历史样本 (降采样时为一个桶的均值) */
+struct TraySample {
+    int64_t at;           // steady_clock ms (bucket start)
+    double value;
+};
+
+/** 窗口聚合结果 */
+struct TrayAggregate {
+    size_t count = 0;     // samples (buckets) in the window
+    double min = 0.0;
+    double max = 0.0;
+    double mean = 0.0;
+    double slopePerSec = 0.0;  // least-squares slope, value units per second
+    int64_t firstAt = 0;
+    int64_t lastAt = 0;
+};
+
+/**
+ * Fixed-capacity ring of numeric samples with running summaries.
+ * Not synchronized: SensorDataTray guards each history with its mutex.
+ */
+class SlotHistory {
+public:
+    SlotHistory(size_t capacity, int64_t minIntervalMs)
+        : cap_(std::max<size_t>(capacity, 1)), minInterval_(std::max<int64_t>(minIntervalMs, 0)),
+          ring_(cap_), lo_(2 * cap_, INF), hi_(2 * cap_, -INF) {}
+
+    size_t capacity() const { return cap_; }
+    int64_t minIntervalMs() const { return minInterval_; }
+
+    void add(int64_t at, double value) {
+        if (size_ > 0 && minInterval_ > 0 && at - newest().at < minInterval_) {
+            // Same bucket: fold into the running mean of the newest entry
+            Entry& e = newest();
+            e.count++;
+            e.value += (value - e.value) / e.count;
+            total_ = e.before;
+            total_.add(seconds(e.at), e.value);
+            setTree(physical(size_ - 1), e.value);
+            return;
+        }
+
+        size_t pos;
+        if (size_ == cap_) {
+            pos = head_;
+            head_ = (head_ + 1) % cap_;
+        } else {
+            pos = physical(size_);
+            size_++;
+        }
+        Entry& e = ring_[pos];
+        e.at = at;
+        e.value = value;
+        e.count = 1;
+        if (size_ == 1) {
+            base_ = at;
+            total_ = Sums{};
+        }
+        e.before = total_;
+        total_.add(seconds(at), value);
+        setTree(pos, value);
+
+        // Re-anchor the prefix sums once per lap so they stay small and exact
+        if (++sinceRebase_ >= cap_) rebase();
+    }
+
+    /** Aggregate over samples with at >= from (up to the newest) */
+    TrayAggregate aggregate(int64_t from) const {
+        TrayAggregate agg;
+        size_t first = lowerBound(from);
+        if (first >= size_) return agg;
+
+        const Entry& e = ring_[physical(first)];
+        Sums s = total_;
+        s.subtract(e.before);
+        double n = static_cast<double>(size_ - first);
+        agg.count = size_ - first;
+        agg.mean = s.v / n;
+        double denom = n * s.tt - s.t * s.t;
+        if (agg.count >= 2 && denom > 1e-12) agg.slopePerSec = (n * s.tv - s.t * s.v) / denom;
+        rangeMinMax(first, size_ - 1, agg.min, agg.max);
+        agg.firstAt = e.at;
+        agg.lastAt = ring_[physical(size_ - 1)].at;
+        return agg;
+    }
+
+    /** Samples with at >= from, oldest first */
+    std::vector<TraySample> samples(int64_t from) const {
+        std::vector<TraySample> out;
+        for (size_t k = lowerBound(from); k < size_; k++) {
+            const Entry& e = ring_[physical(k)];
+            out.push_back({e.at, e.value});
+        }
+        return out;
+    }
+
+private:
+    static constexpr double INF = std::numeric_limits<double>::infinity();
+
+    /** Σt, Σv, Σt², Σtv with t in seconds since base_ */
+    struct Sums {
+        double t = 0.0, v = 0.0, tt = 0.0, tv = 0.0;
+        void add(double x, double y) {
+            t += x;
+            v += y;
+            tt += x * x;
+            tv += x * y;
+        }
+        void subtract(const Sums& o) {
+            t -= o.t;
+            v -= o.v;
+            tt -= o.tt;
+            tv -= o.tv;
+        }
+    };
+
+    struct Entry {
+        int64_t at = 0;
+        double value = 0.0;
+        uint32_t count = 0;   // raw samples folded into this bucket
+        Sums before;          // prefix sums of all older entries
+    };
+
+    size_t physical(size_t logical) const { return (head_ + logical) % cap_; }
+    Entry& newest() { return ring_[physical(size_ - 1)]; }
+    const Entry& newest() const { return ring_[physical(size_ - 1)]; }
+    double seconds(int64_t at) const { return static_cast<double>(at - base_) / 1000.0; }
+
+    /** First logical index with at >= from (timestamps are non-decreasing) */
+    size_t lowerBound(int64_t from) const {
+        size_t lo = 0, hi = size_;
+        while (lo < hi) {
+            size_t mid = (lo + hi) / 2;
+            if (ring_[physical(mid)].at < from) {
+                lo = mid + 1;
+            } else {
+                hi = mid;
+            }
+        }
+        return lo;
+    }
+
+    void rebase() {
+        sinceRebase_ = 0;
+        base_ = ring_[head_].at;
+        total_ = Sums{};
+        for (size_t k = 0; k < size_; k++) {
+            Entry& e = ring_[physical(k)];
+            e.before = total_;
+            total_.add(seconds(e.at), e.value);
+        }
+    }
+
+    // Iterative segment tree over physical positions (leaves at [cap_, 2*cap_))
+    void setTree(size_t pos, double value) {
+        size_t i = pos + cap_;
+        lo_[i] = hi_[i] = value;
+        for (i /= 2; i >= 1; i /= 2) {
+            lo_[i] = std::min(lo_[2 * i], lo_[2 * i + 1]);
+            hi_[i] = std::max(hi_[2 * i], hi_[2 * i + 1]);
+        }
+    }
+
+    void treeQuery(size_t l, size_t r, double& mn, double& mx) const {
+        // Physical [l, r] inclusive
+        for (l += cap_, r += cap_ + 1; l < r; l /= 2, r /= 2) {
+            if (l & 1) {
+                mn = std::min(mn, lo_[l]);
+                mx = std::max(mx, hi_[l++]);
+            }
+            if (r & 1) {
+                mn = std::min(mn, lo_[--r]);
+                mx = std::max(mx, hi_[r]);
+            }
+        }
+    }
+
+    void rangeMinMax(size_t first, size_t last, double& mn, double& mx) const {
+        mn = INF;
+        mx = -INF;
+        size_t a = physical(first), b = physical(last);
+        if (a <= b) {
+            treeQuery(a, b, mn, mx);
+        } else {
+            treeQuery(a, cap_ - 1, mn, mx);
+            treeQuery(0, b, mn, mx);
+        }
+    }
+
+    size_t cap_;
+    int64_t minInterval_;
+    std::vector<Entry> ring_;
+    std::vector<double> lo_, hi_;
+    size_t head_ = 0;         // physical index of the oldest entry
+    size_t size_ = 0;
+    int64_t base_ = 0;        // time origin of the prefix sums
+    size_t sinceRebase_ = 0;
+    Sums total_;              // prefix sums through the newest entry
+};
+
+}  // namespace data_tray
@@ -0,0 +1,140 @@
+/**
+ * tray_timer_wheel.h — 托盘 TTL 到期的分层时间轮
+ *
+ * 4 层 × 64 桶，每层一个桶的跨度是下一层整轮 (64^level 个 tick)。
+ * 定时器用调用方给的整数 id 标识 (托盘: 注册槽位下标，其后是 overflow key)，
+ * 同一 id 重新调度就是移动，不会重复。调度 / 取消 O(1)；推进一个 tick 只
+ * 触发当前桶，上层桶在其周期开始时整体下放一次。
+ */
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+namespace data_tray {
+
+/**
+ * Hierarchical timing wheel over integer ticks. Not synchronized:
+ * SensorDataTray guards its wheel with expiryMu_.
+ */
+class TimerWheel {
+public:
+    static constexpr int LEVELS = 4;
+    static constexpr int BITS = 6;
+    static constexpr int SLOTS = 1 << BITS;
+
+    explicit TimerWheel(int64_t nowTick = 0) : current_(nowTick), heads_(LEVELS * SLOTS, NIL) {}
+
+    /** Last tick advanced to; everything due at or before it has fired */
+    int64_t current() const { return current_; }
+    bool empty() const { return count_ == 0; }
+    size_t size() const { return count_; }
+
+    bool scheduled(int id) const {
+        return id >= 0 && static_cast<size_t>(id) < nodes_.size() && nodes_[id].bucket != NIL;
+    }
+
+    /** (Re)schedule timer id at tick `at`; past ticks fire on the next advance */
+    void schedule(int id, int64_t at) {
+        if (static_cast<size_t>(id) >= nodes_.size()) nodes_.resize(id + 1);
+        cancel(id);
+        // Beyond the top level's reach: park at the horizon, the owner re-checks on fire
+        int64_t horizon = current_ + (int64_t{1} << (BITS * LEVELS)) - 1;
+        nodes_[id].at = std::min(std::max(at, current_ + 1), horizon);
+        link(id);
+        count_++;
+    }
+
+    void cancel(int id) {
+        if (!scheduled(id)) return;
+        unlink(id);
+        count_--;
+    }
+
+    /**
+     * Advance to tick `now`, calling fire(id) for every timer due at or before it.
+     * fire may schedule or cancel timers, including the one that fired.
+     */
+    template <typename Fn>
+    void advance(int64_t now, Fn&& fire) {
+        while (current_ < now) {
+            if (count_ == 0) {
+                current_ = now;
+                return;
+            }
+            current_++;
+            // Entering a new period of level L: spread that level's bucket over the levels below
+            for (int level = 1; level < LEVELS; level++) {
+                if ((current_ & ((int64_t{1} << (BITS * level)) - 1)) != 0) break;
+                int bucket = level * SLOTS + static_cast<int>((current_ >> (BITS * level)) & (SLOTS - 1));
+                int id = heads_[bucket];
+                heads_[bucket] = NIL;
+                while (id != NIL) {
+                    int next = nodes_[id].next;
+                    link(id);
+                    id = next;
+                }
+            }
+            int bucket = static_cast<int>(current_ & (SLOTS - 1));
+            while (heads_[bucket] != NIL) {
+                int id = heads_[bucket];
+                cancel(id);
+                fire(id);
+            }
+        }
+    }
+
+    /**
+     * Earliest tick worth waking for: the next non-empty level-0 bucket, or the
+     * next level-0 wrap (when a higher bucket may cascade down). -1 if empty.
+     */
+    int64_t nextTick() const {
+        if (count_ == 0) return -1;
+        for (int64_t t = current_ + 1;; t++) {
+            if (heads_[t & (SLOTS - 1)] != NIL || (t & (SLOTS - 1)) == 0) return t;
+        }
+    }
+
+private:
+    static constexpr int NIL = -1;
+
+    struct Node {
+        int64_t at = 0;
+        int prev = NIL;
+        int next = NIL;
+        int bucket = NIL;   // NIL = not scheduled
+    };
+
+    /** Bucket for `at`: the highest 6-bit group where it differs from current_ */
+    void link(int id) {
+        Node& n = nodes_[id];
+        int level = 0;
+        while (level < LEVELS - 1 && (n.at >> (BITS * (level + 1))) != (current_ >> (BITS * (level + 1)))) {
+            level++;
+        }
+        n.bucket = level * SLOTS + static_cast<int>((n.at >> (BITS * level)) & (SLOTS - 1));
+        n.prev = NIL;
+        n.next = heads_[n.bucket];
+        if (n.next != NIL) nodes_[n.next].prev = id;
+        heads_[n.bucket] = id;
+    }
+
+    void unlink(int id) {
+        Node& n = nodes_[id];
+        if (n.prev != NIL) {
+            nodes_[n.prev].next = n.next;
+        } else {
+            heads_[n.bucket] = n.next;
+        }
+        if (n.next != NIL) nodes_[n.next].prev = n.prev;
+        n.prev = n.next = n.bucket = NIL;
+    }
+
+    int64_t current_;
+    std::vector<int> heads_;     // LEVELS × SLOTS bucket list heads
+    std::vector<Node> nodes_;    // indexed by timer id
+    size_t count_ = 0;
+};
+
+}  // namespace data_tray
@@ -8,6 +8,7 @@
 #include "geo_utils.h"
 #include <vector>
 #include <unordered_set>
+#include <unordered_map>
 #include <string>
 #include <algorithm>
 #include <cstdint>
@@ -16,6 +17,7 @@ namespace dbscan {
 
 // 使用 geo_utils 的特定函数而非整个命名空间
 using geo_utils::GeoPoint;
+using geo_utils::GeoBatch;
 using geo_utils::haversineDistance;
 using geo_utils::calculateCenter;
 using geo_utils::calculatePercentileRadius;
@@ -81,18 +83,21 @@ public:
         std::vector<int> labels(points.size(), -1);  // -1 = unclassified, -2 = noise, >=0 = cluster id
         int clusterId = 0;
         
+        // SoA 坐标只建一次，每次邻域查询是一趟批量距离
+        GeoBatch batch = GeoBatch::of(points);
+        
         // DBSCAN 主循环
         for (size_t i = 0; i < points.size(); i++) {
             if (labels[i] != -1) continue;  // already processed
             
-            auto neighbors = getNeighbors(points, i);
+            auto neighbors = getNeighbors(points, batch, i);
             if (neighbors.size() < static_cast<size_t>(config_.minSamples)) {
                 labels[i] = -2;  // noise
                 continue;
             }
             
             // 扩展聚类
-            expandCluster(points, i, neighbors, labels, clusterId);
+            expandCluster(points, batch, i, neighbors, labels, clusterId);
             clusterId++;
         }
         
@@ -120,20 +125,10 @@ private:
     /**
      * 获取邻居点
      */
-    std::vector<size_t> getNeighbors(const std::vector<GeoPoint>& points, size_t idx) {
+    std::vector<size_t> getNeighbors(const std::vector<GeoPoint>& points, const GeoBatch& batch, size_t idx) {
         std::vector<size_t> neighbors;
         const auto& p = points[idx];
-        
-        for (size_t i = 0; i < points.size(); i++) {
-            if (i == idx) continue;
-            
-            double dist = haversineDistance(p.latitude, p.longitude, 
-                                           points[i].latitude, points[i].longitude);
-            if (dist <= config_.epsilonMeters) {
-                neighbors.push_back(i);
-            }
-        }
-        
+        geo_utils::pointsWithin(p.latitude, p.longitude, batch, config_.epsilonMeters, neighbors, idx);
         return neighbors;
     }
     
@@ -141,6 +136,7 @@ private:
      * 扩展聚类
      */
     void expandCluster(const std::vector<GeoPoint>& points,
+                       const GeoBatch& batch,
                        size_t idx,
                        std::vector<size_t>& neighbors,
                        std::vector<int>& labels,
@@ -149,6 +145,8 @@ private:
         
         std::vector<size_t> queue = neighbors;
         size_t queueIdx = 0;
+        std::vector<char> queued(points.size(), 0);
+        for (size_t n : queue) queued[n] = 1;
         
         while (queueIdx < queue.size()) {
             size_t current = queue[queueIdx];
@@ -162,18 +160,13 @@ private:
             
             labels[current] = clusterId;
             
-            auto currentNeighbors = getNeighbors(points, current);
+            auto currentNeighbors = getNeighbors(points, batch, current);
             if (currentNeighbors.size() >= static_cast<size_t>(config_.minSamples)) {
                 // 添加新邻居到队列
                 for (size_t n : currentNeighbors) {
-                    if (labels[n] == -1 || labels[n] == -2) {
-                        bool found = false;
-                        for (size_t q : queue) {
-                            if (q == n) { found = true; break; }
-                        }
-                        if (!found) {
-                            queue.push_back(n);
-                        }
+                    if ((labels[n] == -1 || labels[n] == -2) && !queued[n]) {
+                        queued[n] = 1;
+                        queue.push_back(n);
                     }
                 }
             }
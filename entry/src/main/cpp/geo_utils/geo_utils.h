@@ -2,12 +2,26 @@
  * geo_utils.h — 地理计算工具 C++ 实现
  *
  * 高性能地理距离计算和围栏检测
+ *
+ * 批量距离: GeoBatch 以 SoA 存放点集 (弧度 + 预计算 cos(lat) + 包围盒)，
+ * 一次算出一个点到全部点的距离。sin / asin 用多项式近似，NEON / SSE2 一次算两个点；
+ * 查询点与点集都在几公里内时走小角度近似，不算三角函数。
  */
 #pragma once
 
 #include <string>
 #include <vector>
 #include <cmath>
+#include <cstdint>
+#include <algorithm>
+
+#if defined(__aarch64__) && defined(__ARM_NEON)
+#include <arm_neon.h>
+#define GEO_UTILS_NEON 1
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define GEO_UTILS_SSE2 1
+#endif
 
 namespace geo_utils {
 
@@ -93,6 +107,257 @@ inline double haversineDistance(double lat1, double lon1, double lat2, double lo
     return EARTH_RADIUS_METERS * c;
 }
 
+// ============================================================
+// 批量距离 (SoA + SIMD)
+// ============================================================
+
+/**
+ * 点集的 SoA 形式：纬度 / 经度 (弧度)、预计算的 cos(lat)，以及包围盒。
+ * 建一次 (每点一次 cos)，之后每次查询只做乘加和多项式。
+ */
+struct GeoBatch {
+    std::vector<double> lat;
+    std::vector<double> lon;
+    std::vector<double> cosLat;
+    double minLat = 0, maxLat = 0, minLon = 0, maxLon = 0;
+
+    size_t size() const { return lat.size(); }
+
+    void reserve(size_t n) {
+        lat.reserve(n);
+        lon.reserve(n);
+        cosLat.reserve(n);
+    }
+
+    void add(double latDeg, double lonDeg) {
+        double la = toRad(latDeg);
+        double lo = toRad(lonDeg);
+        if (lat.empty()) {
+            minLat = maxLat = la;
+            minLon = maxLon = lo;
+        } else {
+            minLat = std::min(minLat, la);
+            maxLat = std::max(maxLat, la);
+            minLon = std::min(minLon, lo);
+            maxLon = std::max(maxLon, lo);
+        }
+        lat.push_back(la);
+        lon.push_back(lo);
+        cosLat.push_back(std::cos(la));
+    }
+
+    static GeoBatch of(const std::vector<GeoPoint>& points) {
+        GeoBatch batch;
+        batch.reserve(points.size());
+        for (const auto& p : points) batch.add(p.latitude, p.longitude);
+        return batch;
+    }
+};
+
+/**
+ * 小角度近似的适用范围 (弧度，约 6.4 km)：查询点到包围盒四边的纬度差、经度差都不超过它时，
+ * 用 sin x ≈ x、asin x ≈ x，相对误差约 c²/24 (c 为圆心角)，包围盒内 (≤ 9 km) < 1 mm。
+ */
+constexpr double SMALL_ANGLE_MAX_RAD = 1e-3;
+
+namespace detail {
+
+// ---- Two doubles per instruction (NEON / SSE2); plain double is the one-lane version ----
+
+#if defined(GEO_UTILS_NEON)
+struct F64x2 {
+    float64x2_t v;
+    F64x2(float64x2_t x) : v(x) {}
+    explicit F64x2(double x) : v(vdupq_n_f64(x)) {}
+    static F64x2 load(const double* p) { return vld1q_f64(p); }
+    void store(double* p) const { vst1q_f64(p, v); }
+};
+inline F64x2 operator+(F64x2 a, F64x2 b) { return vaddq_f64(a.v, b.v); }
+inline F64x2 operator-(F64x2 a, F64x2 b) { return vsubq_f64(a.v, b.v); }
+inline F64x2 operator*(F64x2 a, F64x2 b) { return vmulq_f64(a.v, b.v); }
+inline F64x2 vsqrt(F64x2 a) { return vsqrtq_f64(a.v); }
+inline F64x2 vmin(F64x2 a, F64x2 b) { return vminq_f64(a.v, b.v); }
+inline F64x2 vmax(F64x2 a, F64x2 b) { return vmaxq_f64(a.v, b.v); }
+inline F64x2 vround(F64x2 a) { return vrndnq_f64(a.v); }
+/** a > b ? x : y per lane */
+inline F64x2 vselectGt(F64x2 a, F64x2 b, F64x2 x, F64x2 y) { return vbslq_f64(vcgtq_f64(a.v, b.v), x.v, y.v); }
+#elif defined(GEO_UTILS_SSE2)
+struct F64x2 {
+    __m128d v;
+    F64x2(__m128d x) : v(x) {}
+    explicit F64x2(double x) : v(_mm_set1_pd(x)) {}
+    static F64x2 load(const double* p) { return _mm_loadu_pd(p); }
+    void store(double* p) const { _mm_storeu_pd(p, v); }
+};
+inline F64x2 operator+(F64x2 a, F64x2 b) { return _mm_add_pd(a.v, b.v); }
+inline F64x2 operator-(F64x2 a, F64x2 b) { return _mm_sub_pd(a.v, b.v); }
+inline F64x2 operator*(F64x2 a, F64x2 b) { return _mm_mul_pd(a.v, b.v); }
+inline F64x2 vsqrt(F64x2 a) { return _mm_sqrt_pd(a.v); }
+inline F64x2 vmin(F64x2 a, F64x2 b) { return _mm_min_pd(a.v, b.v); }
+inline F64x2 vmax(F64x2 a, F64x2 b) { return _mm_max_pd(a.v, b.v); }
+// Only used on |x| <= 2: the int32 round trip is exact (round-to-nearest MXCSR default)
+inline F64x2 vround(F64x2 a) { return _mm_cvtepi32_pd(_mm_cvtpd_epi32(a.v)); }
+inline F64x2 vselectGt(F64x2 a, F64x2 b, F64x2 x, F64x2 y) {
+    __m128d m = _mm_cmpgt_pd(a.v, b.v);
+    return _mm_or_pd(_mm_and_pd(m, x.v), _mm_andnot_pd(m, y.v));
+}
+#endif
+
+inline double vsqrt(double a) { return std::sqrt(a); }
+inline double vmin(double a, double b) { return std::min(a, b); }
+inline double vmax(double a, double b) { return std::max(a, b); }
+inline double vround(double a) { return std::nearbyint(a); }
+inline double vselectGt(double a, double b, double x, double y) { return a > b ? x : y; }
+
+/**
+ * sin(x) for |x| <= π/2: x + x³·P(x²), P interpolated at Chebyshev nodes of
+ * (sin x − x)/x³; |error| < 2.2e-16 (1 ulp). Near π/2 the haversine term is
+ * ill-conditioned (antipodal points), so the full double precision is kept.
+ */
+template <typename V>
+inline V sinPoly(V x) {
+    V z = x * x;
+    V p = V(2.73135110086169357e-15);
+    p = p * z + V(-7.64396207877050417e-13);
+    p = p * z + V(1.60589770304304620e-10);
+    p = p * z + V(-2.50521076122283627e-08);
+    p = p * z + V(2.75573192191222886e-06);
+    p = p * z + V(-1.98412698412548088e-04);
+    p = p * z + V(8.33333333333331587e-03);
+    p = p * z + V(-1.66666666666666657e-01);
+    return x + x * z * p;
+}
+
+/** asin(x) for 0 <= x <= 0.5: x + x³·Q(x²), fitted the same way; |error| < 9e-17 */
+template <typename V>
+inline V asinPoly(V x) {
+    V z = x * x;
+    V p = V(2.81692293243325231e-02);
+    p = p * z + V(-1.07490647192698772e-02);
+    p = p * z + V(1.60355218897072181e-02);
+    p = p * z + V(7.80294743329101176e-03);
+    p = p * z + V(1.18754946641791825e-02);
+    p = p * z + V(1.39296528921259571e-02);
+    p = p * z + V(1.73552599532606176e-02);
+    p = p * z + V(2.23720476321490162e-02);
+    p = p * z + V(3.03819473670729825e-02);
+    p = p * z + V(4.46428571034243882e-02);
+    p = p * z + V(7.50000000002076367e-02);
+    p = p * z + V(1.66666666666666491e-01);
+    return x + x * z * p;
+}
+
+/** Haversine term a = sin²(Δφ/2) + cosφ1·cosφ2·sin²(Δλ/2), radians; Δλ wrapped to [-π, π] */
+template <typename V>
+inline V haversineTerm(V lat1, V lon1, V cos1, V lat2, V lon2, V cos2) {
+    V dLon = lon2 - lon1;
+    dLon = dLon - V(2 * PI) * vround(dLon * V(0.5 / PI));
+    V s1 = sinPoly((lat2 - lat1) * V(0.5));
+    V s2 = sinPoly(dLon * V(0.5));
+    return vmin(vmax(s1 * s1 + cos1 * cos2 * s2 * s2, V(0.0)), V(1.0));
+}
+
+/** Central angle 2·asin(√a); above 0.5 via asin(s) = π/2 − 2·asin(√((1 − s)/2)) */
+template <typename V>
+inline V centralAngle(V a) {
+    V s = vsqrt(a);
+    V half = V(0.5);
+    V p = asinPoly(vselectGt(s, half, vsqrt((V(1.0) - s) * half), s));
+    return V(2.0) * vselectGt(s, half, V(PI / 2) - V(2.0) * p, p);
+}
+
+/** Small-angle central angle squared: Δφ² + cosφ1·cosφ2·Δλ² */
+template <typename V>
+inline V smallAngleSq(V lat1, V lon1, V cos1, V lat2, V lon2, V cos2) {
+    V dLat = lat2 - lat1;
+    V dLon = lon2 - lon1;
+    return dLat * dLat + cos1 * cos2 * dLon * dLon;
+}
+
+/** Query and batch all within SMALL_ANGLE_MAX_RAD of each other on both axes */
+inline bool smallSpread(double lat, double lon, const GeoBatch& batch) {
+    return std::max(lat - batch.minLat, batch.maxLat - lat) <= SMALL_ANGLE_MAX_RAD &&
+           std::max(lon - batch.minLon, batch.maxLon - lon) <= SMALL_ANGLE_MAX_RAD;
+}
+
+/**
+ * out[i] = central angle² (small spread) or haversine term a (otherwise) for
+ * points [begin, end); both grow monotonically with distance.
+ */
+inline void angleTerms(double lat, double lon, double cosLat, const GeoBatch& batch,
+                       bool small, size_t begin, size_t end, double* out) {
+    const double* la = batch.lat.data();
+    const double* lo = batch.lon.data();
+    const double* co = batch.cosLat.data();
+    size_t i = begin;
+#if defined(GEO_UTILS_NEON) || defined(GEO_UTILS_SSE2)
+    F64x2 qLat(lat), qLon(lon), qCos(cosLat);
+    for (; i + 2 <= end; i += 2) {
+        F64x2 pLat = F64x2::load(la + i), pLon = F64x2::load(lo + i), pCos = F64x2::load(co + i);
+        F64x2 t = small ? smallAngleSq(qLat, qLon, qCos, pLat, pLon, pCos)
+                        : haversineTerm(qLat, qLon, qCos, pLat, pLon, pCos);
+        t.store(out + (i - begin));
+    }
+#endif
+    for (; i < end; i++) {
+        out[i - begin] = small ? smallAngleSq(lat, lon, cosLat, la[i], lo[i], co[i])
+                               : haversineTerm(lat, lon, cosLat, la[i], lo[i], co[i]);
+    }
+}
+
+}  // namespace detail
+
+/**
+ * (lat, lon) 到 batch 每个点的距离 (米)，out 至少 batch.size() 个。
+ * 与精确 haversine 的差 < 1 µm (小角度路径 < 1 mm)；近对跖点时公式本身病态，
+ * 与 haversineDistance 一样只有厘米级。
+ */
+inline void haversineDistances(double lat, double lon, const GeoBatch& batch, double* out) {
+    double la = toRad(lat), lo = toRad(lon);
+    bool small = detail::smallSpread(la, lo, batch);
+    size_t n = batch.size();
+    detail::angleTerms(la, lo, std::cos(la), batch, small, 0, n, out);
+    size_t i = 0;
+    if (small) {
+#if defined(GEO_UTILS_NEON) || defined(GEO_UTILS_SSE2)
+        for (; i + 2 <= n; i += 2) {
+            (detail::F64x2(EARTH_RADIUS_METERS) * detail::vsqrt(detail::F64x2::load(out + i))).store(out + i);
+        }
+#endif
+        for (; i < n; i++) out[i] = EARTH_RADIUS_METERS * std::sqrt(out[i]);
+        return;
+    }
+#if defined(GEO_UTILS_NEON) || defined(GEO_UTILS_SSE2)
+    for (; i + 2 <= n; i += 2) {
+        (detail::F64x2(EARTH_RADIUS_METERS) * detail::centralAngle(detail::F64x2::load(out + i))).store(out + i);
+    }
+#endif
+    for (; i < n; i++) out[i] = EARTH_RADIUS_METERS * detail::centralAngle(out[i]);
+}
+
+/**
+ * batch 中与 (lat, lon) 距离 ≤ radiusMeters 的点下标 (升序，跳过 skip)，追加到 out。
+ * 比较在 haversine 项上做 (阈值 sin²(r/2R) 预先算好)，不需要 asin。
+ */
+inline void pointsWithin(double lat, double lon, const GeoBatch& batch, double radiusMeters,
+                         std::vector<size_t>& out, size_t skip = SIZE_MAX) {
+    double la = toRad(lat), lo = toRad(lon);
+    bool small = detail::smallSpread(la, lo, batch);
+    double angle = radiusMeters / EARTH_RADIUS_METERS;
+    double half = std::sin(std::min(angle, PI) / 2);
+    double limit = small ? angle * angle : half * half;
+    double cosLat = std::cos(la);
+    constexpr size_t CHUNK = 256;
+    double terms[CHUNK];
+    for (size_t begin = 0; begin < batch.size(); begin += CHUNK) {
+        size_t end = std::min(batch.size(), begin + CHUNK);
+        detail::angleTerms(la, lo, cosLat, batch, small, begin, end, terms);
+        for (size_t i = begin; i < end; i++) {
+            if (terms[i - begin] <= limit && i != skip) out.push_back(i);
+        }
+    }
+}
+
 /**
  * 检查点是否在围栏内
  */
@@ -109,13 +374,18 @@ inline std::vector<GeofenceMatch> getGeofencesAtLocation(
     
     std::vector<GeofenceMatch> result;
     result.reserve(geofences.size());
-    
-    for (const auto& gf : geofences) {
-        double dist = haversineDistance(lat, lon, gf.latitude, gf.longitude);
+
+    GeoBatch centers;
+    centers.reserve(geofences.size());
+    for (const auto& gf : geofences) centers.add(gf.latitude, gf.longitude);
+    std::vector<double> distances(geofences.size());
+    haversineDistances(lat, lon, centers, distances.data());
+
+    for (size_t i = 0; i < geofences.size(); i++) {
         result.push_back({
-            gf.id,
-            dist,
-            dist <= gf.radiusMeters
+            geofences[i].id,
+            distances[i],
+            distances[i] <= geofences[i].radiusMeters
         });
     }
     
@@ -152,12 +422,8 @@ inline double calculatePercentileRadius(
     
     if (points.empty()) return 100.0;  // 默认 100m
     
-    std::vector<double> distances;
-    distances.reserve(points.size());
-    
-    for (const auto& p : points) {
-        distances.push_back(haversineDistance(centerLat, centerLng, p.latitude, p.longitude));
-    }
+    std::vector<double> distances(points.size());
+    haversineDistances(centerLat, centerLng, GeoBatch::of(points), distances.data());
     
     std::sort(distances.begin(), distances.end());
     
@@ -27,9 +27,26 @@
  *   "cooldownMs": 3600000,
  *   "enabled": true
  * }
+ *
+ * Event frequency conditions take key "event:<eventType>" and value "windowMs,threshold":
+ *   {"key": "event:geofence_enter", "op": "countWithin", "value": "3600000,3"}  // ≥3 in the last hour
+ *   {"key": "event:app_open", "op": "rateWithin", "value": "600000,0.5"}       // ≥0.5/min over 10 min
+ * Counts come from 1 s / 1 min / 1 h buckets, so they may include events up to one
+ * bucket older than the window.
  */
 export const loadRules: (rulesJson: string) => boolean;
 
+/**
+ * Load a built-in rule pack compiled into the library at build time (no JSON
+ * parsing), replacing all rules. "default" is rawfile config/default_rules.json.
+ * @param name - Pack name
+ * @param userRulesJson - Optional JSON array of rules merged on top; a rule with
+ *   the same id replaces the pack rule
+ * @param removedIdsJson - Optional JSON array of rule ids to drop afterwards
+ * @returns false if no pack has that name
+ */
+export const loadRulePack: (name: string, userRulesJson?: string, removedIdsJson?: string) => boolean;
+
 /** Add or update a single rule (JSON string). Recompiles tree. */
 export const addRule: (ruleJson: string) => boolean;
 
@@ -40,18 +57,35 @@ export const removeRule: (ruleId: string) => boolean;
  * Evaluate current context against all rules.
  * @param contextJson - JSON object with key-value pairs, e.g.:
  *   {"timeOfDay":"morning","motionState":"walking","dayOfWeek":"1","geofence":"home"}
- * @param maxResults - Max number of results (default 5)
- * @returns JSON array of MatchResult:
+ * @param maxResults - Max number of results (default 5). Rules are scored highest
+ *   priority first; scoring stops once no remaining rule can enter the top results.
+ * @param budgetMs - Optional latency budget; when hit, the best results found so far
+ *   are returned (counted as budgetStops in getEvalStats)
+ * @returns JSON array of MatchResult sorted by confidence × priority:
  *   [{"ruleId":"...","confidence":0.85,"action":{"id":"...","type":"...","payload":"..."}}]
  */
-export const evaluate: (contextJson: string, maxResults?: number) => string;
+export const evaluate: (contextJson: string, maxResults?: number, budgetMs?: number) => string;
+
+/**
+ * Evaluate the data tray's current values without building a context JSON: the
+ * engine reads the libdata_tray.so tray in-process (import that module first,
+ * otherwise this throws). Every tray key is visible, typed as stored; missing
+ * required snapshot fields get the same defaults as getSnapshot().
+ * @param extraContextJson - Optional JSON object of keys the tray does not hold
+ *   (e.g. derived in ArkTS); they override tray keys of the same name
+ * @param useQuality - Scale each match by the value's effective tray quality
+ *   (TTL decay): a match on a quality-q value scores 0.5 + (match - 0.5) × q
+ * @returns Same JSON array as evaluate()
+ */
+export const evaluateFromTray: (maxResults?: number, extraContextJson?: string, useQuality?: boolean,
+  budgetMs?: number) => string;
 
 /**
  * Update MAB reward for an action (user feedback).
  * @param actionId - The action ID that was shown
  * @param reward - Reward value (0.0 = ignored, 0.5 = dismissed, 1.0 = accepted/used)
  */
-export const updateReward: (actionId: string, reward: number) => void;
+export const updateReward: (actionId: string, reward: number, contextJson?: string) => void;
 
 /**
  * MAB action selection from candidates.
@@ -63,11 +97,115 @@ export const selectAction: (actionIdsJson: string) => number;
 /** Get MAB statistics as JSON string */
 export const getStats: () => string;
 
-/** Load MAB statistics from JSON string */
-export const loadStats: (statsJson: string) => void;
+/** Load MAB statistics from JSON string (getStats format), returns the number of arms loaded */
+export const loadStats: (statsJson: string) => number;
 
 /** Get current rule count */
 export const getRuleCount: () => number;
 
 /** Export all rules as JSON string */
 export const exportRules: () => string;
+
+/**
+ * Rules of a built-in pack in exportRules() format, without loading them;
+ * "[]" if no pack has that name. Lets callers store only their changes to a pack.
+ */
+export const exportRulePack: (name: string) => string;
+
+/**
+ * Rebuild the decision tree from the collected traffic profile (value frequencies
+ * of evaluated contexts). Subsequent loadRules/addRule/removeRule stay profile-guided.
+ */
+export const recompileWithProfile: () => void;
+
+/** Export the traffic profile as JSON (persist and restore via importProfile) */
+export const exportProfile: () => string;
+
+/** Import a persisted traffic profile. Call recompileWithProfile() to apply it. */
+export const importProfile: (profileJson: string) => boolean;
+
+/**
+ * Get evaluation counters as JSON:
+ *   {"evaluations":N,"rulesEvaluated":M,"avgRulesPerEval":M/N,
+ *    "conditionsEvaluated":C,"avgCondsPerRule":C/M,"memoHits":H,
+ *    "sharedConditions":S,"reorders":R,"boundStops":B,"budgetStops":T,
+ *    "condsPerRuleBeforeReorder":x,"condsPerRuleAfterReorder":y}
+ * Identical conditions across rules are computed once per evaluate: C counts
+ * computations, H the uses served from the memo, S the distinct conditions.
+ * Before/after compare authoring order with adaptive condition ordering.
+ * B and T count evaluations ended early by branch-and-bound and by the time budget.
+ */
+export const getEvalStats: () => string;
+
+/**
+ * Select how candidate rules are found before soft matching:
+ *   "tree"   — compiled decision tree (default)
+ *   "bitmap" — per-value rule bitsets AND-ed across context keys; addRule
+ *              updates the index incrementally. Suited to tens of thousands of rules.
+ * @returns false for an unknown mode
+ */
+export const setEvalMode: (mode: string) => boolean;
+
+/** Current evaluation mode: "tree" or "bitmap" */
+export const getEvalMode: () => string;
+
+/**
+ * Milliseconds until evaluate(contextJson) could return a different result if the
+ * sensed context stays the same: clock keys (hour/minute/timeOfDay/dayOfWeek/isWeekend)
+ * crossing a rule threshold, recent/within windows expiring, countWithin/rateWithin
+ * counts falling below their threshold, cooldowns and rate
+ * limits lifting. Schedule the next evaluate then instead of polling; context
+ * changes and pushEvent still need an immediate evaluate.
+ * @returns delay in ms (0 = now), or -1 if nothing time-dependent is pending
+ */
+export const nextEvaluationDeadline: (contextJson: string) => number;
+
+/**
+ * Restore bandit (MAB, LinUCB) and per-rule cooldown state from the snapshot and
+ * write-ahead log in dir, then keep appending each updateReward and rule firing
+ * there (one small write instead of a full export). Call after loadRules.
+ * Files are <dir>/<name>.{snap,wal} (name defaults to "context_engine_state");
+ * engines sharing a dir must use different names.
+ * @returns records replayed (0 = no saved state), or -1 if the log cannot be
+ *          opened or is already held by another engine
+ */
+export const openStateLog: (dir: string, name?: string) => number;
+
+/** Snapshot the learning state and truncate the log (also done automatically) */
+export const compactStateLog: () => boolean;
+
+/**
+ * Independent engine instance with its own rules, rate limits, bandits and event
+ * buffer. The module-level functions above all share one default engine; create
+ * instances to shard workloads or run A/B rule sets side by side. Native memory is
+ * released when the instance is garbage-collected.
+ */
+export class ContextEngine {
+  constructor();
+  loadRules(rulesJson: string): boolean;
+  loadRulePack(name: string, userRulesJson?: string, removedIdsJson?: string): boolean;
+  addRule(ruleJson: string): boolean;
+  removeRule(ruleId: string): boolean;
+  evaluate(contextJson: string, maxResults?: number, budgetMs?: number): string;
+  evaluateFromTray(maxResults?: number, extraContextJson?: string, useQuality?: boolean, budgetMs?: number): string;
+  updateReward(actionId: string, reward: number, contextJson?: string): void;
+  selectAction(actionIdsJson: string, contextJson?: string): number;
+  getStats(): string;
+  loadStats(statsJson: string): number;
+  getRuleCount(): number;
+  exportRules(): string;
+  exportRulePack(name: string): string;
+  exportLinUCB(): string;
+  importLinUCB(json: string): void;
+  pushEvent(eventJson: string): void;
+  setLimits(limitsJson: string): void;
+  recompileWithProfile(): void;
+  exportProfile(): string;
+  importProfile(profileJson: string): boolean;
+  getEvalStats(): string;
+  setEvalMode(mode: string): boolean;
+  getEvalMode(): string;
+  nextEvaluationDeadline(contextJson: string): number;
+  openStateLog(dir: string, name?: string): number;
+  compactStateLog(): boolean;
+}
@@ -1,13 +1,63 @@
 export const put: (key: string, value: string, quality?: number, source?: string) => void;
-export const get: (key: string) => { value: string | null; quality: number; fresh: boolean; ageMs: number };
+/** Typed setters: the tray stores the value with its type; value/getSnapshot still read as strings */
+export const putNumber: (key: string, value: number, quality?: number, source?: string) => void;
+export const putInt: (key: string, value: number, quality?: number, source?: string) => void;
+export const putBool: (key: string, value: boolean, quality?: number, source?: string) => void;
+export const putEnum: (key: string, value: string, quality?: number, source?: string) => void;
+export const get: (key: string) => {
+  value: string | null; quality: number; fresh: boolean; ageMs: number;
+  type?: 'string' | 'double' | 'int' | 'bool' | 'enum'; typedValue?: string | number | boolean;
+};
+/** One crossing for a batch of writes; numbers are doubles unless type is 'int'. Returns entries written */
+export const putMany: (entries: Array<{
+  key: string; value: string | number | boolean; type?: 'string' | 'double' | 'int' | 'bool' | 'enum';
+  quality?: number; source?: string;
+}>) => number;
+/** One crossing for a batch of reads, keyed by key */
+export const getMany: (keys: string[]) => Record<string, {
+  value: string | null; quality: number; fresh: boolean; ageMs: number;
+  type?: 'string' | 'double' | 'int' | 'bool' | 'enum'; typedValue?: string | number | boolean;
+}>;
 export const getSnapshot: () => {
   timeOfDay: string; hour: string; dayOfWeek: string; isWeekend: string;
   motionState: string; batteryLevel: string; isCharging: string; networkType: string;
   geofence?: string; latitude?: string; longitude?: string; stepCount?: string;
 };
+/** Bumped by every put / setTTL / clear; equal values mean getSnapshot() is unchanged */
+export const getGeneration: () => number;
+/**
+ * Called on the JS thread with the keys whose value changed (or whose quality crossed the
+ * change threshold), coalesced over debounceMs (default 200). Re-putting a value is not a change.
+ */
+export const subscribe: (callback: (keys: string[]) => void, debounceMs?: number) => number;
+export const unsubscribe: (id: number) => void;
+/** Start the TTL timer wheel (resolution tickMs, default 1000); false if already running */
+export const enableExpiry: (tickMs?: number) => boolean;
+/**
+ * Called on the JS thread when a key outlives its TTL ('stale') or 2×TTL ('evicted', removed).
+ * Needs enableExpiry(); not debounced. Cancel with unsubscribe(id).
+ */
+export const subscribeExpiry: (callback: (events: Array<{ key: string; kind: 'stale' | 'evicted' }>) => void) => number;
+export const setChangeQualityThreshold: (threshold: number) => void;
+/**
+ * Compute hour / timeOfDay / dayOfWeek / isWeekend (local time) and wifiLostWork (from the
+ * per-category "wifiLost_work" marker) natively on read, memoized until the minute (or an
+ * input) changes; puts to these keys are overwritten.
+ */
+export const registerStandardDerived: () => void;
+/** Persist registered slots in an mmap'd file and restore them (once per process); returns restored count or -1 */
+export const openBacking: (path: string) => number;
+/** Keep a bounded numeric history for key; puts closer than minIntervalMs are averaged into one bucket */
+export const enableHistory: (key: string, capacity: number, minIntervalMs?: number) => void;
+export const disableHistory: (key: string) => void;
+/** Aggregate over the last windowMs; null if history is off or the window is empty */
+export const getAggregate: (key: string, windowMs: number) => {
+  count: number; min: number; max: number; mean: number; slopePerSec: number; spanMs: number; ageMs: number;
+} | null;
+export const getHistory: (key: string, windowMs: number) => Array<{ ageMs: number; value: number }>;
 export const setTTL: (key: string, ttlMs: number) => void;
 export const getStatus: () => Array<{
-  key: string; value: string; ageMs: number; ttlMs: number;
+  key: string; value: string; type: string; ageMs: number; ttlMs: number;
   fresh: boolean; effectiveQuality: number; source: string;
 }>;
 export const clear: () => void;